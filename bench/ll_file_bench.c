@@ -0,0 +1,128 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_file_bench.c compares the ways of getting a list of records back at startup:
+ * inserting them one at a time (a malloc per record, as they are parsed) against mapping
+ * back a file written by `ll_save()` with `ll_load_mmap()`, and then walking the mapped
+ * list once (which pages the records in). The file is also loaded as an unrolled list.
+ *
+ * usage: ll_file_bench [records, default 1000000]
+ *
+ * Prints CSV: `method,records,seconds,records_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ll.h"
+
+typedef struct {
+    long id;
+    double score;
+    char name[16];
+} record_t;
+
+static volatile long checksum;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t record_serialize(const void *val, void *buf, size_t size) {
+    if (size >= sizeof(record_t))
+        memcpy(buf, val, sizeof(record_t));
+    return sizeof(record_t);
+}
+
+static void record_sum(void *val) {
+    checksum += ((record_t *)val)->id;
+}
+
+static void report(const char *method, int n, double elapsed) {
+    printf("%s,%d,%.6f,%.0f\n", method, n, elapsed, n / elapsed);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    char path[] = "/tmp/ll_file_bench_XXXXXX";
+    int fd = mkstemp(path);
+    ll_opts_t opts = {0};
+    int i;
+
+    if (fd < 0)
+        return 1;
+    printf("method,records,seconds,records_per_sec\n");
+    opts.val_teardown = free;
+    ll_t *list = ll_new_ex(&opts);
+    double t0 = now();
+    for (i = 0; i < n; i++) {
+        record_t *r = malloc(sizeof(record_t));
+        r->id = i;
+        r->score = i / 2.0;
+        snprintf(r->name, sizeof(r->name), "r%d", i);
+        ll_insert_last(list, r);
+    }
+    report("insert", n, now() - t0);
+
+    t0 = now();
+    if (ll_save(list, fd, record_serialize) != n)
+        return 1;
+    fsync(fd);
+    report("save", n, now() - t0);
+    close(fd);
+    ll_delete(list);
+
+    opts.val_teardown = ll_no_teardown;
+    t0 = now();
+    list = ll_load_mmap(path, &opts);
+    if (list == NULL)
+        return 1;
+    report("load_mmap", n, now() - t0);
+
+    t0 = now();
+    ll_map(list, record_sum);
+    report("first_walk", n, now() - t0);
+
+    ll_delete(list);
+
+    opts.storage = LL_STORAGE_UNROLLED;
+    t0 = now();
+    list = ll_load_mmap(path, &opts);
+    if (list == NULL)
+        return 1;
+    report("load_mmap_unrolled", n, now() - t0);
+    ll_delete(list);
+    unlink(path);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_key_bench.c compares looking values up by key with `ll_find()` and a comparator
+ * (one indirect call per value) to `ll_find_key()` on a keyed unrolled list (see
+ * `ll_opts_t.key_of`), which compares the keys kept in the blocks several at a time. Hits
+ * are random keys of the list, misses keys it doesn't have.
+ *
+ * usage: ll_key_bench [values, default 4096] [lookups, default 4096]
+ *
+ * Prints CSV: `method,values,lookups,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int64_t int_key(const void *n) {
+    return *(const int *)n;
+}
+
+static int int_equals(const void *n, const void *ref) {
+    return *(const int *)n != *(const int *)ref;
+}
+
+static void report(const char *method, int n, int lookups, double elapsed) {
+    printf("%s,%d,%d,%.6f,%.0f\n", method, n, lookups, elapsed, lookups / elapsed);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 4096;
+    int lookups = argc > 2 ? atoi(argv[2]) : 4096;
+    int *vals = malloc(n * sizeof(int));
+    int *hits = malloc(lookups * sizeof(int));
+    ll_opts_t opts = {0};
+    unsigned seed = 1;
+    volatile int found = 0;
+    int i;
+
+    if (vals == NULL || hits == NULL)
+        return 1;
+    for (i = 0; i < n; i++)
+        vals[i] = i;
+    for (i = 0; i < lookups; i++)
+        hits[i] = rand_r(&seed) % n;
+    opts.val_teardown = ll_no_teardown;
+    opts.storage = LL_STORAGE_UNROLLED;
+    opts.pool_slab_nodes = 256;
+    opts.key_of = int_key;
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < n; i++)
+        ll_insert_last(list, &vals[i]);
+    printf("method,values,lookups,seconds,ops_per_sec\n");
+
+    double t0 = now();
+    for (i = 0; i < lookups; i++)
+        found += ll_find(list, int_equals, &hits[i]) != NULL;
+    report("find_hit", n, lookups, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < lookups; i++)
+        found += ll_find_key(list, hits[i]) != NULL;
+    report("find_key_hit", n, lookups, now() - t0);
+
+    int miss = n;
+    t0 = now();
+    for (i = 0; i < lookups; i++)
+        found += ll_find(list, int_equals, &miss) != NULL;
+    report("find_miss", n, lookups, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < lookups; i++)
+        found += ll_find_key(list, miss) != NULL;
+    report("find_key_miss", n, lookups, now() - t0);
+
+    ll_delete(list);
+    free(vals);
+    free(hits);
+
+    return found == 2 * lookups ? 0 : 1;
+}
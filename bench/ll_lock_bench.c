@@ -0,0 +1,114 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_lock_bench.c measures the lock backends of `ll_t` (see `ll_opts_t.lock_backend`)
+ * under contention: every thread alternates `ll_insert_first()` and `ll_pop_first()` on
+ * the same list, critical sections of a few pointer writes where the cost of the lock
+ * dominates. The total number of operations is the same for every thread count.
+ *
+ * usage: ll_lock_bench [pairs of operations, default 1048576] [max threads, default 16]
+ *
+ * Prints CSV: `backend,threads,ops,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+
+typedef struct {
+    ll_t *list;
+    long pairs;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+static const char *backends[] = {"rwlock", "ticket", "futex"};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    long i;
+
+    pthread_barrier_wait(w->start);
+    for (i = 0; i < w->pairs; i++) {
+        ll_insert_first(w->list, w);
+        ll_pop_first(w->list);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    long pairs = argc > 1 ? atol(argv[1]) : 1L << 20;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 16;
+    ll_opts_t opts = {0};
+    int backend, nthreads, i;
+
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.pool_slab_nodes = 1024;
+
+    printf("backend,threads,ops,seconds,ops_per_sec\n");
+    for (backend = LL_BACKEND_RWLOCK; backend <= LL_BACKEND_FUTEX; backend++) {
+        opts.lock_backend = (ll_lock_backend_t)backend;
+        for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+            pthread_t threads[nthreads];
+            worker_arg_t args[nthreads];
+            pthread_barrier_t start;
+            ll_t *list = ll_new_ex(&opts);
+
+            pthread_barrier_init(&start, NULL, nthreads + 1);
+            for (i = 0; i < nthreads; i++) {
+                args[i].list = list;
+                args[i].pairs = pairs / nthreads;
+                args[i].start = &start;
+                pthread_create(&threads[i], NULL, worker, &args[i]);
+            }
+            pthread_barrier_wait(&start);
+            double t0 = now();
+            for (i = 0; i < nthreads; i++)
+                pthread_join(threads[i], NULL);
+            double elapsed = now() - t0;
+
+            long ops = 2 * (pairs / nthreads) * nthreads;
+            printf("%s,%d,%ld,%.6f,%.0f\n", backends[backend], nthreads, ops, elapsed,
+                   ops / elapsed);
+            fflush(stdout);
+            pthread_barrier_destroy(&start);
+            ll_delete(list);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_mode_bench.c compares the memory footprint and the traversal speed of lists
+ * with hand-over-hand node locks (`LL_LOCK_NODES`) and lists with only the list lock and
+ * compact nodes (`LL_LOCK_LIST`), with and without a node pool.
+ *
+ * usage: ll_mode_bench [number of nodes, default 1000000]
+ *
+ * Prints CSV: `lock_mode,pool,nodes,bytes_per_node,insert_ns,find_ns_per_node,
+ * map_ns_per_node,get_n_ns_per_node`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "ll.h"
+
+#define POOL_SLAB_NODES 4096
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// bytes currently allocated from the heap, including what malloc mmaps directly
+static size_t heap_used(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+// makes `ll_find()` walk the whole list
+static int never_equal(const void *n, const void *ref) {
+    (void)n;
+    (void)ref;
+    return 1;
+}
+
+static void touch(void *n) {
+    (void)n;
+}
+
+int main(int argc, char **argv) {
+    long nodes = argc > 1 ? atol(argv[1]) : 1000000;
+    ll_lock_mode_t modes[] = {LL_LOCK_NODES, LL_LOCK_LIST};
+    const char *mode_names[] = {"nodes", "list"};
+    size_t pools[] = {0, POOL_SLAB_NODES};
+    size_t m, p;
+    long i;
+
+    printf("lock_mode,pool,nodes,bytes_per_node,insert_ns,find_ns_per_node,"
+           "map_ns_per_node,get_n_ns_per_node\n");
+    for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (p = 0; p < sizeof(pools) / sizeof(pools[0]); p++) {
+            ll_opts_t opts = {0};
+            opts.val_teardown = ll_no_teardown;
+            opts.lock_mode = modes[m];
+            opts.pool_slab_nodes = pools[p];
+
+            size_t before = heap_used();
+            ll_t *list = ll_new_ex(&opts);
+            double t0 = now();
+            for (i = 0; i < nodes; i++)
+                ll_insert_last(list, &nodes);
+            double insert = now() - t0;
+            size_t bytes = heap_used() - before;
+
+            t0 = now();
+            ll_find(list, never_equal, NULL);
+            double find = now() - t0;
+
+            t0 = now();
+            ll_map(list, touch);
+            double map = now() - t0;
+
+            t0 = now();
+            ll_get_n(list, nodes / 2);
+            double get_n = now() - t0;
+
+            printf("%s,%s,%ld,%.1f,%.1f,%.2f,%.2f,%.2f\n", mode_names[m],
+                   pools[p] ? "yes" : "no", nodes, (double)bytes / nodes, insert * 1e9 / nodes,
+                   find * 1e9 / nodes, map * 1e9 / nodes, get_n * 1e9 / (nodes / 2));
+            fflush(stdout);
+            ll_delete(list);
+        }
+    }
+
+    return 0;
+}
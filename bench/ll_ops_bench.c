@@ -0,0 +1,260 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_ops_bench.c measures the throughput and the latency distribution of the basic
+ * operations of `ll_t` under contention: `ll_insert_first()`, `ll_insert_last()`,
+ * `ll_pop_first()`, `ll_get_n()`, `ll_find()`, `ll_remove_find()` and `ll_map()`, plus
+ * `mixed`, where half the threads produce (`ll_insert_last()`) and the others consume
+ * (`ll_pop_first()`). Every operation runs on lists of 100 values and ten times more up to
+ * the maximum size, with 1 thread and twice more up to the maximum thread count. Every
+ * call is timed on its own; operations that walk the list run fewer times on long lists.
+ *
+ * usage: ll_ops_bench [max list size, default 10000] [max threads, default 4]
+ *                     [operations per thread, default 4096] [csv or json, default csv]
+ *
+ * Prints CSV: `op,size,threads,ops,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns`, or a JSON
+ * array of objects with the same keys.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+
+// the operations measured
+typedef enum {
+    OP_INSERT_FIRST,
+    OP_INSERT_LAST,
+    OP_POP_FIRST,
+    OP_GET_N,
+    OP_FIND,
+    OP_REMOVE_FIND,
+    OP_MAP,
+    OP_MIXED,
+    OP_COUNT
+} op_t;
+
+static const char *op_names[OP_COUNT] = {
+    "insert_first", "insert_last", "pop_first", "get_n", "find", "remove_find", "map",
+    "mixed",
+};
+
+// whether an operation walks the list, and is then run fewer times on long lists
+static const int op_walks[OP_COUNT] = {0, 0, 0, 1, 1, 1, 1, 0};
+
+typedef struct {
+    ll_t *list;
+    op_t op;
+    int idx;
+    int nthreads;
+    long ops;
+    long size;
+    unsigned seed;
+    long *lat;
+    long begin;
+    long end;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+// the values of the lists: `keys[i]` is `i`
+static int *keys;
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int int_equals(const void *n, const void *ref) {
+    return *(const int *)n != *(const int *)ref;
+}
+
+static void int_read(void *n) {
+    (void)*(volatile int *)n;
+}
+
+static int long_cmp(const void *a, const void *b) {
+    return (*(const long *)a > *(const long *)b) - (*(const long *)a < *(const long *)b);
+}
+
+static void *worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    long i;
+
+    pthread_barrier_wait(w->start);
+    w->begin = now_ns();
+    for (i = 0; i < w->ops; i++) {
+        int *key = &keys[rand_r(&w->seed) % w->size];
+        long t0 = now_ns();
+        switch (w->op) {
+        case OP_INSERT_FIRST:
+            ll_insert_first(w->list, key);
+            break;
+        case OP_INSERT_LAST:
+            ll_insert_last(w->list, key);
+            break;
+        case OP_POP_FIRST:
+            ll_pop_first(w->list);
+            break;
+        case OP_GET_N:
+            ll_get_n(w->list, *key);
+            break;
+        case OP_FIND:
+            ll_find(w->list, int_equals, key);
+            break;
+        case OP_REMOVE_FIND:
+            if (ll_remove_find(w->list, int_equals, key) >= 0) {
+                w->lat[i] = now_ns() - t0;
+                ll_insert_last(w->list, key); // the length stays the same, untimed
+                continue;
+            }
+            break;
+        case OP_MAP:
+            ll_map(w->list, int_read);
+            break;
+        default: // a lone thread produces and consumes in turn, others do either
+            if ((w->nthreads == 1 ? i : w->idx) % 2 == 0)
+                ll_insert_last(w->list, key);
+            else
+                ll_pop_first(w->list);
+            break;
+        }
+        w->lat[i] = now_ns() - t0;
+    }
+    w->end = now_ns();
+
+    return NULL;
+}
+
+// runs `op` on a list of `size` values with `nthreads` threads, and prints the results
+static int run(op_t op, long size, int nthreads, long ops, int json, int first) {
+    pthread_t threads[nthreads];
+    worker_arg_t args[nthreads];
+    pthread_barrier_t start;
+    ll_opts_t opts = {0};
+    long total, i;
+    int t;
+
+    if (op_walks[op]) {
+        ops = ops * 100 / size;
+        if (ops < 16)
+            ops = 16;
+    }
+    total = ops * nthreads;
+    long *lat = malloc(total * sizeof(long));
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = 4096;
+    ll_t *list = ll_new_ex(&opts);
+    if (lat == NULL || list == NULL)
+        return -1;
+    for (i = 0; i < size; i++)
+        ll_insert_last(list, &keys[i]);
+    if (op == OP_POP_FIRST || op == OP_MIXED) // never runs dry
+        for (i = 0; i < total; i++)
+            ll_insert_last(list, &keys[i % size]);
+
+    pthread_barrier_init(&start, NULL, nthreads + 1);
+    for (t = 0; t < nthreads; t++) {
+        args[t].list = list;
+        args[t].op = op;
+        args[t].idx = t;
+        args[t].nthreads = nthreads;
+        args[t].ops = ops;
+        args[t].size = size;
+        args[t].seed = (unsigned)t + 1;
+        args[t].lat = lat + t * ops;
+        args[t].start = &start;
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    pthread_barrier_wait(&start);
+    long begin = 0, end = 0;
+    for (t = 0; t < nthreads; t++) {
+        pthread_join(threads[t], NULL);
+        if (t == 0 || args[t].begin < begin)
+            begin = args[t].begin;
+        if (args[t].end > end)
+            end = args[t].end;
+    }
+    double elapsed = (end - begin) / 1e9;
+
+    qsort(lat, total, sizeof(long), long_cmp);
+    long p50 = lat[total / 2];
+    long p99 = lat[total * 99 / 100];
+    long p999 = lat[total * 999 / 1000];
+    if (json)
+        printf("%s  {\"op\": \"%s\", \"size\": %ld, \"threads\": %d, \"ops\": %ld, "
+               "\"seconds\": %.6f, \"ops_per_sec\": %.0f, \"p50_ns\": %ld, "
+               "\"p99_ns\": %ld, \"p999_ns\": %ld}",
+               first ? "" : ",\n", op_names[op], size, nthreads, total, elapsed,
+               total / elapsed, p50, p99, p999);
+    else
+        printf("%s,%ld,%d,%ld,%.6f,%.0f,%ld,%ld,%ld\n", op_names[op], size, nthreads, total,
+               elapsed, total / elapsed, p50, p99, p999);
+    fflush(stdout);
+
+    pthread_barrier_destroy(&start);
+    ll_delete(list);
+    free(lat);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long max_size = argc > 1 ? atol(argv[1]) : 10000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+    long ops = argc > 3 ? atol(argv[3]) : 4096;
+    int json = argc > 4 && strcmp(argv[4], "json") == 0;
+    int first = 1;
+    long size, i;
+    int op, nthreads;
+
+    if (max_size < 100 || max_threads < 1 || ops < 1)
+        return 1;
+    if ((keys = malloc(max_size * sizeof(int))) == NULL)
+        return 1;
+    for (i = 0; i < max_size; i++)
+        keys[i] = (int)i;
+
+    printf(json ? "[\n" : "op,size,threads,ops,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns\n");
+    for (size = 100; size <= max_size; size *= 10) {
+        for (op = 0; op < OP_COUNT; op++) {
+            for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+                if (run((op_t)op, size, nthreads, ops, json, first))
+                    return 1;
+                first = 0;
+            }
+        }
+    }
+    if (json)
+        printf("\n]\n");
+    free(keys);
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_prio_bench.c compares serving queued jobs most urgent first out of a list with
+ * priorities (`ll_insert_prio()` then `ll_pop_first()`, see `ll_opts_t.priorities`) to
+ * scanning a plain list for them (`ll_find()` per level, then `ll_remove_find()`), and a
+ * producer outrunning its consumer with an unbounded list to one sleeping in
+ * `ll_insert_last_wait()` on a bounded one (see `ll_opts_t.capacity`), whose length then
+ * never exceeds the capacity.
+ *
+ * usage: ll_prio_bench [jobs, default 4096] [levels, default 4] [capacity, default 64]
+ *
+ * Prints CSV: `method,jobs,param,seconds,ops_per_sec,max_len`, `param` being the number of
+ * levels or the capacity.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+
+typedef struct {
+    int level;
+    int id;
+} job_t;
+
+typedef struct {
+    ll_t *list;
+    int jobs;
+    volatile int sink;
+} consumer_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int level_equals(const void *job, const void *level) {
+    return ((const job_t *)job)->level != *(const int *)level;
+}
+
+static int same_job(const void *job, const void *ref) {
+    return job != ref;
+}
+
+static void report(const char *method, int jobs, int param, double elapsed, int max_len) {
+    printf("%s,%d,%d,%.6f,%.0f,%d\n", method, jobs, param, elapsed, jobs / elapsed,
+           max_len);
+    fflush(stdout);
+}
+
+// pops every job, working a little on each, slower than the producer
+static void *consumer(void *arg) {
+    consumer_t *c = (consumer_t *)arg;
+    int i, k;
+
+    for (i = 0; i < c->jobs; i++) {
+        job_t *job = (job_t *)ll_pop_first_wait(c->list, NULL);
+        for (k = 0; k < 2000; k++)
+            c->sink += job->id ^ k;
+    }
+
+    return NULL;
+}
+
+// produces all the jobs while a consumer drains the list, sampling its length
+static void produce(const char *method, job_t *jobs, int n, int capacity) {
+    ll_opts_t opts = {0};
+    consumer_t c;
+    pthread_t t;
+    int max_len = 0;
+    int i;
+
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.capacity = capacity;
+    c.list = ll_new_ex(&opts);
+    c.jobs = n;
+    c.sink = 0;
+
+    double t0 = now();
+    pthread_create(&t, NULL, consumer, &c);
+    for (i = 0; i < n; i++) {
+        int len = ll_insert_last_wait(c.list, &jobs[i], NULL);
+        if (len > max_len)
+            max_len = len;
+    }
+    pthread_join(t, NULL);
+    report(method, n, capacity, now() - t0, max_len);
+    ll_delete(c.list);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 4096;
+    int levels = argc > 2 ? atoi(argv[2]) : 4;
+    int capacity = argc > 3 ? atoi(argv[3]) : 64;
+    job_t *jobs = malloc(n * sizeof(job_t));
+    ll_opts_t opts = {0};
+    unsigned seed = 1;
+    int served = 0;
+    int i, l;
+
+    if (jobs == NULL || levels < 1)
+        return 1;
+    for (i = 0; i < n; i++) {
+        jobs[i].level = rand_r(&seed) % levels;
+        jobs[i].id = i;
+    }
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    printf("method,jobs,param,seconds,ops_per_sec,max_len\n");
+
+    ll_t *plain = ll_new_ex(&opts);
+    double t0 = now();
+    for (i = 0; i < n; i++)
+        ll_insert_last(plain, &jobs[i]);
+    for (i = 0; i < n; i++) {
+        job_t *job = NULL;
+        for (l = 0; l < levels && job == NULL; l++)
+            job = (job_t *)ll_find(plain, level_equals, &l);
+        ll_remove_find(plain, same_job, job);
+        served += job->level == l - 1;
+    }
+    report("scan_pop", n, levels, now() - t0, n);
+    ll_delete(plain);
+
+    opts.priorities = levels;
+    ll_t *prio = ll_new_ex(&opts);
+    t0 = now();
+    for (i = 0; i < n; i++)
+        ll_insert_prio(prio, &jobs[i], jobs[i].level);
+    int last = 0;
+    for (i = 0; i < n; i++) {
+        job_t *job = (job_t *)ll_pop_first(prio);
+        served += job->level >= last;
+        last = job->level;
+    }
+    report("prio_pop", n, levels, now() - t0, n);
+    ll_delete(prio);
+
+    produce("unbounded", jobs, n, 0);
+    produce("bounded", jobs, n, capacity);
+
+    free(jobs);
+
+    return served == 2 * n ? 0 : 1;
+}
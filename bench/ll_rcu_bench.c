@@ -0,0 +1,135 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_rcu_bench.c measures a read-mostly workload on the lock modes of `ll_t` (see
+ * `ll_opts_t.lock_mode`): every thread runs `ll_find()` on a list of a few hundred values,
+ * and one operation in twenty is an insertion or a removal instead. The total number of
+ * operations is the same for every thread count.
+ *
+ * usage: ll_rcu_bench [operations, default 1048576] [max threads, default 16]
+ *
+ * Prints CSV: `lock_mode,threads,ops,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+
+#define LIST_LEN 256
+
+// one write every `WRITE_EVERY` operations
+#define WRITE_EVERY 20
+
+typedef struct {
+    ll_t *list;
+    long ops;
+    unsigned seed;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+static int keys[LIST_LEN];
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int int_equals(const void *n, const void *ref) {
+    return *(const int *)n != *(const int *)ref;
+}
+
+static void *worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    long i;
+
+    pthread_barrier_wait(w->start);
+    for (i = 0; i < w->ops; i++) {
+        int *key = &keys[rand_r(&w->seed) % LIST_LEN];
+        if (i % WRITE_EVERY == 0) { // the length stays about the same
+            ll_remove_find(w->list, int_equals, key);
+            ll_insert_last(w->list, key);
+        } else {
+            ll_find(w->list, int_equals, key);
+        }
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    long ops = argc > 1 ? atol(argv[1]) : 1L << 20;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 16;
+    ll_lock_mode_t modes[] = {LL_LOCK_NODES, LL_LOCK_LIST, LL_LOCK_RCU};
+    const char *mode_names[] = {"nodes", "list", "rcu"};
+    size_t m;
+    int nthreads, i;
+
+    for (i = 0; i < LIST_LEN; i++)
+        keys[i] = i;
+    printf("lock_mode,threads,ops,seconds,ops_per_sec\n");
+    for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        ll_opts_t opts = {0};
+        opts.val_teardown = ll_no_teardown;
+        opts.lock_mode = modes[m];
+        opts.pool_slab_nodes = 1024;
+        for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+            pthread_t threads[nthreads];
+            worker_arg_t args[nthreads];
+            pthread_barrier_t start;
+            ll_t *list = ll_new_ex(&opts);
+
+            for (i = 0; i < LIST_LEN; i++)
+                ll_insert_last(list, &keys[i]);
+            pthread_barrier_init(&start, NULL, nthreads + 1);
+            for (i = 0; i < nthreads; i++) {
+                args[i].list = list;
+                args[i].ops = ops / nthreads;
+                args[i].seed = (unsigned)i + 1;
+                args[i].start = &start;
+                pthread_create(&threads[i], NULL, worker, &args[i]);
+            }
+            pthread_barrier_wait(&start);
+            double t0 = now();
+            for (i = 0; i < nthreads; i++)
+                pthread_join(threads[i], NULL);
+            double elapsed = now() - t0;
+
+            long total = (ops / nthreads) * nthreads;
+            printf("%s,%d,%ld,%.6f,%.0f\n", mode_names[m], nthreads, total, elapsed,
+                   total / elapsed);
+            fflush(stdout);
+            pthread_barrier_destroy(&start);
+            ll_delete(list);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_reset_bench.c measures how long emptying a list of malloc'ed values (torn down
+ * with `free()`) keeps the caller busy: `ll_clear()` then `ll_new_ex()` for a new list,
+ * `ll_reset()` tearing them down on the spot, and `ll_reset()` on a list with
+ * `async_teardown`, whose background thread gets the whole chain of nodes. Each is run
+ * with malloc'ed nodes and with a node pool.
+ *
+ * usage: ll_reset_bench [values, default 1000000] [pool_slab_nodes, default 4096]
+ *
+ * Prints CSV: `method,values,pool_slab_nodes,blocked_seconds,total_seconds`, the total
+ * including the time the background thread takes to catch up.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// fills a new list with `n` malloc'ed values. returns `NULL` if out of memory
+static ll_t *fill(ll_opts_t *opts, int n) {
+    ll_t *list = ll_new_ex(opts);
+    int i;
+
+    for (i = 0; list != NULL && i < n; i++) {
+        int *val = malloc(sizeof(int));
+        if (val == NULL)
+            return list;
+        *val = i;
+        ll_insert_last(list, val);
+    }
+
+    return list;
+}
+
+static void run(const char *method, int n, int slab, int async, int reset) {
+    ll_opts_t opts = {0};
+    opts.val_teardown = free;
+    opts.pool_slab_nodes = (size_t)slab;
+    opts.async_teardown = async;
+
+    ll_t *list = fill(&opts, n);
+    if (list == NULL)
+        return;
+    double t0 = now();
+    if (reset) {
+        ll_reset(list);
+    } else {
+        ll_clear(list);
+        ll_delete(list);
+        list = ll_new_ex(&opts);
+    }
+    double blocked = now() - t0;
+    ll_flush_teardowns(list);
+    printf("%s,%d,%d,%.6f,%.6f\n", method, n, slab, blocked, now() - t0);
+    fflush(stdout);
+    ll_delete(list);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int slab = argc > 2 ? atoi(argv[2]) : 4096;
+    int pooled;
+
+    printf("method,values,pool_slab_nodes,blocked_seconds,total_seconds\n");
+    for (pooled = 0; pooled < 2; pooled++) {
+        int s = pooled ? slab : 0;
+        run("clear_new", n, s, 0, 0);
+        run("reset", n, s, 0, 1);
+        run("reset_async", n, s, 1, 1);
+    }
+
+    return 0;
+}
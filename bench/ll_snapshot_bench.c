@@ -0,0 +1,139 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_snapshot_bench.c measures what full scans cost the writers of a list: a writer
+ * thread keeps inserting and removing values while the main thread scans the whole list
+ * a few times, with some work per value, either through `ll_map()` (under the lock of the
+ * list for the whole scan) or through `ll_snapshot()` and `ll_snapshot_map()` (locked for
+ * the copy only), on both lock modes with a list lock. The writer's throughput over the
+ * scans is measured, along with its longest operation: how long a scan held it up.
+ *
+ * usage: ll_snapshot_bench [values, default 100000] [scans, default 8]
+ *
+ * Prints CSV: `lock_mode,method,values,scans,scan_seconds,writer_ops_per_sec,max_stall_ms`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+
+typedef struct {
+    ll_t *list;
+    atomic_int stop;
+    atomic_long ops;
+    double max_stall;
+} writer_arg_t;
+
+static int *vals;
+static volatile unsigned long scanned;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// what an export or a metrics pass would do with every value, roughly
+static void scan_value(void *n) {
+    unsigned long h = (unsigned long)*(int *)n;
+    int i;
+
+    for (i = 0; i < 64; i++)
+        h = h * 31 + 7;
+    scanned += h & 1;
+}
+
+static void *writer(void *arg) {
+    writer_arg_t *w = (writer_arg_t *)arg;
+
+    while (!atomic_load(&w->stop)) { // the length stays the same
+        double t0 = now();
+        void *val = ll_pop_first(w->list);
+        ll_insert_last(w->list, val);
+        double t = now() - t0;
+        if (t > w->max_stall)
+            w->max_stall = t;
+        atomic_fetch_add_explicit(&w->ops, 2, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int scans = argc > 2 ? atoi(argv[2]) : 8;
+    ll_lock_mode_t modes[] = {LL_LOCK_NODES, LL_LOCK_LIST};
+    const char *mode_names[] = {"nodes", "list"};
+    const char *methods[] = {"map", "snapshot"};
+    int mode, m, i;
+
+    if ((vals = malloc(n * sizeof(int))) == NULL)
+        return 1;
+    for (i = 0; i < n; i++)
+        vals[i] = i;
+    printf("lock_mode,method,values,scans,scan_seconds,writer_ops_per_sec,max_stall_ms\n");
+    for (mode = 0; mode < 2; mode++) for (m = 0; m < 2; m++) {
+        ll_opts_t opts = {0};
+        writer_arg_t w = {0};
+        pthread_t thread;
+
+        opts.val_teardown = ll_no_teardown;
+        opts.lock_mode = modes[mode];
+        opts.pool_slab_nodes = 1024;
+        w.list = ll_new_ex(&opts);
+        for (i = 0; i < n; i++)
+            ll_insert_last(w.list, &vals[i]);
+        pthread_create(&thread, NULL, writer, &w);
+
+        long ops0 = atomic_load(&w.ops);
+        double t0 = now();
+        for (i = 0; i < scans; i++) {
+            if (m == 0) {
+                ll_map(w.list, scan_value);
+            } else {
+                ll_snapshot_t *snap = ll_snapshot(w.list);
+                ll_snapshot_map(snap, scan_value);
+                ll_snapshot_release(snap);
+            }
+        }
+        double elapsed = now() - t0;
+        long ops = atomic_load(&w.ops) - ops0;
+        atomic_store(&w.stop, 1);
+        pthread_join(thread, NULL);
+
+        printf("%s,%s,%d,%d,%.6f,%.0f,%.3f\n", mode_names[mode], methods[m], n, scans,
+               elapsed, ops / elapsed, w.max_stall * 1e3);
+        fflush(stdout);
+        ll_delete(w.list);
+    }
+    free(vals);
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_sorted_bench.c compares keeping a list sorted by hand (an iterator pass to
+ * find the position, then `ll_insert_n()`: two walks, two lock cycles) to a sorted list
+ * (see `ll_opts_t.order`) and `ll_insert_sorted()`, then searches for absent keys with
+ * `ll_find()` and `ll_find_sorted()`. Keys are random even numbers, the missing ones odd.
+ *
+ * usage: ll_sorted_bench [values, default 4096]
+ *
+ * Prints CSV: `method,values,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int int_order(const void *n, const void *m) {
+    return (*(const int *)n > *(const int *)m) - (*(const int *)n < *(const int *)m);
+}
+
+static int int_equals(const void *n, const void *ref) {
+    return *(const int *)n != *(const int *)ref;
+}
+
+// inserts `val` after the values that don't sort after it, the way callers did before
+static void insert_by_hand(ll_t *list, int *val) {
+    ll_iter_t it;
+    void *cur;
+    int pos = 0;
+
+    ll_iter_begin(list, &it, 0);
+    while (ll_iter_next(&it, &cur) && int_order(cur, val) <= 0)
+        pos++;
+    ll_iter_end(&it);
+    ll_insert_n(list, val, pos);
+}
+
+static void report(const char *method, int n, double elapsed) {
+    printf("%s,%d,%.6f,%.0f\n", method, n, elapsed, n / elapsed);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 4096;
+    int *keys = malloc(n * sizeof(int));
+    int *missing = malloc(n * sizeof(int));
+    ll_opts_t opts = {0};
+    unsigned seed = 1;
+    int i;
+
+    if (keys == NULL || missing == NULL)
+        return 1;
+    for (i = 0; i < n; i++) {
+        keys[i] = 2 * (rand_r(&seed) % n);
+        missing[i] = keys[i] + 1;
+    }
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = 1024;
+    printf("method,values,seconds,ops_per_sec\n");
+
+    ll_t *by_hand = ll_new_ex(&opts);
+    double t0 = now();
+    for (i = 0; i < n; i++)
+        insert_by_hand(by_hand, &keys[i]);
+    report("insert_by_hand", n, now() - t0);
+
+    opts.order = int_order;
+    ll_t *sorted = ll_new_ex(&opts);
+    t0 = now();
+    for (i = 0; i < n; i++)
+        ll_insert_sorted(sorted, &keys[i]);
+    report("insert_sorted", n, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < n; i++)
+        ll_find(sorted, int_equals, &missing[i]);
+    report("find_miss", n, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < n; i++)
+        ll_find_sorted(sorted, &missing[i]);
+    report("find_sorted_miss", n, now() - t0);
+
+    t0 = now();
+    ll_t *merged = ll_merge(sorted, sorted, &opts);
+    report("merge", 2 * n, now() - t0);
+
+    ll_delete(merged);
+    ll_delete(sorted);
+    ll_delete(by_hand);
+    free(keys);
+    free(missing);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_splice_bench.c measures handing batches of values from a producer list over to
+ * a consumer list: one value at a time (`ll_pop_first()` then `ll_insert_last()`), with
+ * `ll_splice()`, and with `ll_concat()` for whole lists. Both lists share a node pool
+ * (see `ll_split()`) so that their nodes can move between them.
+ *
+ * usage: ll_splice_bench [values, default 1048576] [batch, default 64]
+ *
+ * Prints CSV: `method,values,batch,seconds,values_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+
+// the values, all alike
+static int val;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// produces `n` values into `src`, `batch` at a time, each batch being handed over to `dst`
+// with `method`. returns the time spent handing them over
+static double hand_over(ll_t *dst, ll_t *src, long n, int batch, int method) {
+    double elapsed = 0;
+    long i;
+    int j;
+
+    for (i = 0; i < n; i += batch) {
+        for (j = 0; j < batch; j++)
+            ll_insert_last(src, &val);
+        double t0 = now();
+        if (method == 0) {
+            for (j = 0; j < batch; j++)
+                ll_insert_last(dst, ll_pop_first(src));
+        } else if (method == 1) {
+            ll_splice(dst, -1, src, 0, batch);
+        } else {
+            ll_concat(dst, src);
+        }
+        elapsed += now() - t0;
+        if (ll_length(dst) >= 1 << 16) { // the consumer keeps up
+            ll_t *done = ll_split(dst, 0);
+            ll_delete(done);
+        }
+    }
+
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1L << 20;
+    int batch = argc > 2 ? atoi(argv[2]) : 64;
+    const char *methods[] = {"pop_insert", "splice", "concat"};
+    ll_opts_t opts = {0};
+    int m;
+
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.pool_slab_nodes = 1024;
+    printf("method,values,batch,seconds,values_per_sec\n");
+    for (m = 0; m < 3; m++) {
+        ll_t *src = ll_new_ex(&opts);
+        ll_t *dst = ll_split(src, 0); // empty, sharing the pool of `src`
+        double elapsed = hand_over(dst, src, n, batch, m);
+        printf("%s,%ld,%d,%.6f,%.0f\n", methods[m], n, batch, elapsed, n / elapsed);
+        fflush(stdout);
+        ll_delete(dst);
+        ll_delete(src);
+    }
+
+    return 0;
+}
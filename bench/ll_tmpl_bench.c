@@ -0,0 +1,113 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_tmpl_bench.c compares an `ll_t` of `int` values (each one malloc'ed by the
+ * caller, compared and freed through function pointers) to a list of `int` values made
+ * by `LL_DEFINE()` (inline in the nodes, compared and torn down by inlined code): filling
+ * the list, searching it for absent values, and deleting it.
+ *
+ * usage: ll_tmpl_bench [values, default 4096] [searches, default 1024]
+ *
+ * Prints CSV: `method,values,ops,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+#include "ll_tmpl.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int int_equals(const void *n, const void *ref) {
+    return *(const int *)n != *(const int *)ref;
+}
+
+static inline int int_equals_inline(const int *n, const int *ref) {
+    return *n != *ref;
+}
+
+LL_DEFINE(ints, int, int_equals_inline, LL_TMPL_NO_TEARDOWN)
+
+static void report(const char *method, int n, int ops, double elapsed) {
+    printf("%s,%d,%d,%.6f,%.0f\n", method, n, ops, elapsed, ops / elapsed);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 4096;
+    int searches = argc > 2 ? atoi(argv[2]) : 1024;
+    ll_opts_t opts = {0};
+    int miss = -1;
+    volatile int found = 0;
+    int i;
+
+    opts.val_teardown = free;
+    opts.lock_mode = LL_LOCK_LIST;
+    printf("method,values,ops,seconds,ops_per_sec\n");
+
+    // both lists are built before either is freed, so that neither walks recycled memory
+    ll_t *list = ll_new_ex(&opts);
+    double t0 = now();
+    for (i = 0; i < n; i++) {
+        int *val = malloc(sizeof(int));
+        *val = i;
+        ll_insert_last(list, val);
+    }
+    report("ll_insert", n, n, now() - t0);
+
+    ints_t *ints = ints_new(LL_BACKEND_RWLOCK);
+    t0 = now();
+    for (i = 0; i < n; i++)
+        ints_insert_last(ints, i);
+    report("tmpl_insert", n, n, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < searches; i++)
+        found += ll_find(list, int_equals, &miss) != NULL;
+    report("ll_find_miss", n, searches, now() - t0);
+
+    t0 = now();
+    for (i = 0; i < searches; i++)
+        found += ints_find(ints, &miss, NULL) >= 0;
+    report("tmpl_find_miss", n, searches, now() - t0);
+
+    t0 = now();
+    ll_delete(list);
+    report("ll_delete", n, n, now() - t0);
+
+    t0 = now();
+    ints_delete(ints);
+    report("tmpl_delete", n, n, now() - t0);
+
+    return found;
+}
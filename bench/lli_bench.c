@@ -0,0 +1,120 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file lli_bench.c compares an intrusive list (`lli_t`) with `ll_t` lists holding the
+ * same structs through a node each (`LL_LOCK_LIST` mode, with and without a node pool):
+ * the time to insert them, and to walk them while reading a field of every struct.
+ *
+ * usage: lli_bench [number of structs, default 1000000]
+ *
+ * Prints CSV: `list,structs,insert_ns,find_ns_per_struct`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ll.h"
+#include "lli.h"
+
+typedef struct {
+    long key;
+    lli_link_t link;
+    char payload[40];
+} item_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// make the finds read every struct and walk the whole list
+static int item_never_equal(const void *item, const void *ref) {
+    return ((const item_t *)item)->key == *(const long *)ref ? 0 : 1;
+}
+
+static int link_never_equal(const void *link, const void *ref) {
+    return lli_entry(link, item_t, link)->key == *(const long *)ref ? 0 : 1;
+}
+
+static void print(const char *name, long n, double insert, double find) {
+    printf("%s,%ld,%.1f,%.2f\n", name, n, insert * 1e9 / n, find * 1e9 / n);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    item_t *items = (item_t *)calloc((size_t)n, sizeof(item_t));
+    size_t pools[] = {0, 4096};
+    long i, never = -1;
+    size_t p;
+
+    if (items == NULL)
+        return 1;
+    // the structs are shuffled in memory, like long lived objects end up being
+    for (i = 0; i < n; i++)
+        items[i].key = i;
+    srand(1);
+    for (i = n - 1; i > 0; i--) {
+        long j = rand() % (i + 1);
+        item_t tmp = items[i];
+        items[i] = items[j];
+        items[j] = tmp;
+    }
+
+    printf("list,structs,insert_ns,find_ns_per_struct\n");
+    for (p = 0; p < sizeof(pools) / sizeof(pools[0]); p++) {
+        ll_opts_t opts = {0};
+        opts.val_teardown = ll_no_teardown;
+        opts.lock_mode = LL_LOCK_LIST;
+        opts.pool_slab_nodes = pools[p];
+        ll_t *list = ll_new_ex(&opts);
+
+        double t0 = now();
+        for (i = 0; i < n; i++)
+            ll_insert_last(list, &items[i]);
+        double insert = now() - t0;
+        t0 = now();
+        ll_find(list, item_never_equal, &never);
+        print(pools[p] ? "ll_pool" : "ll", n, insert, now() - t0);
+        ll_delete(list);
+    }
+
+    lli_t *ilist = lli_new((gen_fun_t)ll_no_teardown, LL_BACKEND_RWLOCK);
+    double t0 = now();
+    for (i = 0; i < n; i++)
+        lli_insert_last(ilist, &items[i].link);
+    double insert = now() - t0;
+    t0 = now();
+    lli_find(ilist, link_never_equal, &never);
+    print("lli", n, insert, now() - t0);
+    lli_delete(ilist);
+    free(items);
+
+    return 0;
+}
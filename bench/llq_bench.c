@@ -0,0 +1,134 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file llq_bench.c measures how the throughput of a FIFO scales with the number of
+ * threads, comparing `ll_t` (`ll_insert_last()`/`ll_pop_first()` under the list lock) to
+ * the lock-free `llq_t`. Every thread alternates an insertion and a pop, the total number
+ * of operations being the same for every thread count.
+ *
+ * usage: llq_bench [pairs of operations, default 1048576] [max threads, default 64]
+ *
+ * Prints CSV: `queue,threads,ops,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+#include "llq.h"
+
+// a queue and the operations on it, so both kinds run through the same code
+typedef struct {
+    const char *name;
+    void *(*create)(void);
+    void (*destroy)(void *);
+    void (*push)(void *, void *);
+    void *(*pop)(void *);
+} queue_ops_t;
+
+typedef struct {
+    const queue_ops_t *ops;
+    void *q;
+    long pairs;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+static void *ll_create(void) { return ll_new(ll_no_teardown); }
+static void ll_destroy(void *q) { ll_delete((ll_t *)q); }
+static void ll_push(void *q, void *val) { ll_insert_last((ll_t *)q, val); }
+static void *ll_pop(void *q) { return ll_pop_first((ll_t *)q); }
+
+static void *llq_create(void) { return llq_new(ll_no_teardown); }
+static void llq_destroy(void *q) { llq_delete((llq_t *)q); }
+static void llq_push(void *q, void *val) { llq_insert_last((llq_t *)q, val); }
+static void *llq_pop(void *q) { return llq_pop_first((llq_t *)q); }
+
+static const queue_ops_t queues[] = {
+    {"ll", ll_create, ll_destroy, ll_push, ll_pop},
+    {"llq", llq_create, llq_destroy, llq_push, llq_pop},
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    long i;
+
+    pthread_barrier_wait(w->start);
+    for (i = 0; i < w->pairs; i++) {
+        w->ops->push(w->q, w);
+        w->ops->pop(w->q);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    long pairs = argc > 1 ? atol(argv[1]) : 1L << 20;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 64;
+    size_t k;
+    int nthreads, i;
+
+    printf("queue,threads,ops,seconds,ops_per_sec\n");
+    for (k = 0; k < sizeof(queues) / sizeof(queues[0]); k++) {
+        for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+            pthread_t threads[nthreads];
+            worker_arg_t args[nthreads];
+            pthread_barrier_t start;
+            void *q = queues[k].create();
+
+            pthread_barrier_init(&start, NULL, nthreads + 1);
+            for (i = 0; i < nthreads; i++) {
+                args[i].ops = &queues[k];
+                args[i].q = q;
+                args[i].pairs = pairs / nthreads;
+                args[i].start = &start;
+                pthread_create(&threads[i], NULL, worker, &args[i]);
+            }
+            pthread_barrier_wait(&start);
+            double t0 = now();
+            for (i = 0; i < nthreads; i++)
+                pthread_join(threads[i], NULL);
+            double elapsed = now() - t0;
+
+            long ops = 2 * (pairs / nthreads) * nthreads;
+            printf("%s,%d,%ld,%.6f,%.0f\n", queues[k].name, nthreads, ops, elapsed,
+                   ops / elapsed);
+            fflush(stdout);
+            pthread_barrier_destroy(&start);
+            queues[k].destroy(q);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file lls_bench.c measures how insertion throughput scales with the number of threads,
+ * comparing a single `ll_t` (every `ll_insert_last()` write locking the same list) to an
+ * `lls_t` with one shard per thread. The total number of insertions is the same for every
+ * thread count.
+ *
+ * usage: lls_bench [insertions, default 1048576] [max threads, default 64]
+ *
+ * Prints CSV: `container,threads,ops,seconds,ops_per_sec`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ll.h"
+#include "lls.h"
+
+typedef struct {
+    ll_t *list;
+    lls_t *sharded;
+    long inserts;
+    pthread_barrier_t *start;
+} worker_arg_t;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    long i;
+
+    pthread_barrier_wait(w->start);
+    for (i = 0; i < w->inserts; i++) {
+        if (w->sharded != NULL)
+            lls_insert(w->sharded, w);
+        else
+            ll_insert_last(w->list, w);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    long inserts = argc > 1 ? atol(argv[1]) : 1L << 20;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 64;
+    ll_opts_t opts = {0};
+    int sharded, nthreads, i;
+
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.pool_slab_nodes = 4096;
+
+    printf("container,threads,ops,seconds,ops_per_sec\n");
+    for (sharded = 0; sharded <= 1; sharded++) {
+        for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+            pthread_t threads[nthreads];
+            worker_arg_t args[nthreads];
+            pthread_barrier_t start;
+            ll_t *list = sharded ? NULL : ll_new_ex(&opts);
+            lls_t *s = sharded ? lls_new(&opts, nthreads, NULL) : NULL;
+
+            pthread_barrier_init(&start, NULL, nthreads + 1);
+            for (i = 0; i < nthreads; i++) {
+                args[i].list = list;
+                args[i].sharded = s;
+                args[i].inserts = inserts / nthreads;
+                args[i].start = &start;
+                pthread_create(&threads[i], NULL, worker, &args[i]);
+            }
+            pthread_barrier_wait(&start);
+            double t0 = now();
+            for (i = 0; i < nthreads; i++)
+                pthread_join(threads[i], NULL);
+            double elapsed = now() - t0;
+
+            long ops = (inserts / nthreads) * nthreads;
+            printf("%s,%d,%ld,%.6f,%.0f\n", sharded ? "lls" : "ll", nthreads, ops, elapsed,
+                   ops / elapsed);
+            fflush(stdout);
+            pthread_barrier_destroy(&start);
+            if (sharded)
+                lls_delete(s);
+            else
+                ll_delete(list);
+        }
+    }
+
+    return 0;
+}
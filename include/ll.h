@@ -33,8 +33,14 @@
 #ifndef LL_H
 #define LL_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <pthread.h>
 
+#include "ll_lock.h"
+
 /* type definitions */
 
 // useful for casting
@@ -43,27 +49,250 @@ typedef void (*gen_fun_t)(void *);
 // comparator : implementation should return "true" (0) if both values are considered as equal.
 typedef int (*comp_fun_t)(const void *, const void *);
 
+// hash function : values that the matching comparator considers equal must hash the same.
+typedef size_t (*hash_fun_t)(const void *);
+
+// order : implementation should return a negative number, 0 or a positive number when the
+// first value sorts before, with or after the second one (just like `qsort()` comparators).
+typedef int (*ord_fun_t)(const void *, const void *);
+
+// serializer : writes a value into the `size` bytes at `buf` if it fits there, and returns
+// the size of its serialized form either way (just like `snprintf()`), `SIZE_MAX` if it
+// can't be serialized. see `ll_save()`.
+typedef size_t (*ser_fun_t)(const void *val, void *buf, size_t size);
+
+// key : the integer key of a value, see `ll_opts_t.key_of`.
+typedef int64_t (*key_fun_t)(const void *);
+
 // linked list
 typedef struct ll ll_t;
 
 // linked list node
 typedef struct ll_node ll_node_t;
 
+// block of values of an unrolled linked list
+typedef struct ll_block ll_block_t;
+
+// a value of a doubly linked list, as handed out by the `ll_insert_*_handle()` functions
+// (see `ll_remove_handle()`). opaque
+typedef ll_node_t *ll_handle_t;
+
+// number of values in a block of an unrolled linked list
+#define LL_BLOCK_VALS 14
+
+// nodes (blocks, for unrolled lists) per slab of the pool of a list placed on a NUMA node
+// without `ll_opts_t.pool_slab_nodes`
+#define LL_NUMA_SLAB_NODES 256
+
 typedef enum {
     INVALID = 0,
     VALID = 1,
 } valid_flag_t;
 
+// how a linked list is locked, see `ll_opts_t`
+typedef enum {
+    // hand-over-hand node locks under the list lock, each node embedding a rwlock
+    LL_LOCK_NODES = 0,
+
+    // the list lock only, nodes being nothing but a value and a link. traversals keep the
+    // list locked from start to end (`ll_map()` write locks it, as its callback may alter
+    // the values)
+    LL_LOCK_LIST = 1,
+
+    // the list lock for writers only: `ll_find()`, `ll_get_n()`, `ll_get_first()` and
+    // `ll_map()` walk the list without taking any lock (nor writing anything shared), under
+    // an epoch guard. removed nodes are only freed, and their values torn down, once all
+    // the readers that could still see them are done (see `ll_synchronize()`). `ll_map()`
+    // callbacks must then leave the values alone, and not wait on other threads. node
+    // storage only, without indexes
+    LL_LOCK_RCU = 2,
+} ll_lock_mode_t;
+
+// how the values of a linked list are stored, see `ll_opts_t`
+typedef enum {
+    // a node per value
+    LL_STORAGE_NODES = 0,
+
+    // `LL_BLOCK_VALS` values per cache line aligned block (an unrolled linked list), which
+    // makes traversals mostly linear scans of memory. such lists only have the list lock,
+    // just like `LL_LOCK_LIST` ones (whatever `lock_mode` says)
+    LL_STORAGE_UNROLLED = 1,
+} ll_storage_t;
+
+// options for creating a linked list with `ll_new_ex()`.
+// zero-initialize them and set what is needed, so future options get their defaults
+typedef struct {
+    // a function that is called every time a value is deleted
+    // with a pointer to that value
+    gen_fun_t val_teardown;
+
+    // when non 0, nodes are drawn from a pool that allocates them this many at a time and
+    // keeps removed nodes (with their lock initialized) for reuse. blocks, for unrolled
+    // lists
+    size_t pool_slab_nodes;
+
+    // how the list and its nodes are locked
+    ll_lock_mode_t lock_mode;
+
+    // the kind of lock of the list itself (node locks are always rwlocks)
+    ll_lock_backend_t lock_backend;
+
+    // how the values are stored
+    ll_storage_t storage;
+
+    // when non 0, the list keeps an index of its nodes by position, so that `ll_get_n()`,
+    // `ll_insert_n()` and `ll_remove_n()` take O(log n) instead of walking the list. it
+    // costs about 32 bytes per node and O(log n) more work on every insertion and removal.
+    // node storage only, not in `LL_LOCK_RCU` mode
+    int pos_index;
+
+    // when non 0, removed values are torn down by a background thread of the list rather
+    // than under its lock: removals only queue them, so what `val_teardown` costs no longer
+    // holds other threads up. `ll_clear()` waits for the queue to drain, see also
+    // `ll_flush_teardowns()`. `ll_reset()` hands the thread all the nodes at once
+    int async_teardown;
+
+    // when non 0, nodes also link to the previous one (8 more bytes each), so that
+    // `ll_remove_handle()` unlinks them in constant time. node storage only, without
+    // `pos_index` (removing a node in O(1) would leave its position unknown)
+    int doubly_linked;
+
+    // when not `NULL`, the list is kept sorted by `order`: values go in through
+    // `ll_insert_sorted()` (positional insertions fail), and `ll_find_sorted()` gives up at
+    // the first value sorting after the one looked for. node storage only
+    ord_fun_t order;
+
+    // when not `NULL`, the key of every value is taken once, on insertion, and kept in the
+    // block next to it, so that `ll_find_key()` compares several keys per instruction
+    // rather than calling a comparator on every value. keys must not change while their
+    // values are in the list. blocks then take four cache lines. unrolled storage only
+    key_fun_t key_of;
+
+    // when non 0, insertions fail (with `errno` set to `ENOSPC`) rather than take the list
+    // past this many values, and `ll_insert_last_wait()` sleeps until there is room
+    int capacity;
+
+    // when non 0, the list has this many levels of priority, 0 being the most urgent: values
+    // go in through `ll_insert_prio()`, after those of their level but before those of less
+    // urgent ones, so that `ll_pop_first()` takes the oldest of the most urgent values in
+    // constant time. other insertions join the level of the value they go before (the least
+    // urgent one at the end). node storage only, neither sorted nor doubly linked
+    int priorities;
+
+    // when non 0, the slabs of the node pool are placed on NUMA node `numa_node`, which
+    // must be online (a preference, other nodes take over when it is full), so that the
+    // threads running there walk local memory. lists without `pool_slab_nodes` then get a
+    // pool of `LL_NUMA_SLAB_NODES` nodes per slab. `ll_stats()` counts the locks taken from
+    // other nodes
+    int numa_bind;
+    int numa_node;
+} ll_opts_t;
+
+// statistics of the node pool of a linked list, see `ll_pool_stats()`
+typedef struct {
+    // number of slabs allocated so far
+    size_t slabs;
+
+    // number of nodes in those slabs
+    size_t capacity;
+
+    // nodes currently linked in the list (or about to be)
+    size_t in_use;
+
+    // nodes waiting in the free list
+    size_t free;
+
+    // number of nodes handed out and given back since the list was created
+    unsigned long gets;
+    unsigned long puts;
+} ll_pool_stats_t;
+
+// instrumentation counters of a linked list, see `ll_stats()`. they count from the
+// creation of the list or its last `ll_stats_reset()`
+typedef struct {
+    // values inserted and removed (popped ones included), by any function
+    unsigned long inserts;
+    unsigned long removes;
+
+    // calls looking values up (`ll_get_n()`, `ll_find()` and their variants), and to
+    // `ll_map()`
+    unsigned long lookups;
+    unsigned long maps;
+
+    // acquisitions of the list lock
+    unsigned long read_locks;
+    unsigned long write_locks;
+
+    // time spent waiting for the list lock, and holding it exclusively
+    unsigned long lock_wait_ns;
+    unsigned long lock_hold_ns;
+
+    // walks of `ll_select_n_min_1()` and `ll_find()`, and the nodes they went through: the
+    // average walk is `walk_steps / walks` nodes long
+    unsigned long walks;
+    unsigned long walk_steps;
+
+    // nodes (blocks, for unrolled lists) allocated and released
+    unsigned long allocs;
+    unsigned long frees;
+
+    // acquisitions of the list lock by threads running on another NUMA node than the list
+    // (the one of `ll_opts_t.numa_node`, or the one it was created on), whose every access
+    // to the list then crosses sockets
+    unsigned long remote_locks;
+} ll_stats_t;
+
+// read-only view of the values of a linked list at some point, see `ll_snapshot()`. opaque
+typedef struct ll_snapshot ll_snapshot_t;
+
+// cursor over the values of a linked list, see `ll_iter_begin()`. its fields are private
+typedef struct {
+    // the list being iterated, locked from `ll_iter_begin()` to `ll_iter_end()`
+    ll_t *list;
+
+    // whether the list is write locked (values can be removed)
+    int write;
+
+    // the current node (locked, unless the list only has its own lock) and the one before.
+    // blocks, for unrolled lists
+    union {
+        ll_node_t *cur;
+        ll_block_t *blk;
+    };
+    union {
+        ll_node_t *prev;
+        ll_block_t *bprev;
+    };
+
+    // index of the current value in `blk`
+    int idx;
+
+    // position of the current value in the list
+    int pos;
+
+    // 0 before the first value, 1 on a value, 2 after removing it, 3 past the end
+    int state;
+} ll_iter_t;
+
 // linked list
 struct ll {
-    // running length
-    int len;
+    // running length, read without locking by `ll_length()`
+    atomic_int len;
+
+    // pointer to the first node (block, for unrolled lists)
+    union {
+        ll_node_t *hd;
+        ll_block_t *bhd;
+    };
 
-    // pointer to the first node
-    ll_node_t *hd;
+    // pointer to the last node (makes appending constant time)
+    union {
+        ll_node_t *tl;
+        ll_block_t *btl;
+    };
 
-    // mutex for thread safety
-    pthread_rwlock_t m;
+    // lock for thread safety, see `ll_opts_t.lock_backend`
+    ll_lock_t m;
 
     // a function that is called every time a value is deleted
     // with a pointer to that value
@@ -74,6 +303,84 @@ struct ll {
 
     // a flag that says if the list is valid
     valid_flag_t valid_flag;
+
+    // where the nodes come from, `NULL` when they are malloc'ed one by one
+    struct ll_pool *pool;
+
+    // the NUMA node the pool is placed on (see `ll_opts_t.numa_bind`), -1 if none
+    int numa_node;
+
+    // whether nodes have their own lock, set at creation
+    ll_lock_mode_t lock_mode;
+
+    // how the values are stored, set at creation
+    ll_storage_t storage;
+
+    // whether nodes link to the previous one, set at creation
+    int doubly_linked;
+
+    // the order of a sorted list (see `ll_opts_t.order`), `NULL` when it isn't sorted
+    ord_fun_t order;
+
+    // the keys of the values (see `ll_opts_t.key_of`), `NULL` when they have none
+    key_fun_t key_of;
+
+    // the nodes by position (see `ll_opts_t.pos_index`), `NULL` when there is none
+    struct ll_index *index;
+
+    // the nodes by value (see `ll_set_index()`), `NULL` when there is none
+    struct ll_hash *hash;
+
+    // the nodes removed but maybe still seen by readers, in `LL_LOCK_RCU` mode only
+    struct ll_epoch *epoch;
+
+    // the thread tearing down removed values (see `ll_opts_t.async_teardown`), `NULL` when
+    // they are torn down on the spot
+    struct ll_reclaimer *reclaimer;
+
+    // the instrumentation counters (see `ll_stats()`), `NULL` unless the library is built
+    // with `LL_STATS`
+    struct ll_counters *stats;
+
+    // the values removed while snapshots were taken (see `ll_snapshot()`), `NULL` until the
+    // first one is
+    struct ll_snapshots *snaps;
+
+    // the file the values were loaded from (see `ll_load_mmap()`), `NULL` if none
+    void *map;
+    size_t map_len;
+
+    // the most values the list takes (see `ll_opts_t.capacity`), 0 when it has no bound
+    int capacity;
+
+    // the levels of priority (see `ll_opts_t.priorities`), `NULL` when there are none
+    int priorities;
+    struct ll_level *levels;
+
+    // `ll_pop_first_wait()` sleeps on `nonempty`, and `ll_insert_last_wait()` on `notfull`,
+    // under `wait_m`
+    pthread_mutex_t wait_m;
+    pthread_cond_t nonempty;
+    pthread_cond_t notfull;
+
+    // number of threads in `ll_pop_first_wait()`, inserters only signal when it isn't 0
+    atomic_int waiters;
+
+    // number of threads in `ll_insert_last_wait()`, removers only signal when it isn't 0
+    atomic_int inserters;
+
+    // bumped (under `wait_m`) whenever sleepers should check the list again
+    unsigned long wait_seq;
+
+    // set by `ll_close()`: insertions fail, sleepers return once the list is empty
+    int closed;
+
+    // the readiness descriptor (see `ll_event_fd()`), -1 until it is asked for, whether the
+    // next insertion or removal is to write to it, and whether the next unlock is (a try
+    // function found the lock held, see `_ll_unlocking()`)
+    atomic_int event_fd;
+    atomic_int event_armed;
+    atomic_int event_contended;
 };
 
 /* function prototypes */
@@ -83,6 +390,10 @@ struct ll {
 // a pointer to the value when it is being deleted.
 ll_t *ll_new(gen_fun_t val_teardown);
 
+// returns a pointer to an allocated linked list configured by `opts` (see `ll_opts_t`).
+// returns `NULL` if the options are invalid or allocation fails
+ll_t *ll_new_ex(const ll_opts_t *opts);
+
 // traverses the linked list, deallocating everything (including `list`)
 void ll_delete(ll_t *list);
 
@@ -91,6 +402,13 @@ void ll_delete(ll_t *list);
 // Once all thread are canceled/joint
 void ll_clear(ll_t *list);
 
+// removes all the values, leaving the list valid and empty. with `async_teardown`, node
+// storage and not in `LL_LOCK_RCU` mode, this takes constant time: the whole chain of
+// nodes goes to the background thread, which tears the values down and frees the nodes.
+// other lists tear them down on the spot.
+// returns 0 if successful, -1 if the list is invalid
+int ll_reset(ll_t *list);
+
 
 // return list len (with a lock read),
 // or -1 if list is invalid.
@@ -109,6 +427,36 @@ int ll_insert_first(ll_t *list, void *val);
 // returns the new length of the linked list if successful, -1 otherwise
 int ll_insert_last(ll_t *list, void *val);
 
+// puts a value after the values of level `prio` of a list with priorities (see
+// `ll_opts_t.priorities`), in constant time.
+// returns the new length of the linked list if successful, -1 otherwise
+int ll_insert_prio(ll_t *list, void *val, int prio);
+
+// like `ll_insert_last()` and `ll_insert_prio()`, but sleeps while the list is full (see
+// `ll_opts_t.capacity`), until a value is removed, `deadline` (absolute time on
+// `CLOCK_MONOTONIC`, `NULL` for none) passes or the list is closed. returns -1 with `errno`
+// set to `ETIMEDOUT`, `EPIPE` (closed) or `EINVAL` (invalid list or level) when the value
+// couldn't be inserted
+int ll_insert_last_wait(ll_t *list, void *val, const struct timespec *deadline);
+int ll_insert_prio_wait(ll_t *list, void *val, int prio, const struct timespec *deadline);
+
+// like `ll_insert_n()`, `ll_insert_first()` and `ll_insert_last()`, storing a handle of
+// the value in `handle` for `ll_remove_handle()`. the list must be doubly linked (see
+// `ll_opts_t`). returns the new length of the linked list if successful, -1 otherwise
+int ll_insert_n_handle(ll_t *list, void *val, int n, ll_handle_t *handle);
+int ll_insert_first_handle(ll_t *list, void *val, ll_handle_t *handle);
+int ll_insert_last_handle(ll_t *list, void *val, ll_handle_t *handle);
+
+// removes the value of `handle` in constant time, whatever its position. the value must
+// still be in `list` (handles are worthless once their value is removed).
+// returns the new length of the linked list if successful, -1 otherwise
+int ll_remove_handle(ll_t *list, ll_handle_t handle);
+
+// inserts a value into a sorted list, after the values that don't sort after it, in a
+// single walk under a single lock of the list.
+// returns the new length of the linked list if successful, -1 otherwise
+int ll_insert_sorted(ll_t *list, void *val);
+
 // removes the value at position n of the linked list.
 // returns the new length of the linked list if successful, -1 otherwise
 int ll_remove_n(ll_t *list, int n);
@@ -135,9 +483,56 @@ void *ll_get_first(ll_t *list);
 void *ll_pop_first(ll_t *list);
 
 
-// runs f on all values of list
+// inserts the `n` values of `vals` at position `pos` (see `ll_insert_n()`, -1 appends them)
+// under a single lock of the list, `vals[0]` ending up first.
+// returns the number of values inserted if successful, -1 otherwise
+int ll_insert_many(ll_t *list, void **vals, size_t n, int pos);
+
+// removes up to `max` values from the front of the list under a single lock, storing them
+// in `out` (the caller takes their ownership).
+// returns the number of values popped, -1 if the list is invalid
+int ll_pop_many(ll_t *list, void **out, size_t max);
+
+// like `ll_pop_first()`, but sleeps while the list is empty, until a value is inserted,
+// `deadline` (absolute time on `CLOCK_MONOTONIC`, `NULL` for none) passes or the list is
+// closed. returns `NULL` with `errno` set to `ETIMEDOUT`, `EPIPE` (closed and empty) or
+// `EINVAL` (invalid list) when no value could be popped, and sets `errno` to 0 when one
+// was (which tells a popped `NULL` value apart)
+void *ll_pop_first_wait(ll_t *list, const struct timespec *deadline);
+
+// closes the list: further insertions fail (values already in can still be popped) and
+// all the threads sleeping in `ll_pop_first_wait()` and `ll_insert_last_wait()` are woken
+// up.
+// returns 0 if successful, -1 if the list is invalid
+int ll_close(ll_t *list);
+
+// non-blocking variants of `ll_insert_last()`, `ll_pop_first()` and `ll_pop_many()`, for
+// event loops: instead of waiting for the list lock, they fail with `errno` set to
+// `EAGAIN`. `ll_try_insert_last()` returns the new length, or -1 (`errno` is also set to
+// `ENOSPC` when the list is full, `EPIPE` when it is closed and `EINVAL` when it is invalid
+// or sorted). the pops return the number of values popped, 0 if the list is empty, -1 if
+// it is locked or invalid (`EINVAL`). they can still block briefly: on the mutex of the
+// threads sleeping in `ll_pop_first_wait()` and `ll_insert_last_wait()` when there are
+// any (to wake them up), and on the mutex of the node pool
+int ll_try_insert_last(ll_t *list, void *val);
+int ll_try_pop_first(ll_t *list, void **val);
+int ll_try_pop_many(ll_t *list, void **out, size_t max);
+
+// returns the readiness descriptor of the list (an eventfd, created on the first call and
+// closed with the list), -1 on failure. it becomes readable when the list may have changed
+// since a try function last failed on it: a value was inserted after a pop found it empty,
+// one was removed after an insertion found it full, it was closed, or the thread holding
+// its lock when a try function failed released it. it starts readable. event loops read it
+// (8 bytes) then retry until the try functions fail again
+int ll_event_fd(ll_t *list);
+
+// runs f on all values of list (which must only read them, in `LL_LOCK_RCU` mode)
 void ll_map(ll_t *list, gen_fun_t f);
 
+// like `ll_map()`, with `f` called by `nthreads` threads at once (the caller included) on
+// different parts of the list. `f` must then be thread-safe
+void ll_map_parallel(ll_t *list, gen_fun_t f, int nthreads);
+
 // goes through all the values of a linked list and calls `list->val_printer` on them
 void ll_print(ll_t list);
 
@@ -151,10 +546,133 @@ void ll_no_teardown(void *n);
 // returns a pointer to the value of first node that "matches" the given value, NULL otherwise
 void* ll_find(ll_t *list, comp_fun_t comparator, const void *ref_value);
 
+// like `ll_find()` on a sorted list, with its order: returns the first value that sorts
+// with `key`, giving up as soon as the values sort after it. `NULL` if there is none
+void *ll_find_sorted(ll_t *list, const void *key);
+
+// like `ll_find()` on a keyed list (see `ll_opts_t.key_of`): returns the first value whose
+// key is `key`, `NULL` if there is none (or the list has no keys)
+void *ll_find_key(ll_t *list, int64_t key);
+
+// creates a list with `opts` holding the values of the sorted lists `a` and `b` (which
+// are left untouched: the values are shared, mind `opts->val_teardown`), merged in
+// O(n + m). `a`, `b` and `opts` must have the same `order`. the lists are read locked
+// one after the other, each once. returns `NULL` if unsuccessful
+ll_t *ll_merge(ll_t *a, ll_t *b, const ll_opts_t *opts);
+
+// moves `count` values of `src`, from position `from` on, to position `pos` of `dst` (-1
+// appends them) by relinking their nodes, both lists being locked once (in an order that
+// can't deadlock). the lists must be distinct, have the same node layout (node storage,
+// same `lock_mode` and `doubly_linked`, not `LL_LOCK_RCU`) and either no node pool or the
+// same one (see `ll_split()`); `dst` mustn't be sorted. moved values are then torn down
+// by `dst`. returns the new length of `dst` if successful, -1 otherwise
+int ll_splice(ll_t *dst, int pos, ll_t *src, int from, int count);
+
+// moves all the values of `src` to the end of `dst` (see `ll_splice()`), in constant time
+// unless either list has an index. returns the new length of `dst` if successful, -1
+// otherwise
+int ll_concat(ll_t *dst, ll_t *src);
+
+// moves the values of `list` from position `n` on to a new list, made like `list` (the
+// hash index of `ll_set_index()` and the levels of priority aside) and sharing its node
+// pool. same restrictions as `ll_splice()`, but sorted lists can be split. returns `NULL`
+// if unsuccessful
+ll_t *ll_split(ll_t *list, int n);
+
 // More generic replacement for ll_remove_search().
 // Use comparator callback to check matches just like ll_find()
 // Returns the new length of the linked list if successful, -1 otherwise
 int ll_remove_find(ll_t *list, comp_fun_t comparator, const void *ref_value);
 
+// starts iterating over the values of the list, which stays locked (for reading, or for
+// writing if `write` is set) until `ll_iter_end()`. do not call other functions on the
+// list in the meantime. returns 0 if successful, -1 if the list is invalid
+int ll_iter_begin(ll_t *list, ll_iter_t *it, int write);
+
+// moves to the next value (the first one after `ll_iter_begin()`), storing it in `val`.
+// returns 1 if there was one, 0 at the end of the list
+int ll_iter_next(ll_iter_t *it, void **val);
+
+// removes the current value (calling the teardown function on it), the next call to
+// `ll_iter_next()` moving to the value that followed it. the iterator must be a `write` one.
+// returns the new length of the linked list if successful, -1 otherwise
+int ll_iter_remove(ll_iter_t *it);
+
+// stops iterating, unlocking the list
+void ll_iter_end(ll_iter_t *it);
+
+// copies the values of the list, in order, into a read-only view that is then read
+// without locking the list: writers are only held up by the copy (a walk with the read
+// lock), not by scans of the snapshot. values removed while snapshots are out are torn
+// down once the last of them is released. values popped (`ll_pop_first()`, `ll_pop_many()`,
+// `ll_pop_first_wait()` and their `try` forms) are handed to the caller instead: keeping
+// them alive while snapshots are out is the caller's job. snapshots must be released
+// before the list is cleared or deleted.
+// returns the snapshot, `NULL` if the list is invalid or out of memory
+ll_snapshot_t *ll_snapshot(ll_t *list);
+
+// returns the number of values in the snapshot
+int ll_snapshot_length(const ll_snapshot_t *snap);
+
+// returns the value at position `n` of the snapshot, `NULL` if out of range
+void *ll_snapshot_get_n(const ll_snapshot_t *snap, int n);
+
+// runs f on all the values of the snapshot, in order. the values are shared with the
+// list (and other snapshots): `f` must not alter them unless it synchronizes with them
+void ll_snapshot_map(const ll_snapshot_t *snap, gen_fun_t f);
+
+// releases a snapshot, tearing down the values removed from its list since the oldest
+// snapshot still out was taken if it is the last one
+void ll_snapshot_release(ll_snapshot_t *snap);
+
+// writes the values of the list to `fd` (from its current offset), as serialized by
+// `serialize`, in a format that `ll_load_mmap()` maps back. the list is only locked to take
+// a snapshot of it (see `ll_snapshot()`).
+// returns the number of values saved if successful, -1 otherwise (`errno` tells why)
+int ll_save(ll_t *list, int fd, ser_fun_t serialize);
+
+// makes a list created with `opts` out of a file written by `ll_save()`, linking a node (or
+// block slot) per value, so in O(n), but without reading the values in: they point into a
+// private mapping of the file, paged in as they are used, and unmapped when the list is
+// cleared. values can be written to (the file isn't) but never freed, so `val_teardown`
+// must leave them alone (values inserted later aren't mapped, of course). lists with node
+// storage get a node pool unless `opts` gives one. for a sorted list (`opts->order`), the
+// values are compared, so read in, and must already be in that order.
+// returns the new list on success, `NULL` otherwise (`errno` tells why, `EINVAL` for a file
+// that isn't one of `ll_save()` or isn't sorted)
+ll_t *ll_load_mmap(const char *path, const ll_opts_t *opts);
+
+// indexes the values of the list by `hash`, so that `ll_find()` and `ll_remove_find()`
+// called with `comparator` are O(1) on average instead of O(n). the index is kept up to
+// date by every insertion and removal. with several equal values, the one found is not
+// necessarily the first in the list. values must not change their hash while in the list.
+// `hash == NULL` drops the index. node storage only, not in `LL_LOCK_RCU` mode.
+// returns 0 if successful, -1 if the list is invalid, unrolled, RCU or out of memory
+int ll_set_index(ll_t *list, hash_fun_t hash, comp_fun_t comparator);
+
+// waits until the readers of an `LL_LOCK_RCU` list that may still see the values removed
+// so far are done, then tears them down and frees their nodes (removals otherwise do it
+// in batches). values popped out of such lists may be looked at by readers until then.
+// must not be called from an `ll_map()` callback.
+// returns 0 if successful (right away for other lists), -1 otherwise
+int ll_synchronize(ll_t *list);
+
+// waits until the values removed so far from a list with `async_teardown` are torn down,
+// helping the background thread with them.
+// returns 0 if successful (right away for other lists), -1 if the list is invalid
+int ll_flush_teardowns(ll_t *list);
+
+// fills `stats` with the state of the node pool of the list.
+// returns 0 if successful, -1 if the list is invalid or has no pool
+int ll_pool_stats(ll_t *list, ll_pool_stats_t *stats);
+
+// fills `stats` with the instrumentation counters of the list, without locking it.
+// returns 0 if successful, -1 if the library wasn't built with `LL_STATS`
+int ll_stats(ll_t *list, ll_stats_t *stats);
+
+// zeroes the instrumentation counters of the list.
+// returns 0 if successful, -1 if the library wasn't built with `LL_STATS`
+int ll_stats_reset(ll_t *list);
+
 // LL_H
 #endif
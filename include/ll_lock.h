@@ -0,0 +1,157 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_lock.h declares the locks a linked list can be protected by (see
+ * `ll_opts_t.lock_backend`). Taking and releasing them is inlined, only the contended
+ * paths live in `ll_lock.c`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_LOCK_H
+#define LL_LOCK_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+/* type definitions */
+
+// the kinds of lock protecting a list
+typedef enum {
+    // a pthread rwlock: readers share the list
+    LL_BACKEND_RWLOCK = 0,
+
+    // a ticket spinlock. exclusive (readers included) and served in arrival order, it is
+    // the cheapest when critical sections are a few pointer writes and there are no more
+    // threads than cores
+    LL_BACKEND_TICKET = 1,
+
+    // an adaptive mutex: spins for a while, then sleeps on a futex. exclusive
+    LL_BACKEND_FUTEX = 2,
+} ll_lock_backend_t;
+
+// ll_lock models a lock of one of the backends above
+typedef struct {
+    ll_lock_backend_t backend;
+
+    union {
+        pthread_rwlock_t rw;
+
+        // the ticket of the last arrived thread, and the one being served
+        struct {
+            atomic_uint next;
+            atomic_uint serving;
+        } ticket;
+
+        // 0 free, 1 locked, 2 locked with (maybe) sleepers
+        atomic_int futex;
+    };
+} ll_lock_t;
+
+/* function prototypes */
+
+// sets up an unlocked lock of the given backend.
+// returns 0 if successful, -1 if `backend` is unknown
+int ll_lock_init(ll_lock_t *lock, ll_lock_backend_t backend);
+
+// releases the resources of the lock, which must be unlocked
+void ll_lock_destroy(ll_lock_t *lock);
+
+// contended paths of `ll_lock_acquire()` and `ll_lock_release()`
+void ll_lock_ticket_wait(ll_lock_t *lock, unsigned int ticket);
+void ll_lock_futex_wait(ll_lock_t *lock);
+void ll_lock_futex_wake(ll_lock_t *lock);
+
+/* inline functions */
+
+// takes the lock, shared if `write` is 0 and the backend allows it
+static inline void ll_lock_acquire(ll_lock_t *lock, int write) {
+    unsigned int ticket;
+    int free_ = 0;
+
+    switch (lock->backend) {
+    case LL_BACKEND_TICKET:
+        ticket = atomic_fetch_add_explicit(&lock->ticket.next, 1, memory_order_relaxed);
+        if (atomic_load_explicit(&lock->ticket.serving, memory_order_acquire) != ticket)
+            ll_lock_ticket_wait(lock, ticket);
+        break;
+    case LL_BACKEND_FUTEX:
+        if (!atomic_compare_exchange_strong_explicit(&lock->futex, &free_, 1,
+                                                     memory_order_acquire,
+                                                     memory_order_relaxed))
+            ll_lock_futex_wait(lock);
+        break;
+    default:
+        if (write)
+            pthread_rwlock_wrlock(&lock->rw);
+        else
+            pthread_rwlock_rdlock(&lock->rw);
+    }
+}
+
+// takes the lock like `ll_lock_acquire()`, unless that means waiting for it.
+// returns 1 if the lock was taken, 0 if another thread holds it
+static inline int ll_lock_try_acquire(ll_lock_t *lock, int write) {
+    unsigned int serving;
+    int free_ = 0;
+
+    switch (lock->backend) {
+    case LL_BACKEND_TICKET:
+        // free when the next ticket is the one being served: take it, if nobody did
+        serving = atomic_load_explicit(&lock->ticket.serving, memory_order_acquire);
+        return atomic_compare_exchange_strong_explicit(&lock->ticket.next, &serving,
+                                                       serving + 1, memory_order_acquire,
+                                                       memory_order_relaxed);
+    case LL_BACKEND_FUTEX:
+        return atomic_compare_exchange_strong_explicit(&lock->futex, &free_, 1,
+                                                       memory_order_acquire,
+                                                       memory_order_relaxed);
+    default:
+        if (write)
+            return pthread_rwlock_trywrlock(&lock->rw) == 0;
+        return pthread_rwlock_tryrdlock(&lock->rw) == 0;
+    }
+}
+
+// releases the lock
+static inline void ll_lock_release(ll_lock_t *lock) {
+    unsigned int serving;
+
+    switch (lock->backend) {
+    case LL_BACKEND_TICKET:
+        serving = atomic_load_explicit(&lock->ticket.serving, memory_order_relaxed);
+        atomic_store_explicit(&lock->ticket.serving, serving + 1, memory_order_release);
+        break;
+    case LL_BACKEND_FUTEX:
+        if (atomic_fetch_sub_explicit(&lock->futex, 1, memory_order_release) != 1)
+            ll_lock_futex_wake(lock);
+        break;
+    default:
+        pthread_rwlock_unlock(&lock->rw);
+    }
+}
+
+// LL_LOCK_H
+#endif
@@ -0,0 +1,313 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_tmpl.h a header-only macro template generating linked lists of values of a
+ * given type, stored inline in their nodes, whose comparator and teardown are called
+ * directly (and so can be inlined) rather than through `comp_fun_t` and `gen_fun_t`
+ * pointers.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_TMPL_H
+#define LL_TMPL_H
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "ll.h"
+
+/* macros */
+
+// reading and updating the length of a generated list, see `LEN()` in `ll_internal.h`
+#define LL_TMPL_LEN(list) atomic_load_explicit(&(list)->len, memory_order_relaxed)
+#define LL_TMPL_LEN_SET(list, n) \
+    atomic_store_explicit(&(list)->len, (n), memory_order_release)
+
+// a teardown for values that own nothing, to pass to `LL_DEFINE()`
+#define LL_TMPL_NO_TEARDOWN(val) ((void)(val))
+
+// defines `name_t`, a linked list of `T` values, and its functions. values are copied in
+// and out of the nodes, which hold them inline. `cmp(const T *, const T *)` returns 0
+// when two values match (just like a `comp_fun_t`), `teardown(T *)` is called on every
+// value deleted: both are called by name, so they can be functions or macros, and get
+// inlined. the list is locked the way `LL_LOCK_LIST` lists are: a lock for the whole list
+// (`lock_backend`, see `ll_opts_t`), shared by readers when it is a rwlock. the functions
+// follow the `ll_*` API:
+//
+// name_t *name_new(ll_lock_backend_t lock_backend);    // `NULL` on failure
+// void name_delete(name_t *list);
+// void name_clear(name_t *list);                       // invalidates the list
+// int name_length(name_t *list);                       // -1 if invalid
+// int name_insert_n(name_t *list, T val, int n);       // new length, or -1
+// int name_insert_first(name_t *list, T val);
+// int name_insert_last(name_t *list, T val);
+// int name_remove_n(name_t *list, int n);              // new length, or -1
+// int name_remove_first(name_t *list);
+// int name_remove_find(name_t *list, const T *ref);
+// int name_pop_first(name_t *list, T *out);            // 0, -1 if empty
+// int name_get_n(name_t *list, int n, T *out);         // 0, -1 if out of range
+// int name_find(name_t *list, const T *ref, T *out);   // position, -1 if none
+// void name_map(name_t *list, void (*f)(T *));         // write locked, like `ll_map()`
+//
+// `out` receives a copy of the value (`name_find()` takes `NULL` when only the position
+// matters). values are torn down once unlinked, outside the lock of the list
+#define LL_DEFINE(name, T, cmp, teardown)                                                 \
+    typedef struct name##_node {                                                          \
+        struct name##_node *nxt;                                                          \
+        T val;                                                                            \
+    } name##_node_t;                                                                      \
+                                                                                          \
+    typedef struct {                                                                      \
+        atomic_int len;                                                                   \
+        name##_node_t *hd;                                                                \
+        name##_node_t *tl;                                                                \
+        ll_lock_t m;                                                                      \
+        valid_flag_t valid_flag;                                                          \
+    } name##_t;                                                                           \
+                                                                                          \
+    static inline name##_t *name##_new(ll_lock_backend_t lock_backend) {                  \
+        name##_t *list = (name##_t *)malloc(sizeof(name##_t));                            \
+        if (list == NULL)                                                                 \
+            return NULL;                                                                  \
+        if (ll_lock_init(&list->m, lock_backend)) {                                       \
+            free(list);                                                                   \
+            return NULL;                                                                  \
+        }                                                                                 \
+        atomic_init(&list->len, 0);                                                       \
+        list->hd = NULL;                                                                  \
+        list->tl = NULL;                                                                  \
+        list->valid_flag = VALID;                                                         \
+        return list;                                                                      \
+    }                                                                                     \
+                                                                                          \
+    /* unlinks and tears down every value, the list being write locked */                 \
+    static inline void name##_clear_locked(name##_t *list) {                              \
+        name##_node_t *node = list->hd;                                                   \
+        while (node != NULL) {                                                            \
+            name##_node_t *next = node->nxt;                                              \
+            teardown(&node->val);                                                         \
+            free(node);                                                                   \
+            node = next;                                                                  \
+        }                                                                                 \
+        list->hd = NULL;                                                                  \
+        list->tl = NULL;                                                                  \
+        LL_TMPL_LEN_SET(list, 0);                                                         \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_clear(name##_t *list) {                                     \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        name##_clear_locked(list);                                                        \
+        list->valid_flag = INVALID;                                                       \
+        ll_lock_release(&list->m);                                                        \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_delete(name##_t *list) {                                    \
+        name##_clear_locked(list);                                                        \
+        ll_lock_destroy(&list->m);                                                        \
+        free(list);                                                                       \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_length(name##_t *list) {                                     \
+        return list->valid_flag == VALID ? LL_TMPL_LEN(list) : -1;                        \
+    }                                                                                     \
+                                                                                          \
+    /* the node at position `n - 1`, the predecessor of position `n`; `n` must be in      \
+       1..length and the list locked (callers handle 0 themselves) */                     \
+    static inline name##_node_t *name##_before(name##_t *list, int n) {                   \
+        name##_node_t *node = list->hd;                                                   \
+        if (n == LL_TMPL_LEN(list))                                                       \
+            return list->tl;                                                              \
+        while (--n > 0)                                                                   \
+            node = node->nxt;                                                             \
+        return node;                                                                      \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_insert_n(name##_t *list, T val, int n) {                     \
+        name##_node_t *node = (name##_node_t *)malloc(sizeof(name##_node_t));             \
+        name##_node_t *prev;                                                              \
+        int len;                                                                          \
+        if (node == NULL)                                                                 \
+            return -1;                                                                    \
+        node->val = val;                                                                  \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        len = LL_TMPL_LEN(list);                                                          \
+        if (list->valid_flag != VALID || n < 0 || n > len) {                              \
+            ll_lock_release(&list->m);                                                    \
+            free(node);                                                                   \
+            return -1;                                                                    \
+        }                                                                                 \
+        prev = n == 0 ? NULL : name##_before(list, n);                                    \
+        node->nxt = prev == NULL ? list->hd : prev->nxt;                                  \
+        if (prev == NULL)                                                                 \
+            list->hd = node;                                                              \
+        else                                                                              \
+            prev->nxt = node;                                                             \
+        if (node->nxt == NULL)                                                            \
+            list->tl = node;                                                              \
+        LL_TMPL_LEN_SET(list, ++len);                                                     \
+        ll_lock_release(&list->m);                                                        \
+        return len;                                                                       \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_insert_first(name##_t *list, T val) {                        \
+        return name##_insert_n(list, val, 0);                                             \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_insert_last(name##_t *list, T val) {                         \
+        name##_node_t *node = (name##_node_t *)malloc(sizeof(name##_node_t));             \
+        int len;                                                                          \
+        if (node == NULL)                                                                 \
+            return -1;                                                                    \
+        node->val = val;                                                                  \
+        node->nxt = NULL;                                                                 \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        if (list->valid_flag != VALID) {                                                  \
+            ll_lock_release(&list->m);                                                    \
+            free(node);                                                                   \
+            return -1;                                                                    \
+        }                                                                                 \
+        if (list->tl == NULL)                                                             \
+            list->hd = node;                                                              \
+        else                                                                              \
+            list->tl->nxt = node;                                                         \
+        list->tl = node;                                                                  \
+        len = LL_TMPL_LEN(list) + 1;                                                      \
+        LL_TMPL_LEN_SET(list, len);                                                       \
+        ll_lock_release(&list->m);                                                        \
+        return len;                                                                       \
+    }                                                                                     \
+                                                                                          \
+    /* unlinks the node after `prev` (the head for `NULL`), under the write lock */       \
+    static inline name##_node_t *name##_unlink_after(name##_t *list,                      \
+                                                     name##_node_t *prev) {               \
+        name##_node_t *node = prev == NULL ? list->hd : prev->nxt;                        \
+        if (prev == NULL)                                                                 \
+            list->hd = node->nxt;                                                         \
+        else                                                                              \
+            prev->nxt = node->nxt;                                                        \
+        if (list->tl == node)                                                             \
+            list->tl = prev;                                                              \
+        LL_TMPL_LEN_SET(list, LL_TMPL_LEN(list) - 1);                                     \
+        return node;                                                                      \
+    }                                                                                     \
+                                                                                          \
+    /* unlinks the value at position `n`, copying it to `out` or tearing it down          \
+     * (outside the lock) when `out` is `NULL` */                                         \
+    static inline int name##_take_n(name##_t *list, int n, T *out) {                      \
+        name##_node_t *node;                                                              \
+        int len;                                                                          \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        if (list->valid_flag != VALID || n < 0 || n >= LL_TMPL_LEN(list)) {               \
+            ll_lock_release(&list->m);                                                    \
+            return -1;                                                                    \
+        }                                                                                 \
+        node = name##_unlink_after(list, n == 0 ? NULL : name##_before(list, n));         \
+        len = LL_TMPL_LEN(list);                                                          \
+        ll_lock_release(&list->m);                                                        \
+        if (out != NULL)                                                                  \
+            *out = node->val;                                                             \
+        else                                                                              \
+            teardown(&node->val);                                                         \
+        free(node);                                                                       \
+        return len;                                                                       \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_remove_n(name##_t *list, int n) {                            \
+        return name##_take_n(list, n, NULL);                                              \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_remove_first(name##_t *list) {                               \
+        return name##_take_n(list, 0, NULL);                                              \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_pop_first(name##_t *list, T *out) {                          \
+        return name##_take_n(list, 0, out) < 0 ? -1 : 0;                                  \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_remove_find(name##_t *list, const T *ref) {                  \
+        name##_node_t *prev = NULL;                                                       \
+        name##_node_t *node;                                                              \
+        int len;                                                                          \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        if (list->valid_flag != VALID) {                                                  \
+            ll_lock_release(&list->m);                                                    \
+            return -1;                                                                    \
+        }                                                                                 \
+        for (node = list->hd; node != NULL && cmp(&node->val, ref) != 0;                  \
+             node = node->nxt)                                                            \
+            prev = node;                                                                  \
+        if (node != NULL)                                                                 \
+            name##_unlink_after(list, prev);                                              \
+        len = LL_TMPL_LEN(list);                                                          \
+        ll_lock_release(&list->m);                                                        \
+        if (node == NULL)                                                                 \
+            return -1;                                                                    \
+        teardown(&node->val);                                                             \
+        free(node);                                                                       \
+        return len;                                                                       \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_get_n(name##_t *list, int n, T *out) {                       \
+        name##_node_t *node;                                                              \
+        ll_lock_acquire(&list->m, 0);                                                     \
+        if (list->valid_flag != VALID || n < 0 || n >= LL_TMPL_LEN(list)) {               \
+            ll_lock_release(&list->m);                                                    \
+            return -1;                                                                    \
+        }                                                                                 \
+        node = n == 0 ? list->hd : name##_before(list, n)->nxt;                           \
+        *out = node->val;                                                                 \
+        ll_lock_release(&list->m);                                                        \
+        return 0;                                                                         \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_find(name##_t *list, const T *ref, T *out) {                 \
+        name##_node_t *node;                                                              \
+        int pos = 0;                                                                      \
+        ll_lock_acquire(&list->m, 0);                                                     \
+        if (list->valid_flag != VALID) {                                                  \
+            ll_lock_release(&list->m);                                                    \
+            return -1;                                                                    \
+        }                                                                                 \
+        for (node = list->hd; node != NULL && cmp(&node->val, ref) != 0;                  \
+             node = node->nxt)                                                            \
+            pos++;                                                                        \
+        if (node != NULL && out != NULL)                                                  \
+            *out = node->val;                                                             \
+        ll_lock_release(&list->m);                                                        \
+        return node == NULL ? -1 : pos;                                                   \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_map(name##_t *list, void (*f)(T *)) {                       \
+        name##_node_t *node;                                                              \
+        ll_lock_acquire(&list->m, 1);                                                     \
+        if (list->valid_flag == VALID)                                                    \
+            for (node = list->hd; node != NULL; node = node->nxt)                         \
+                f(&node->val);                                                            \
+        ll_lock_release(&list->m);                                                        \
+    }
+
+// LL_TMPL_H
+#endif
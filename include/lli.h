@@ -0,0 +1,121 @@
+/**
+ * Intrusive linked-list for C.
+ *
+ * See `../README.md` and `main()` in `../src/lli.c` for usage.
+ *
+ * @file lli.h outlines the API of `lli_t`, a thread-safe list of the caller's own structs,
+ * linked through an `lli_link_t` embedded in them (in the style of the `list_head` of
+ * Linux): inserting needs no allocation, and walking the list touches the structs only.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LLI_H
+#define LLI_H
+
+#include <stddef.h>
+
+#include "ll.h"
+
+/* type definitions */
+
+// the link to embed in a struct to put it in an `lli_t` (in one at a time). it must be
+// zero-initialized: links that aren't in a list have a `NULL` `nxt`, which insertions
+// check
+typedef struct lli_link {
+    struct lli_link *nxt;
+    struct lli_link *prv;
+} lli_link_t;
+
+// intrusive linked list
+typedef struct lli lli_t;
+
+/* macros */
+
+// returns a pointer to the struct of type `type` that embeds `link` as its `member`
+#define lli_entry(link, type, member) \
+                   ((type *)((char *)(link) - offsetof(type, member)))
+
+/* function prototypes */
+
+// returns a pointer to an allocated intrusive list, whose lock is a `lock_backend` (see
+// `ll_opts_t`), `NULL` on failure. `link_teardown` is called with the link of every struct
+// removed from the list (and not handed back to the caller), the links of comparators and
+// `lli_map()` callbacks to be turned into their structs with `lli_entry()` as well
+lli_t *lli_new(gen_fun_t link_teardown, ll_lock_backend_t lock_backend);
+
+// unlinks and tears down every struct, then deallocates `list`
+void lli_delete(lli_t *list);
+
+// unlinks and tears down every struct, invalidating the list (no further operation on it
+// will succeed). no other thread may be using it anymore
+void lli_clear(lli_t *list);
+
+// returns the number of structs in the list without locking it, -1 if it is invalid
+int lli_length(lli_t *list);
+
+// links a struct at position `n` (`0` to the length of the list).
+// returns the new length of the list if successful, -1 otherwise (`link` already being in
+// a list included)
+int lli_insert_n(lli_t *list, lli_link_t *link, int n);
+
+// links a struct at the front of the list.
+// returns the new length of the list if successful, -1 otherwise
+int lli_insert_first(lli_t *list, lli_link_t *link);
+
+// links a struct at the end of the list.
+// returns the new length of the list if successful, -1 otherwise
+int lli_insert_last(lli_t *list, lli_link_t *link);
+
+// unlinks a struct from the list it is in, which must be `list`, in constant time. it is
+// not torn down.
+// returns the new length of the list if successful, -1 otherwise
+int lli_unlink(lli_t *list, lli_link_t *link);
+
+// unlinks and tears down the struct at position `n`.
+// returns the new length of the list if successful, -1 otherwise
+int lli_remove_n(lli_t *list, int n);
+
+// unlinks and tears down the first struct that `comparator` matches to `ref_value` (see
+// `ll_find()`).
+// returns the new length of the list if successful, -1 otherwise
+int lli_remove_find(lli_t *list, comp_fun_t comparator, const void *ref_value);
+
+// returns the link of the struct at position `n`, `NULL` if there is none
+lli_link_t *lli_get_n(lli_t *list, int n);
+
+// unlinks the first struct and returns its link (the caller takes it back), `NULL` if the
+// list is empty
+lli_link_t *lli_pop_first(lli_t *list);
+
+// returns the link of the first struct that `comparator` matches to `ref_value`, `NULL`
+// if none
+lli_link_t *lli_find(lli_t *list, comp_fun_t comparator, const void *ref_value);
+
+// runs f on the links of all the structs, in order
+void lli_map(lli_t *list, gen_fun_t f);
+
+// LLI_H
+#endif
@@ -0,0 +1,69 @@
+/**
+ * Lock-free FIFO queue for C.
+ *
+ * See `../README.md` and `main()` in `llq.c` for usage.
+ *
+ * @file llq.h contains the API of the lock-free queue. It stores `void *` values just like
+ * `ll_t`, but only supports appending and popping the first value, which it does without
+ * any lock (Michael & Scott's algorithm, nodes being reclaimed with hazard pointers).
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LLQ_H
+#define LLQ_H
+
+#include "ll.h"
+
+/* type definitions */
+
+// lock-free queue, opaque as there is nothing the user could lock
+typedef struct llq llq_t;
+
+/* function prototypes */
+
+// returns a pointer to an allocated queue, `NULL` if out of memory.
+// needs a teardown function that is called with a pointer to each value still queued
+// when the queue is deleted.
+llq_t *llq_new(gen_fun_t val_teardown);
+
+// deallocates the queue, calling `val_teardown` on the remaining values.
+// no other thread may be using the queue anymore
+void llq_delete(llq_t *q);
+
+// approximation of the number of queued values (exact when no other thread is using the
+// queue)
+int llq_length(llq_t *q);
+
+// puts a value at the end of the queue.
+// returns the length of the queue right after the insertion if successful, -1 otherwise
+int llq_insert_last(llq_t *q, void *val);
+
+// returns the first value of the queue and removes it, `NULL` if empty.
+// the caller takes the ownership of the value (and thus needs to tear it down)
+void *llq_pop_first(llq_t *q);
+
+// LLQ_H
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Sharded collection for C.
+ *
+ * See `../README.md` and `main()` in `../src/lls.c` for usage.
+ *
+ * @file lls.h outlines the API of `lls_t`, an unordered collection spread over several
+ * linked lists (shards), so that threads inserting at the same time mostly take different
+ * locks.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LLS_H
+#define LLS_H
+
+#include "ll.h"
+
+/* type definitions */
+
+// sharded collection, made of `ll_t` shards
+typedef struct lls lls_t;
+
+/* function prototypes */
+
+// returns a pointer to an allocated collection of `nshards` lists (as many as there are
+// online cpus when `nshards <= 0`), each one created with `opts`, `NULL` on failure.
+// values go to the shard of the inserting thread, or to the one chosen by `hash` when it
+// isn't `NULL` (then `lls_find()`/`lls_remove_find()` only look into one shard).
+// unless `opts` binds them to one NUMA node, the shards are spread over all the nodes,
+// threads inserting into and popping from those of their own node first
+lls_t *lls_new(const ll_opts_t *opts, int nshards, hash_fun_t hash);
+
+// deallocates the collection, calling `val_teardown` on the remaining values.
+// no other thread may be using it anymore
+void lls_delete(lls_t *s);
+
+// returns the number of shards
+int lls_shards(lls_t *s);
+
+// returns the number of values in all the shards, -1 if invalid
+int lls_length(lls_t *s);
+
+// adds a value to the collection.
+// returns 0 if successful, -1 otherwise
+int lls_insert(lls_t *s, void *val);
+
+// removes a value from the collection (from the shard of the calling thread, if it isn't
+// empty) and returns it, `NULL` if the collection is empty.
+// the caller takes the ownership of the value (and thus needs to tear it down)
+void *lls_pop(lls_t *s);
+
+// runs f on all values of all shards
+void lls_map(lls_t *s, gen_fun_t f);
+
+// returns a value matching `ref_value` (see `ll_find()`), `NULL` if none
+void *lls_find(lls_t *s, comp_fun_t comparator, const void *ref_value);
+
+// removes a value matching `ref_value` (see `ll_remove_find()`).
+// returns 0 if one was removed, -1 otherwise
+int lls_remove_find(lls_t *s, comp_fun_t comparator, const void *ref_value);
+
+// LLS_H
+#endif
@@ -34,44 +34,72 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
 
 #include "ll.h"
+#include "ll_epoch.h"
+#include "ll_hash.h"
+#include "ll_index.h"
+#include "ll_internal.h"
+#include "ll_numa.h"
+#include "ll_pool.h"
 
 /* macros */
 
-// for locking and unlocking rwlocks along with `locktype_t`
-#define RWLOCK(item, locktype) ((locktype) == l_read)          \
-                           ? pthread_rwlock_rdlock(&(item->m)) \
-                           : pthread_rwlock_wrlock(&(item->m))
-#define RWUNLOCK(item) pthread_rwlock_unlock(&(item->m));
+// node locks only exist (and are only taken) when `list` is in `LL_LOCK_NODES` mode
+#define NODE_RWLOCK(list, node, locktype) do {                           \
+                           if ((list)->lock_mode == LL_LOCK_NODES) {     \
+                               if ((locktype) == l_read)                 \
+                                   pthread_rwlock_rdlock(&(node)->m);    \
+                               else                                      \
+                                   pthread_rwlock_wrlock(&(node)->m);    \
+                           }                                             \
+                   } while(0)
+#define NODE_RWUNLOCK(list, node) do {                                   \
+                           if ((list)->lock_mode == LL_LOCK_NODES)       \
+                               pthread_rwlock_unlock(&(node)->m);        \
+                   } while(0)
 
+// the links lockless readers follow in `LL_LOCK_RCU` mode (`hd` and the `nxt` of linked
+// nodes) are published with release stores and loaded with acquire ones, so that a reader
+// reaching a node sees it fully initialized. these cost the same as plain accesses on
+// most platforms, and are used whatever the lock mode
+#define RCU_ASSIGN(link, ptr) __atomic_store_n(&(link), (ptr), __ATOMIC_RELEASE)
+#define RCU_DEREF(link) __atomic_load_n(&(link), __ATOMIC_ACQUIRE)
 
-// shorthand for locking a list mutex and checking list's validity
-// locktype: is the locktype_t wanted by the function that checks the list
-// list:     the list to be checked
-// retval:   is the value to be returned by the function that uses the macro,
-//           when the check fails
-#define CHECK_VALID(list, locktype, retval) {                \
+// shorthand for write locking a list about to be inserted into: on top of `CHECK_VALID`,
+// the check fails if the list is closed or has no room for `n` more values, in which case
+// the `n` nodes chained from `first` to `last` (allocated before locking the list) are
+// released
+#define CHECK_INSERTABLE(list, first, last, n, retval) {     \
                            valid_flag_t flag;                \
-                           RWLOCK(list, locktype);           \
+                           RWLOCK(list, l_write);            \
                            flag = list->valid_flag;          \
-                           if(flag != VALID) {RWUNLOCK(list);\
+                           if(flag != VALID || list->closed  \
+                              || _ll_full(list, n))          \
+                                             {RWUNLOCK(list);\
+                         ll_free_chain(list, first, last, n);\
                                               return retval;}\
                    } while(0);
+#define CHECK_INSERTABLE_NODE(list, node, retval) \
+                   CHECK_INSERTABLE(list, node, node, 1, retval)
 
 /* type definitions */
 
-typedef enum locktype locktype_t;
-
-// locktype enumerates the two typs of rw locks. This isused in the macros above for
-// simplifying all the locking/unlocking that goes on.
-enum locktype {
-    l_read,
-    l_write
-};
-
-// ll_node models a linked-list node
+// ll_node models a linked-list node.
+// in `LL_LOCK_LIST` mode nodes are allocated without their trailing mutex, which is never
+// touched: they are just a value and a link (16 bytes on 64 bits platforms). nodes of
+// doubly linked lists have a link to the previous node after that, see `PRV()`
 struct ll_node {
     // pointer to the value at the node
     void *val;
@@ -83,6 +111,125 @@ struct ll_node {
     pthread_rwlock_t m;
 };
 
+// values the background thread of a list with `async_teardown` tears down per trip to its
+// queue
+#define LL_RECLAIM_BATCH 64
+
+// ll_chain models the nodes `ll_reset()` took from a list all at once, with the index and
+// table that went with them, waiting for the background thread
+struct ll_chain {
+    // the next chain waiting
+    struct ll_chain *nxt;
+
+    // the `n` nodes, from `first` to `last`
+    ll_node_t *first;
+    ll_node_t *last;
+    size_t n;
+
+    // a reference to the node pool of the list, `NULL` if the nodes are malloc'ed (with a
+    // lock of their own when `node_locks` is set)
+    struct ll_pool *pool;
+    int node_locks;
+
+    // the position index and the hash table of the list then, `NULL` if none
+    struct ll_index *index;
+    struct ll_hash *hash;
+};
+
+// ll_reclaimer models the background thread tearing down the values removed from a list
+// with `async_teardown`. its queue is a list of its own, which removers append to. for a
+// chain given by `ll_reset()`, the reclaimer itself is queued instead
+struct ll_reclaimer {
+    // the values waiting to be torn down
+    ll_t *queue;
+
+    // the chains waiting to be reclaimed, most recent first
+    _Atomic(struct ll_chain *) chains;
+
+    // the teardown function of the list
+    gen_fun_t teardown;
+
+    // values queued and torn down so far, see `ll_flush_teardowns()`
+    atomic_ulong queued;
+    atomic_ulong torn;
+
+    pthread_t thread;
+};
+
+// ll_level models a level of a list with priorities: its values are the `len` nodes that
+// follow those of the more urgent levels, `tl` being the last of them (`NULL` if none)
+struct ll_level {
+    int len;
+    ll_node_t *tl;
+};
+
+// ll_snapshots models what the snapshots of a list share: values it removed while they
+// were out wait in `held`, as snapshots may still hand them out
+struct ll_snapshots {
+    // protects `count`, which is also read without it by `_ll_teardown()` to skip `held`
+    pthread_mutex_t m;
+    atomic_int count;
+
+    // the values to tear down once `count` is back to 0
+    ll_t *held;
+};
+
+// ll_snapshot models a snapshot: a copy of the values of `list`
+struct ll_snapshot {
+    ll_t *list;
+    int len;
+    void *vals[];
+};
+
+// size of the nodes of a list without their link to the previous node, according to its
+// locking mode: that link is where the node ends otherwise
+#define NODE_PRV_OFF(list) ((list)->lock_mode == LL_LOCK_NODES \
+                             ? sizeof(ll_node_t)               \
+                             : offsetof(ll_node_t, m))
+
+// size of the nodes of a list, according to its locking mode and whether it is doubly
+// linked
+#define NODE_SIZE(list) (NODE_PRV_OFF(list) + \
+                         ((list)->doubly_linked ? sizeof(ll_node_t *) : 0))
+
+// the link of `node` to the previous node (`NULL` for the head), in doubly linked lists
+#define PRV(list, node) (*(ll_node_t **)((char *)(node) + NODE_PRV_OFF(list)))
+
+/* node management, not exposed to the user */
+
+ll_node_t *ll_new_node(ll_t *list, void *val);
+void ll_free_node(ll_t *list, ll_node_t *node);
+static void ll_free_chain(ll_t *list, ll_node_t *first, ll_node_t *last, size_t n);
+
+static struct ll_reclaimer *_ll_reclaimer_new(gen_fun_t teardown);
+static void _ll_reclaimer_delete(struct ll_reclaimer *r);
+
+// whether `list` is bounded and `n` more values would take it past its capacity, `errno`
+// being set to `ENOSPC` if so (and the next removal then signalling the readiness
+// descriptor). the list must be locked
+static int _ll_full(ll_t *list, size_t n) {
+    if (list->capacity == 0 || (size_t)LEN(list) + n <= (size_t)list->capacity)
+        return 0;
+    atomic_store(&list->event_armed, 1);
+    errno = ENOSPC;
+    return 1;
+}
+
+static void _ll_node_lock_init(void *node) {
+    pthread_rwlock_init(&((ll_node_t *)node)->m, NULL);
+}
+
+static void _ll_node_lock_destroy(void *node) {
+    pthread_rwlock_destroy(&((ll_node_t *)node)->m);
+}
+
+// reclaims a node retired by an `LL_LOCK_RCU` list, see `_ll_retire_chain()`
+static void _ll_reclaim_node(void *list, void *node, int teardown) {
+    if (teardown)
+        _ll_teardown((ll_t *)list, ((ll_node_t *)node)->val);
+    ll_free_node((ll_t *)list, (ll_node_t *)node);
+}
+
 /**
  * @function ll_new
  *
@@ -93,12 +240,161 @@ struct ll_node {
  * @returns a pointer to a new linked list
  */
 ll_t *ll_new(gen_fun_t val_teardown) {
+    ll_opts_t opts = {0};
+    opts.val_teardown = val_teardown;
+
+    return ll_new_ex(&opts);
+}
+
+/**
+ * @function ll_new_ex
+ *
+ * Allocates a new linked list and initalizes it according to `opts`.
+ *
+ * @param opts - the options of the list, see `ll_opts_t`
+ *
+ * @returns a pointer to a new linked list, `NULL` on failure
+ */
+ll_t *ll_new_ex(const ll_opts_t *opts) {
+    if (opts->lock_mode != LL_LOCK_NODES && opts->lock_mode != LL_LOCK_LIST &&
+        opts->lock_mode != LL_LOCK_RCU)
+        return NULL;
+    if (opts->storage != LL_STORAGE_NODES && opts->storage != LL_STORAGE_UNROLLED)
+        return NULL;
+    if (opts->pos_index && opts->storage != LL_STORAGE_NODES)
+        return NULL;
+    // blocks and indexes change in place, lockless readers couldn't walk them
+    if (opts->lock_mode == LL_LOCK_RCU &&
+        (opts->storage != LL_STORAGE_NODES || opts->pos_index))
+        return NULL;
+    if (opts->doubly_linked && (opts->storage != LL_STORAGE_NODES || opts->pos_index))
+        return NULL;
+    if (opts->order != NULL && opts->storage != LL_STORAGE_NODES)
+        return NULL;
+    if (opts->key_of != NULL && opts->storage != LL_STORAGE_UNROLLED)
+        return NULL;
+    if (opts->capacity < 0 || opts->priorities < 0)
+        return NULL;
+    if (opts->numa_bind && ll_numa_index(opts->numa_node) < 0) // offline nodes have nothing
+        return NULL;
+    // levels are runs of nodes, positions tell where one stops and the next starts
+    if (opts->priorities > 0 && (opts->storage != LL_STORAGE_NODES || opts->doubly_linked ||
+                                 opts->order != NULL))
+        return NULL;
+    if (opts->lock_backend != LL_BACKEND_RWLOCK && opts->lock_backend != LL_BACKEND_TICKET &&
+        opts->lock_backend != LL_BACKEND_FUTEX)
+        return NULL;
+
     ll_t *list = (ll_t *)malloc(sizeof(ll_t));
-    list->hd = NULL;
-    list->len = 0;
-    list->val_teardown = val_teardown;
+    if (list == NULL)
+        return NULL;
+
+    list->storage = opts->storage;
+    list->lock_mode = opts->lock_mode;
+    list->doubly_linked = opts->doubly_linked != 0;
+    list->order = opts->order;
+    list->key_of = opts->key_of;
+    list->pool = NULL;
+    list->index = NULL;
+    list->hash = NULL;
+    list->epoch = NULL;
+    list->reclaimer = NULL;
+    list->stats = NULL;
+    list->snaps = NULL;
+    list->map = NULL;
+    list->map_len = 0;
+    list->capacity = opts->capacity;
+    list->priorities = opts->priorities;
+    list->levels = NULL;
+    list->numa_node = opts->numa_bind ? opts->numa_node : -1;
+    size_t slab_nodes = opts->pool_slab_nodes;
+    if (opts->numa_bind && slab_nodes == 0)
+        slab_nodes = LL_NUMA_SLAB_NODES;
+    if (opts->pos_index) {
+        list->index = ll_index_new();
+        if (list->index == NULL) {
+            free(list);
+            return NULL;
+        }
+    }
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        list->lock_mode = LL_LOCK_LIST; // blocks have no lock
+        if (llu_init(list, slab_nodes)) {
+            free(list);
+            return NULL;
+        }
+    } else if (slab_nodes > 0) {
+        int node_locks = list->lock_mode == LL_LOCK_NODES;
+        list->pool = ll_pool_new(NODE_SIZE(list), _Alignof(ll_node_t),
+                                 offsetof(ll_node_t, nxt), slab_nodes,
+                                 node_locks ? _ll_node_lock_init : NULL,
+                                 node_locks ? _ll_node_lock_destroy : NULL,
+                                 list->numa_node);
+        if (list->pool == NULL) {
+            if (list->index != NULL)
+                ll_index_delete(list->index);
+            free(list);
+            return NULL;
+        }
+    }
+    if (list->lock_mode == LL_LOCK_RCU) {
+        list->epoch = ll_epoch_new(_ll_reclaim_node, list);
+        if (list->epoch == NULL) {
+            if (list->pool != NULL)
+                ll_pool_delete(list->pool);
+            free(list);
+            return NULL;
+        }
+    }
+
+    if (list->storage == LL_STORAGE_NODES) {
+        list->hd = NULL;
+        list->tl = NULL;
+        atomic_init(&list->len, 0);
+    }
+    list->val_teardown = opts->val_teardown;
+    list->val_printer = NULL;
     list->valid_flag = VALID;
-    pthread_rwlock_init(&list->m, NULL);
+    ll_lock_init(&list->m, opts->lock_backend);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&list->wait_m, NULL);
+    pthread_cond_init(&list->nonempty, &attr);
+    pthread_cond_init(&list->notfull, &attr);
+    pthread_condattr_destroy(&attr);
+    atomic_init(&list->waiters, 0);
+    atomic_init(&list->inserters, 0);
+    list->wait_seq = 0;
+    list->closed = 0;
+    atomic_init(&list->event_fd, -1);
+    atomic_init(&list->event_armed, 0);
+    atomic_init(&list->event_contended, 0);
+
+    if (list->priorities > 0) {
+        list->levels = (struct ll_level *)calloc((size_t)list->priorities,
+                                                 sizeof(struct ll_level));
+        if (list->levels == NULL) {
+            ll_delete(list);
+            return NULL;
+        }
+    }
+
+    if (opts->async_teardown) {
+        list->reclaimer = _ll_reclaimer_new(list->val_teardown);
+        if (list->reclaimer == NULL) {
+            ll_delete(list);
+            return NULL;
+        }
+    }
+#ifdef LL_STATS
+    list->stats = ll_counters_new(list->numa_node >= 0 ? list->numa_node : ll_numa_node());
+    if (list->stats == NULL) {
+        ll_delete(list);
+        return NULL;
+    }
+#endif
 
     return list;
 }
@@ -116,24 +412,71 @@ void ll_clear(ll_t *list) {
     CHECK_VALID(list, l_write, );
     ll_node_t *node = list->hd;
     ll_node_t *next = node;
+    size_t n = 0;
 
+    if (list->epoch != NULL) { // no reader is left, what they could see goes first
+        ll_epoch_delete(list->epoch);
+        list->epoch = NULL;
+    }
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        llu_clear(list);
+        next = NULL;
+    }
     while (next != NULL) {
         node = next;
-        RWLOCK(node, l_write);
-        list->val_teardown(node->val);
+        NODE_RWLOCK(list, node, l_write);
+        _ll_teardown(list, node->val);
         next = node->nxt;
-        RWUNLOCK(node);
-        pthread_rwlock_destroy(&(node->m));
-        free(node);
-        (list->len)--;
+        NODE_RWUNLOCK(list, node);
+        if (list->pool == NULL) // pooled nodes go back all at once
+            ll_free_node(list, node);
+        LEN_ADD(list, -1);
+        n++;
     }
-    assert(list->len == 0);
+    if (list->pool != NULL && n > 0)
+        ll_free_chain(list, list->hd, node, n);
+    assert(LEN(list) == 0);
     list->hd = NULL;
+    list->tl = NULL;
     list->val_teardown = NULL;
     list->val_printer = NULL;
     list->valid_flag = INVALID;
+    LEN_SET(list, -1); // what `ll_length()` reports for invalid lists
+    if (list->pool != NULL) {
+        ll_pool_delete(list->pool);
+        list->pool = NULL;
+    }
+    if (list->index != NULL) {
+        ll_index_delete(list->index);
+        list->index = NULL;
+    }
+    if (list->hash != NULL) {
+        ll_hash_delete(list->hash);
+        list->hash = NULL;
+    }
+    struct ll_reclaimer *reclaimer = list->reclaimer;
+    list->reclaimer = NULL;
     RWUNLOCK(list);
-    pthread_rwlock_destroy(&(list->m));
+    if (reclaimer != NULL) // the values are torn down by the time the list is cleared
+        _ll_reclaimer_delete(reclaimer);
+    if (list->snaps != NULL) { // all released, nothing is held
+        ll_delete(list->snaps->held);
+        pthread_mutex_destroy(&list->snaps->m);
+        free(list->snaps);
+        list->snaps = NULL;
+    }
+    if (list->map != NULL) { // the values are torn down, nothing points in there anymore
+        munmap(list->map, list->map_len);
+        list->map = NULL;
+    }
+    if (atomic_load(&list->event_fd) >= 0) {
+        close(atomic_load(&list->event_fd));
+        atomic_store(&list->event_fd, -1);
+    }
+    ll_lock_destroy(&list->m);
+    pthread_mutex_destroy(&list->wait_m);
+    pthread_cond_destroy(&list->nonempty);
+    pthread_cond_destroy(&list->notfull);
 
 }
 
@@ -148,6 +491,9 @@ void ll_delete(ll_t *list) {
     if(list->valid_flag != INVALID) {
         ll_clear(list);
     }
+    if (list->stats != NULL)
+        ll_counters_delete(list->stats);
+    free(list->levels);
 
     free(list);
 }
@@ -156,7 +502,9 @@ void ll_delete(ll_t *list) {
 /**
  * @function ll_length
  *
- * get the number of items stored in the list
+ * get the number of items stored in the list. Lock-free: `len` is only written under the
+ * write lock of the list, with release semantics, so a plain acquire load of it is enough.
+ * Invalidated lists have a length of -1.
  *
  * @param list - the linked list
  *
@@ -164,463 +512,4959 @@ void ll_delete(ll_t *list) {
 
  */
 int ll_length(ll_t *list) {
-    int len = -1;
-
-    CHECK_VALID(list, l_read, -1);
-    len = list->len;
-    RWUNLOCK(list);
-    return len;
+    return atomic_load_explicit(&list->len, memory_order_acquire);
 }
 
 /**
  * @function ll_new_node
  *
- * Makes a new node with the given value.
+ * Makes a new node with the given value, taken from the node pool of the list if it has
+ * one.
  *
+ * @param list - the linked list the node is meant for
  * @param val - a pointer to the value
  *
- * @returns a pointer to the new node
+ * @returns a pointer to the new node, `NULL` if out of memory
  */
-ll_node_t *ll_new_node(void *val) {
-    ll_node_t *node = (ll_node_t *)malloc(sizeof(ll_node_t));
+ll_node_t *ll_new_node(ll_t *list, void *val) {
+    ll_node_t *node;
+
+    if (list->pool != NULL) {
+        node = (ll_node_t *)ll_pool_get(list->pool);
+        if (node == NULL)
+            return NULL;
+    } else {
+        node = (ll_node_t *)malloc(NODE_SIZE(list));
+        if (node == NULL)
+            return NULL;
+        if (list->lock_mode == LL_LOCK_NODES)
+            pthread_rwlock_init(&node->m, NULL);
+    }
     node->val = val;
     node->nxt = NULL;
-    pthread_rwlock_init(&node->m, NULL);
+    STAT_ADD(list, LL_STAT_ALLOCS, 1);
 
     return node;
 }
 
 /**
- * @function ll_select_n_min_1
- *
- * Actually selects the n - 1th element. Inserting and deleting at the front of a
- * list do NOT really depend on this.
+ * @function ll_free_node
  *
- * @param list - the linked list
- * @param node - a pointer to set when the node is found
- * @param n - the index
+ * Releases a node made by `ll_new_node()`: back to the pool if the list has one, otherwise
+ * its lock is destroyed and it is freed.
  *
- * @returns 0 if successful, -1 otherwise
+ * @param list - the linked list the node belonged to
+ * @param node - the node
  */
-int ll_select_n_min_1(ll_t *list, ll_node_t **node, int n, locktype_t lt) {
-    if (n < 0) // don't check against list->len because threads can add length
-        return -1;
+void ll_free_node(ll_t *list, ll_node_t *node) {
+    STAT_ADD(list, LL_STAT_FREES, 1);
+    if (list->pool != NULL) {
+        ll_pool_put(list->pool, node);
+    } else {
+        if (list->lock_mode == LL_LOCK_NODES)
+            pthread_rwlock_destroy(&(node->m));
+        free(node);
+    }
+}
 
-    if (n == 0)
-        return 0;
+/**
+ * @function ll_new_chain
+ *
+ * Makes `n` nodes holding `vals`, already linked together, in a single trip to the node
+ * pool when the list has one.
+ *
+ * @param list - the linked list the nodes are meant for
+ * @param vals - the values, in order
+ * @param n - the number of values, at least 1
+ * @param last - set to the last node of the chain
+ *
+ * @returns the first node of the chain, `NULL` if out of memory
+ */
+static ll_node_t *ll_new_chain(ll_t *list, void **vals, size_t n, ll_node_t **last) {
+    ll_node_t *first;
+    ll_node_t *node;
+    size_t i;
 
-    // n > 0
-    CHECK_VALID(list, lt, -1);
-    *node = list->hd;
-    if (*node == NULL) { // list is empty
-        assert(list->len == 0);
-        RWUNLOCK(list);
-        return -1;
+    if (list->pool != NULL) {
+        first = (ll_node_t *)ll_pool_get_chain(list->pool, n);
+        if (first == NULL)
+            return NULL;
+        for (node = first, i = 0; i < n; node = node->nxt, i++) {
+            node->val = vals[i];
+            *last = node;
+        }
+        STAT_ADD(list, LL_STAT_ALLOCS, n);
+        return first;
     }
 
-    RWLOCK((*node), lt);
-    ll_node_t *last;
-    for (; n > 1; n--) {
-        last = *node;
-        *node = last->nxt;
-        if (*node == NULL) { // happens when another thread deletes the end of a list
-            RWUNLOCK(last);
-            RWUNLOCK(list);
-            return -1;
+    first = ll_new_node(list, vals[0]);
+    *last = first;
+    for (i = 1; i < n && first != NULL; i++) {
+        node = ll_new_node(list, vals[i]);
+        if (node == NULL) {
+            while (first != NULL) {
+                node = first;
+                first = first->nxt;
+                ll_free_node(list, node);
+            }
+            return NULL;
         }
+        (*last)->nxt = node;
+        *last = node;
+    }
+
+    return first;
+}
 
-        RWLOCK((*node), lt);
-        RWUNLOCK(last);
+/**
+ * @function ll_free_chain
+ *
+ * Releases `n` nodes chained from `first` to `last`, in a single trip to the node pool
+ * when the list has one.
+ *
+ * @param list - the linked list the nodes belonged to
+ * @param first - the first node of the chain
+ * @param last - the last node of the chain
+ * @param n - the number of nodes
+ */
+static void ll_free_chain(ll_t *list, ll_node_t *first, ll_node_t *last, size_t n) {
+    if (list->pool != NULL) {
+        STAT_ADD(list, LL_STAT_FREES, n);
+        ll_pool_put_chain(list->pool, first, last, n);
+        return;
     }
-    // RWUNLOCK(list->m); keep the list locked
 
-    return 0;
+    last->nxt = NULL;
+    while (first != NULL) {
+        ll_node_t *node = first;
+        first = first->nxt;
+        ll_free_node(list, node);
+    }
 }
 
 /**
- * @function ll_insert_n
+ * @function _ll_level_at
  *
- * Inserts a value at the nth position of a linked list.
+ * Finds the level of priority of the value at position `pos` of a list with priorities.
  *
  * @param list - the linked list
- * @param val - a pointer to the value
- * @param n - the index
+ * @param pos - the position, up to the length of the list
  *
- * @returns 0 if successful, -1 otherwise
+ * @returns the level, the least urgent one for the end of the list
  */
-int ll_insert_n(ll_t *list, void *val, int n) {
-    ll_node_t *new_node = ll_new_node(val);
+static int _ll_level_at(ll_t *list, int pos) {
+    int level;
 
-    if (n == 0) { // nth_node is list->hd
-        CHECK_VALID(list, l_write, -1);
-        new_node->nxt = list->hd;
-        list->hd = new_node;
+    for (level = 0; level < list->priorities - 1 && pos >= list->levels[level].len; level++)
+        pos -= list->levels[level].len;
+
+    return level;
+}
+
+/**
+ * @function _ll_levels_link
+ *
+ * Accounts for `n` nodes, up to `last`, linked at position `pos` of a list with priorities,
+ * which must be within level `level` or at either end of it.
+ *
+ * @param list - the linked list
+ * @param level - the level of the nodes
+ * @param pos - the position of the first node
+ * @param last - the last node
+ * @param n - the number of nodes
+ */
+static void _ll_levels_link(ll_t *list, int level, int pos, ll_node_t *last, int n) {
+    int end = 0;
+    int i;
+
+    for (i = 0; i <= level; i++)
+        end += list->levels[i].len;
+    if (pos == end)
+        list->levels[level].tl = last;
+    list->levels[level].len += n;
+}
+
+/**
+ * @function _ll_levels_unlink
+ *
+ * Accounts for the `n` nodes unlinked from position `pos` on of a list with priorities: the
+ * levels whose last node went end with `prev` if they still have nodes, those being before
+ * the chain.
+ *
+ * @param list - the linked list
+ * @param prev - the node that preceded the chain, `NULL` if it started at the head
+ * @param pos - the position of the first node
+ * @param n - the number of nodes
+ */
+static void _ll_levels_unlink(ll_t *list, ll_node_t *prev, int pos, int n) {
+    int end = 0;
+    int i;
+
+    for (i = 0; i < list->priorities && n > 0; i++) {
+        struct ll_level *level = &list->levels[i];
+        end += level->len;
+        if (pos >= end)
+            continue;
+        int gone = pos + n < end ? n : end - pos;
+        if (pos + gone == end)
+            level->tl = level->len > gone ? prev : NULL;
+        level->len -= gone;
+        pos += gone;
+        n -= gone;
+    }
+}
+
+/**
+ * @function _ll_link_chain_level
+ *
+ * Links the `n` nodes chained from `first` to `last` right after `prev` (or at the front
+ * of the list when `prev` is `NULL`), keeping `hd`, `tl`, `len`, the links to the previous
+ * nodes, the levels of priority and the indexes consistent. The list must be write locked.
+ * Should an index run out of memory, the list is left without it: the accesses it served
+ * go back to walking the nodes.
+ *
+ * @param list - the linked list
+ * @param prev - the node after which the chain is linked, `NULL` for the head
+ * @param pos - the position `first` ends up at
+ * @param first - the first node of the chain
+ * @param last - the last node of the chain
+ * @param n - the number of nodes in the chain
+ * @param level - the level of priority of the nodes, -1 for that of the node at `pos`
+ */
+static void _ll_link_chain_level(ll_t *list, ll_node_t *prev, int pos, ll_node_t *first,
+                                 ll_node_t *last, int n, int level) {
+    if (prev == NULL) {
+        last->nxt = list->hd;
+        RCU_ASSIGN(list->hd, first);
     } else {
-        ll_node_t *nth_node;
-        // ll_select_n_min_1 checks and locks the list for us (on success)
-        if (ll_select_n_min_1(list, &nth_node, n, l_write)) {
-            free(new_node);
-            return -1;
+        last->nxt = prev->nxt;
+        RCU_ASSIGN(prev->nxt, first);
+    }
+    if (last->nxt == NULL)
+        list->tl = last;
+    else if (list->doubly_linked)
+        PRV(list, last->nxt) = last;
+    if (list->doubly_linked) {
+        ll_node_t *node = first;
+        ll_node_t *before = prev;
+        int i;
+        for (i = 0; i < n; i++, before = node, node = node->nxt)
+            PRV(list, node) = before;
+    }
+    if (list->levels != NULL)
+        _ll_levels_link(list, level < 0 ? _ll_level_at(list, pos) : level, pos, last, n);
+    LEN_ADD(list, n);
+    STAT_ADD(list, LL_STAT_INSERTS, n);
+    if (list->index != NULL &&
+        ll_index_insert(list->index, pos, first, offsetof(ll_node_t, nxt), (size_t)n)) {
+        ll_index_delete(list->index);
+        list->index = NULL;
+    }
+    if (list->hash != NULL) {
+        ll_node_t *node = first;
+        int i;
+        for (i = 0; i < n; i++) {
+            if (ll_hash_insert(list->hash, node->val, node, prev)) {
+                ll_hash_delete(list->hash);
+                list->hash = NULL;
+                return;
+            }
+            prev = node;
+            node = node->nxt;
         }
-        new_node->nxt = nth_node->nxt;
-        nth_node->nxt = new_node;
-        RWUNLOCK(nth_node);
+        if (node != NULL)
+            ll_hash_set_prev(list->hash, node->val, node, last);
     }
+}
 
-    (list->len)++;
-    RWUNLOCK(list);
+/**
+ * @function _ll_link_chain_after
+ *
+ * `_ll_link_chain_level` for nodes that join the level of the node they go before.
+ *
+ * @param list - the linked list
+ * @param prev - the node after which the chain is linked, `NULL` for the head
+ * @param pos - the position `first` ends up at
+ * @param first - the first node of the chain
+ * @param last - the last node of the chain
+ * @param n - the number of nodes in the chain
+ */
+static void _ll_link_chain_after(ll_t *list, ll_node_t *prev, int pos, ll_node_t *first,
+                                 ll_node_t *last, int n) {
+    _ll_link_chain_level(list, prev, pos, first, last, n, -1);
+}
 
-    return list->len;
+/**
+ * @function _ll_unlink_chain_after
+ *
+ * Unlinks the `n` nodes that directly follow `prev` (or start at the head when `prev` is
+ * `NULL`), up to `last`, keeping `hd`, `tl`, `len`, the links to the previous nodes, the
+ * levels of priority and the indexes consistent, then wakes up the threads waiting for
+ * room. The list must be write locked. The chain keeps pointing to the rest of the list,
+ * so that lockless readers on it find their way back.
+ *
+ * @param list - the linked list
+ * @param prev - the node preceding the chain, `NULL` if the chain starts at the head
+ * @param pos - the position of the first node of the chain
+ * @param last - the last node of the chain
+ * @param n - the number of nodes in the chain
+ */
+static void _ll_unlink_chain_after(ll_t *list, ll_node_t *prev, int pos, ll_node_t *last,
+                                   int n) {
+    ll_node_t *first = prev == NULL ? list->hd : prev->nxt;
+
+    if (prev == NULL)
+        RCU_ASSIGN(list->hd, last->nxt);
+    else
+        RCU_ASSIGN(prev->nxt, last->nxt);
+    if (list->tl == last)
+        list->tl = prev;
+    else if (list->doubly_linked)
+        PRV(list, last->nxt) = prev;
+    if (list->levels != NULL)
+        _ll_levels_unlink(list, prev, pos, n);
+    LEN_ADD(list, -n);
+    STAT_ADD(list, LL_STAT_REMOVES, n);
+    _ll_wake_inserters(list, n);
+    if (list->index != NULL)
+        ll_index_remove(list->index, pos, (size_t)n);
+    if (list->hash != NULL) {
+        for (; n > 0; n--, first = first->nxt)
+            ll_hash_remove(list->hash, first->val, first);
+        if (last->nxt != NULL)
+            ll_hash_set_prev(list->hash, last->nxt->val, last->nxt, prev);
+    }
 }
 
 /**
- * @function ll_insert_first
+ * @function _ll_link_after
  *
- * Just a wrapper for `ll_insert_n` called with 0.
+ * Links `node` right after `prev` (or at the front of the list when `prev` is `NULL`).
+ * The list must be write locked.
  *
  * @param list - the linked list
- * @param val - a pointer to the value
+ * @param prev - the node after which `node` is linked, `NULL` for the head
+ * @param pos - the position `node` ends up at
+ * @param node - the node to link
+ */
+static void _ll_link_after(ll_t *list, ll_node_t *prev, int pos, ll_node_t *node) {
+    _ll_link_chain_after(list, prev, pos, node, node, 1);
+}
+
+/**
+ * @function _ll_unlink_after
  *
- * @returns the new length of thew linked list on success, -1 otherwise
+ * Unlinks `node`, which directly follows `prev` (or is the head when `prev` is `NULL`).
+ * The list must be write locked.
+ *
+ * @param list - the linked list
+ * @param prev - the node preceding `node`, `NULL` if `node` is the head
+ * @param pos - the position of `node`
+ * @param node - the node to unlink
  */
-int ll_insert_first(ll_t *list, void *val) {
-    return ll_insert_n(list, val, 0);
+static void _ll_unlink_after(ll_t *list, ll_node_t *prev, int pos, ll_node_t *node) {
+    _ll_unlink_chain_after(list, prev, pos, node, 1);
 }
 
 /**
- * @function ll_insert_last
+ * @function _ll_retire_chain
  *
- * Just a wrapper for `ll_insert_n` called with the index being the length of the linked list.
+ * Disposes of the `n` nodes chained from `first`, just unlinked from the write locked
+ * list: their values are torn down, unless the caller took them. In `LL_LOCK_RCU` mode
+ * lockless readers may still be on the nodes, which are retired instead: they are torn
+ * down and freed once all those readers are done.
  *
  * @param list - the linked list
- * @param val - a pointer to the value
+ * @param first - the first node of the chain
+ * @param n - the number of nodes in the chain
+ * @param teardown - whether to tear the values down
  *
- * @returns the new length of thew linked list on success, -1 otherwise
+ * @returns `first`, for the caller to free the chain (once the list is unlocked, if it
+ * likes), `NULL` when it was retired
  */
-int ll_insert_last(ll_t *list, void *val) {
-    return ll_insert_n(list, val, list->len);
+static ll_node_t *_ll_retire_chain(ll_t *list, ll_node_t *first, int n, int teardown) {
+    ll_node_t *node = first;
+
+    if (list->epoch != NULL) {
+        for (; n > 0; n--) {
+            ll_node_t *next = node->nxt;
+            ll_epoch_retire(list->epoch, node, teardown);
+            node = next;
+        }
+        return NULL;
+    }
+    if (teardown)
+        for (; n > 0; n--, node = node->nxt)
+            _ll_teardown(list, node->val);
+
+    return first;
 }
 
 /**
- * @function ll_remove_n
+ * @function _ll_pop_first_locked
  *
- * Removes the nth element of the linked list.
+ * Unlinks and frees the first node of a write locked list.
  *
  * @param list - the linked list
- * @param n - the index
+ * @param data - set to the value of the first node
  *
- * @returns the new length of thew linked list on success, -1 otherwise
+ * @returns 1 if a node was popped, 0 if the list is empty
  */
-int ll_remove_n(ll_t *list, int n) {
-    ll_node_t *tmp;
-    if (n == 0) {
-        CHECK_VALID(list, l_write, -1);
-        tmp = list->hd;
-        list->hd = tmp->nxt;
-    } else {
-        ll_node_t *nth_node;
-        // ll_select_n_min_1 checks and locks the list for us (on success)
-        if (ll_select_n_min_1(list, &nth_node, n, l_write)) {
-            // that node index doesn't exist
-            return -1;
-        }
+static int _ll_pop_first_locked(ll_t *list, void **data) {
+    ll_node_t *node = list->hd;
+
+    if (LEN(list) == 0) { // the next insertion signals the readiness descriptor
+        atomic_store(&list->event_armed, 1);
+        return 0;
+    }
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return llu_pop_many(list, data, 1);
+    *data = node->val;
+    _ll_unlink_after(list, NULL, 0, node);
+    if (_ll_retire_chain(list, node, 1, 0) != NULL)
+        ll_free_node(list, node);
+
+    return 1;
+}
+
+/**
+ * @function _ll_unrolled_insert
+ *
+ * `ll_insert_n`, `ll_insert_last` and `ll_insert_many` for unrolled lists.
+ *
+ * @param list - the linked list
+ * @param vals - the values
+ * @param n - the number of values
+ * @param pos - the position of the first value, -1 to append
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+static int _ll_unrolled_insert(ll_t *list, void **vals, size_t n, int pos) {
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    if (list->closed || _ll_full(list, n) || llu_insert(list, pos, vals, n)) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    new_len = LEN(list);
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, (int)n);
+
+    return new_len;
+}
+
+/**
+ * @function _ll_unrolled_remove
+ *
+ * `ll_remove_n`, `ll_remove_search` and `ll_remove_find` for unrolled lists: removes the
+ * value at `pos`, or the first one matching `comparator` or `cond` when either is set.
+ *
+ * @param list - the linked list
+ * @param pos - the position of the value
+ * @param comparator - see `ll_find()`
+ * @param ref_value - reference value passed to the comparator
+ * @param cond - see `ll_remove_search()`
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+static int _ll_unrolled_remove(ll_t *list, int pos, comp_fun_t comparator,
+                               const void *ref_value, int cond(void *)) {
+    int new_len;
+    int found;
+    void *val;
+
+    CHECK_VALID(list, l_write, -1);
+    if (comparator != NULL || cond != NULL)
+        found = llu_find(list, comparator, ref_value, cond, 1, &val) >= 0;
+    else
+        found = llu_remove(list, pos, &val) == 0;
+    if (!found) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    _ll_teardown(list, val);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function _ll_post_event
+ *
+ * Makes the readiness descriptor of the list readable, if it has one (it counts up, so
+ * this never fails short of 2^64 - 1 posts nobody read).
+ *
+ * @param list - the linked list
+ */
+void _ll_post_event(ll_t *list) {
+    int fd = atomic_load(&list->event_fd);
+    uint64_t one = 1;
+
+    if (fd >= 0 && write(fd, &one, sizeof(one)) < 0)
+        return; // full: readable anyway
+}
+
+/**
+ * @function _ll_notify_event
+ *
+ * Called after values were inserted or removed: posts the readiness descriptor if a
+ * pop found the list empty or an insertion found it full since it was last posted. Costs
+ * a single atomic load when the list has no descriptor.
+ *
+ * @param list - the linked list
+ */
+static void _ll_notify_event(ll_t *list) {
+    if (atomic_load(&list->event_fd) >= 0 && atomic_exchange(&list->event_armed, 0))
+        _ll_post_event(list);
+}
+
+/**
+ * @function _ll_wake_waiters
+ *
+ * Called after `n` values were inserted (and the list unlocked) to wake up threads
+ * sleeping in `ll_pop_first_wait`. Costs a single atomic load when nobody is waiting.
+ *
+ * @param list - the linked list
+ * @param n - the number of values inserted
+ */
+void _ll_wake_waiters(ll_t *list, int n) {
+    _ll_notify_event(list);
+    if (atomic_load(&list->waiters) == 0)
+        return;
+
+    pthread_mutex_lock(&list->wait_m);
+    list->wait_seq++;
+    if (n == 1)
+        pthread_cond_signal(&list->nonempty);
+    else
+        pthread_cond_broadcast(&list->nonempty);
+    pthread_mutex_unlock(&list->wait_m);
+}
+
+/**
+ * @function _ll_wake_inserters
+ *
+ * Called after `n` values were removed from a bounded list to wake up threads sleeping in
+ * `ll_insert_last_wait`. Costs a single atomic load when nobody is waiting. The list may
+ * still be locked: `wait_m` is never held while locking it.
+ *
+ * @param list - the linked list
+ * @param n - the number of values removed
+ */
+void _ll_wake_inserters(ll_t *list, int n) {
+    if (list->capacity == 0)
+        return;
+    _ll_notify_event(list);
+    if (atomic_load(&list->inserters) == 0)
+        return;
+
+    pthread_mutex_lock(&list->wait_m);
+    list->wait_seq++;
+    if (n == 1)
+        pthread_cond_signal(&list->notfull);
+    else
+        pthread_cond_broadcast(&list->notfull);
+    pthread_mutex_unlock(&list->wait_m);
+}
+
+/**
+ * @function _ll_teardown
+ *
+ * Tears down a value removed from the list, or queues it for the background thread when
+ * the list has one (should the queue be out of memory, it is torn down on the spot). While
+ * snapshots of the list are out, the value is held until they are released instead.
+ *
+ * @param list - the linked list
+ * @param val - the value
+ */
+void _ll_teardown(ll_t *list, void *val) {
+    struct ll_reclaimer *r = list->reclaimer;
+    struct ll_snapshots *s = __atomic_load_n(&list->snaps, __ATOMIC_ACQUIRE);
+
+    if (s != NULL && atomic_load(&s->count) > 0) {
+        int held = 0;
+        pthread_mutex_lock(&s->m);
+        if (atomic_load(&s->count) > 0) // the last snapshot may have just been released
+            held = ll_insert_last(s->held, val) >= 0;
+        pthread_mutex_unlock(&s->m);
+        if (held)
+            return;
+    }
+    if (r != NULL) {
+        atomic_fetch_add(&r->queued, 1);
+        if (ll_insert_last(r->queue, val) >= 0)
+            return;
+        atomic_fetch_add(&r->torn, 1);
+    }
+    list->val_teardown(val);
+}
+
+/**
+ * @function _ll_reclaim_chains
+ *
+ * Tears down the values of all the chains given by `ll_reset()` so far and frees their
+ * nodes (giving them back to their pool in a single trip when they come from one).
+ *
+ * @param r - the reclaimer
+ *
+ * @returns the number of values torn down
+ */
+static unsigned long _ll_reclaim_chains(struct ll_reclaimer *r) {
+    struct ll_chain *chain = atomic_exchange(&r->chains, NULL);
+    unsigned long torn = 0;
+
+    while (chain != NULL) {
+        struct ll_chain *next = chain->nxt;
+        ll_node_t *node = chain->first;
+        size_t i;
+        for (i = 0; i < chain->n; i++) {
+            ll_node_t *nxt = node->nxt;
+            r->teardown(node->val);
+            if (chain->pool == NULL) {
+                if (chain->node_locks)
+                    pthread_rwlock_destroy(&node->m);
+                free(node);
+            }
+            node = nxt;
+        }
+        if (chain->pool != NULL) {
+            ll_pool_put_chain(chain->pool, chain->first, chain->last, chain->n);
+            ll_pool_delete(chain->pool);
+        }
+        if (chain->index != NULL)
+            ll_index_delete(chain->index);
+        if (chain->hash != NULL)
+            ll_hash_delete(chain->hash);
+        torn += chain->n;
+        free(chain);
+        chain = next;
+    }
+
+    return torn;
+}
+
+/**
+ * @function _ll_reclaim
+ *
+ * Tears down a value taken from the queue of a reclaimer, or the chains waiting when it is
+ * the reclaimer itself.
+ *
+ * @param r - the reclaimer
+ * @param val - the value
+ *
+ * @returns the number of values torn down
+ */
+static unsigned long _ll_reclaim(struct ll_reclaimer *r, void *val) {
+    if (val == (void *)r)
+        return _ll_reclaim_chains(r);
+    r->teardown(val);
+
+    return 1;
+}
+
+/**
+ * @function _ll_reclaimer_main
+ *
+ * The background thread of a list with `async_teardown`: sleeps until values are queued,
+ * then tears them down up to `LL_RECLAIM_BATCH` at a time, until the queue is closed and
+ * empty. `errno` tells a `NULL` value from the end (`ll_pop_first_wait()` clears it when
+ * it pops one).
+ *
+ * @param arg - the `struct ll_reclaimer`
+ *
+ * @returns `NULL`
+ */
+static void *_ll_reclaimer_main(void *arg) {
+    struct ll_reclaimer *r = (struct ll_reclaimer *)arg;
+    void *vals[LL_RECLAIM_BATCH];
+    unsigned long torn;
+    void *val;
+    int i, n;
+
+    for (;;) {
+        val = ll_pop_first_wait(r->queue, NULL);
+        if (val == NULL && errno != 0)
+            break;
+        n = ll_pop_many(r->queue, vals, LL_RECLAIM_BATCH - 1);
+        torn = _ll_reclaim(r, val);
+        for (i = 0; i < n; i++)
+            torn += _ll_reclaim(r, vals[i]);
+        atomic_fetch_add(&r->torn, torn);
+    }
+
+    return NULL;
+}
+
+/**
+ * @function _ll_reclaimer_new
+ *
+ * Creates the queue of a list with `async_teardown` (itself a list, with just its own
+ * lock) and starts the background thread emptying it.
+ *
+ * @param teardown - the teardown function of the list
+ *
+ * @returns the reclaimer, `NULL` on failure
+ */
+static struct ll_reclaimer *_ll_reclaimer_new(gen_fun_t teardown) {
+    ll_opts_t opts = {0};
+    struct ll_reclaimer *r = (struct ll_reclaimer *)malloc(sizeof(struct ll_reclaimer));
+
+    if (r == NULL)
+        return NULL;
+    opts.val_teardown = teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.lock_backend = LL_BACKEND_FUTEX;
+    opts.pool_slab_nodes = LL_RECLAIM_BATCH;
+    r->queue = ll_new_ex(&opts);
+    if (r->queue == NULL) {
+        free(r);
+        return NULL;
+    }
+    r->teardown = teardown;
+    atomic_init(&r->chains, NULL);
+    atomic_init(&r->queued, 0);
+    atomic_init(&r->torn, 0);
+    if (pthread_create(&r->thread, NULL, _ll_reclaimer_main, r)) {
+        ll_delete(r->queue);
+        free(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+/**
+ * @function _ll_reclaimer_delete
+ *
+ * Closes the queue, waits for the background thread to tear everything down and exit,
+ * then frees the reclaimer.
+ *
+ * @param r - the reclaimer
+ */
+static void _ll_reclaimer_delete(struct ll_reclaimer *r) {
+    ll_close(r->queue);
+    pthread_join(r->thread, NULL);
+    _ll_reclaim_chains(r); // those whose reclaimer couldn't be queued
+    ll_delete(r->queue);
+    free(r);
+}
+
+/**
+ * @function _ll_reset_async
+ *
+ * The constant time part of `ll_reset()`: empties a write locked list with node storage,
+ * handing its nodes (and its position index and hash table, which are replaced by empty
+ * ones) to the background thread. Not for `LL_LOCK_RCU` mode, nor while snapshots are out.
+ *
+ * @param list - the linked list, which has `async_teardown` and isn't empty
+ *
+ * @returns the reclaimer to queue to get the nodes reclaimed, `NULL` if out of memory
+ * (nothing is done then)
+ */
+static struct ll_reclaimer *_ll_reset_async(ll_t *list) {
+    struct ll_chain *chain = (struct ll_chain *)calloc(1, sizeof(struct ll_chain));
+    struct ll_index *index = NULL;
+    struct ll_hash *hash = NULL;
+    int n = LEN(list);
+
+    if (chain == NULL ||
+        (list->index != NULL && (index = ll_index_new()) == NULL) ||
+        (list->hash != NULL &&
+         (hash = ll_hash_new(ll_hash_fun(list->hash),
+                             ll_hash_comparator(list->hash))) == NULL)) {
+        if (index != NULL)
+            ll_index_delete(index);
+        free(chain);
+        return NULL;
+    }
+    chain->first = list->hd;
+    chain->last = list->tl;
+    chain->n = (size_t)n;
+    chain->pool = list->pool != NULL ? ll_pool_ref(list->pool) : NULL;
+    chain->node_locks = list->lock_mode == LL_LOCK_NODES;
+    chain->index = list->index;
+    chain->hash = list->hash;
+    list->index = index;
+    list->hash = hash;
+    list->hd = NULL;
+    list->tl = NULL;
+    if (list->levels != NULL)
+        memset(list->levels, 0, (size_t)list->priorities * sizeof(struct ll_level));
+    LEN_SET(list, 0);
+    STAT_ADD(list, LL_STAT_REMOVES, n);
+    STAT_ADD(list, LL_STAT_FREES, n);
+    _ll_wake_inserters(list, n);
+
+    struct ll_reclaimer *r = list->reclaimer;
+    atomic_fetch_add(&r->queued, (unsigned long)n);
+    chain->nxt = atomic_load(&r->chains);
+    while (!atomic_compare_exchange_weak(&r->chains, &chain->nxt, chain))
+        ;
+
+    return r;
+}
+
+/**
+ * @function ll_reset
+ *
+ * Removes all the values of the list, which stays valid. Lists with `async_teardown` and
+ * node storage, not in `LL_LOCK_RCU` mode, hand their whole chain of nodes to their
+ * background thread (see `_ll_reset_async()`), so that the list is only locked for a few
+ * pointer updates. Others, or when snapshots are out, unlink the values as `ll_pop_many()`
+ * would and tear them down on the spot.
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 if the list is invalid
+ */
+int ll_reset(ll_t *list) {
+    struct ll_reclaimer *r = NULL;
+    struct ll_snapshots *s;
+    ll_node_t *first = NULL;
+    ll_node_t *last = NULL;
+    void *vals[LL_RECLAIM_BATCH];
+    int n, i;
+
+    CHECK_VALID(list, l_write, -1);
+    n = LEN(list);
+    if (n == 0) {
+        RWUNLOCK(list);
+        return 0;
+    }
+    s = list->snaps;
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        while ((n = llu_pop_many(list, vals, LL_RECLAIM_BATCH)) > 0)
+            for (i = 0; i < n; i++)
+                _ll_teardown(list, vals[i]);
+        RWUNLOCK(list);
+        return 0;
+    }
+    if (list->reclaimer != NULL && list->epoch == NULL &&
+        (s == NULL || atomic_load(&s->count) == 0))
+        r = _ll_reset_async(list);
+    if (r == NULL) {
+        first = list->hd;
+        last = list->tl;
+        _ll_unlink_chain_after(list, NULL, 0, last, n);
+        first = _ll_retire_chain(list, first, n, 1);
+    }
+    RWUNLOCK(list);
+
+    if (first != NULL)
+        ll_free_chain(list, first, last, (size_t)n);
+    if (r != NULL && ll_insert_last(r->queue, r) < 0)
+        atomic_fetch_add(&r->torn, _ll_reclaim_chains(r));
+
+    return 0;
+}
+
+/**
+ * @function ll_select_n_min_1
+ *
+ * Actually selects the n - 1th element. Inserting and deleting at the front of a
+ * list do NOT really depend on this.
+ *
+ * @param list - the linked list
+ * @param node - a pointer to set when the node is found
+ * @param n - the index
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int ll_select_n_min_1(ll_t *list, ll_node_t **node, int n, locktype_t lt) {
+    if (n < 0) // don't check against list->len because threads can add length
+        return -1;
+
+    if (n == 0)
+        return 0;
+
+    // n > 0
+    CHECK_VALID(list, lt, -1);
+    *node = list->hd;
+    if (*node == NULL) { // list is empty
+        assert(LEN(list) == 0);
+        RWUNLOCK(list);
+        return -1;
+    }
+
+    if (n == LEN(list)) { // the n - 1th node is the last one, no need to walk there
+        *node = list->tl;
+        NODE_RWLOCK(list, (*node), lt);
+        return 0;
+    }
+
+    if (list->index != NULL) {
+        *node = (ll_node_t *)ll_index_get(list->index, n - 1);
+        if (*node == NULL) { // past the end
+            RWUNLOCK(list);
+            return -1;
+        }
+        NODE_RWLOCK(list, (*node), lt);
+        return 0;
+    }
+
+    NODE_RWLOCK(list, (*node), lt);
+    STAT_ADD(list, LL_STAT_WALKS, 1);
+    STAT_ADD(list, LL_STAT_WALK_STEPS, n - 1);
+    ll_node_t *last;
+    for (; n > 1; n--) {
+        last = *node;
+        *node = last->nxt;
+        if (*node == NULL) { // happens when another thread deletes the end of a list
+            NODE_RWUNLOCK(list, last);
+            RWUNLOCK(list);
+            return -1;
+        }
+
+        NODE_RWLOCK(list, (*node), lt);
+        NODE_RWUNLOCK(list, last);
+    }
+    // RWUNLOCK(list->m); keep the list locked
+
+    return 0;
+}
+
+/**
+ * @function _ll_insert_n
+ *
+ * Inserts a value at the nth position of a linked list.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ * @param n - the index
+ * @param handle - set to the new node (before the list is unlocked) unless `NULL`
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+static int _ll_insert_n(ll_t *list, void *val, int n, ll_node_t **handle) {
+    if (list->order != NULL) // would break the order
+        return -1;
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return n < 0 ? -1 : _ll_unrolled_insert(list, &val, 1, n);
+
+    ll_node_t *new_node = ll_new_node(list, val);
+    if (new_node == NULL)
+        return -1;
+
+    if (n == 0) { // nth_node is list->hd
+        CHECK_INSERTABLE_NODE(list, new_node, -1);
+        _ll_link_after(list, NULL, 0, new_node);
+    } else {
+        ll_node_t *nth_node;
+        // ll_select_n_min_1 checks and locks the list for us (on success)
+        if (ll_select_n_min_1(list, &nth_node, n, l_write)) {
+            ll_free_node(list, new_node);
+            return -1;
+        }
+        if (list->closed || _ll_full(list, 1)) {
+            NODE_RWUNLOCK(list, nth_node);
+            RWUNLOCK(list);
+            ll_free_node(list, new_node);
+            return -1;
+        }
+        _ll_link_after(list, nth_node, n, new_node);
+        NODE_RWUNLOCK(list, nth_node);
+    }
+    if (handle != NULL)
+        *handle = new_node;
+
+    n = LEN(list); // read before other threads can change it
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, 1);
+
+    return n;
+}
+
+/**
+ * @function ll_insert_n
+ *
+ * Inserts a value at the nth position of a linked list.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ * @param n - the index
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_n(ll_t *list, void *val, int n) {
+    return _ll_insert_n(list, val, n, NULL);
+}
+
+/**
+ * @function ll_insert_first
+ *
+ * Just a wrapper for `ll_insert_n` called with 0.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+int ll_insert_first(ll_t *list, void *val) {
+    return ll_insert_n(list, val, 0);
+}
+
+/**
+ * @function _ll_insert_last
+ *
+ * Appends a value to the linked list. Thanks to the tail pointer this is done in constant
+ * time, under a single lock of the list.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ * @param handle - set to the new node (before the list is unlocked) unless `NULL`
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+static int _ll_insert_last(ll_t *list, void *val, ll_node_t **handle) {
+    if (list->order != NULL) // would break the order
+        return -1;
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return _ll_unrolled_insert(list, &val, 1, -1);
+
+    int new_len;
+    ll_node_t *new_node = ll_new_node(list, val);
+    if (new_node == NULL)
+        return -1;
+
+    CHECK_INSERTABLE_NODE(list, new_node, -1);
+    ll_node_t *last = list->tl;
+    if (last != NULL)
+        NODE_RWLOCK(list, last, l_write);
+    _ll_link_after(list, last, LEN(list), new_node);
+    if (last != NULL)
+        NODE_RWUNLOCK(list, last);
+    if (handle != NULL)
+        *handle = new_node;
+    new_len = LEN(list);
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, 1);
+
+    return new_len;
+}
+
+/**
+ * @function ll_insert_last
+ *
+ * Wrapper for `_ll_insert_last`.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+int ll_insert_last(ll_t *list, void *val) {
+    return _ll_insert_last(list, val, NULL);
+}
+
+/**
+ * @function ll_insert_n_handle
+ *
+ * `ll_insert_n`, handing out the node of the value.
+ *
+ * @param list - the linked list, doubly linked
+ * @param val - a pointer to the value
+ * @param n - the index
+ * @param handle - set to the handle of the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_n_handle(ll_t *list, void *val, int n, ll_handle_t *handle) {
+    if (!list->doubly_linked)
+        return -1;
+
+    return _ll_insert_n(list, val, n, handle);
+}
+
+/**
+ * @function ll_insert_first_handle
+ *
+ * `ll_insert_first`, handing out the node of the value.
+ *
+ * @param list - the linked list, doubly linked
+ * @param val - a pointer to the value
+ * @param handle - set to the handle of the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_first_handle(ll_t *list, void *val, ll_handle_t *handle) {
+    return ll_insert_n_handle(list, val, 0, handle);
+}
+
+/**
+ * @function ll_insert_last_handle
+ *
+ * `ll_insert_last`, handing out the node of the value.
+ *
+ * @param list - the linked list, doubly linked
+ * @param val - a pointer to the value
+ * @param handle - set to the handle of the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_last_handle(ll_t *list, void *val, ll_handle_t *handle) {
+    if (!list->doubly_linked)
+        return -1;
+
+    return _ll_insert_last(list, val, handle);
+}
+
+/**
+ * @function ll_remove_handle
+ *
+ * Removes the value of a node handed out by an `ll_insert_*_handle` function: its link to
+ * the previous node spares the walk to it. As in `ll_iter_remove`, the previous node is
+ * the only one locked, the list write lock keeping everybody else away.
+ *
+ * @param list - the linked list, doubly linked
+ * @param handle - the node of the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_remove_handle(ll_t *list, ll_handle_t handle) {
+    ll_node_t *node = handle;
+    ll_node_t *prev;
+    int new_len;
+
+    if (!list->doubly_linked || node == NULL)
+        return -1;
+    CHECK_VALID(list, l_write, -1);
+    prev = PRV(list, node);
+    if (prev == NULL) {
+        _ll_unlink_after(list, NULL, 0, node);
+    } else {
+        NODE_RWLOCK(list, prev, l_write);
+        _ll_unlink_after(list, prev, -1, node); // no positional index, no position needed
+        NODE_RWUNLOCK(list, prev);
+    }
+    node = _ll_retire_chain(list, node, 1, 1);
+    new_len = LEN(list); // read before other threads can change it
+    RWUNLOCK(list);
+    if (node != NULL)
+        ll_free_node(list, node);
+
+    return new_len;
+}
+
+/**
+ * @function ll_insert_sorted
+ *
+ * Inserts a value into a sorted list, after the last value that doesn't sort after it (so
+ * that equal values keep their insertion order). The walk to it happens under the write
+ * lock of the list, which spares the locking of every node; appending in order is done in
+ * constant time.
+ *
+ * @param list - the linked list, sorted
+ * @param val - a pointer to the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_sorted(ll_t *list, void *val) {
+    ll_node_t *prev = NULL;
+    ll_node_t *node;
+    int pos = 0;
+    int new_len;
+
+    if (list->order == NULL)
+        return -1;
+    ll_node_t *new_node = ll_new_node(list, val);
+    if (new_node == NULL)
+        return -1;
+
+    CHECK_INSERTABLE_NODE(list, new_node, -1);
+    if (list->tl != NULL && list->order(list->tl->val, val) <= 0) {
+        prev = list->tl;
+        pos = LEN(list);
+    } else {
+        for (node = list->hd; node != NULL && list->order(node->val, val) <= 0;
+             node = node->nxt, pos++)
+            prev = node;
+    }
+    if (prev != NULL)
+        NODE_RWLOCK(list, prev, l_write);
+    _ll_link_after(list, prev, pos, new_node);
+    if (prev != NULL)
+        NODE_RWUNLOCK(list, prev);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, 1);
+
+    return new_len;
+}
+
+/**
+ * @function ll_insert_prio
+ *
+ * Inserts a value into a list with priorities, after the last value of its level: the
+ * levels up to it are all it takes to find that one, and the value at the front of the
+ * list is always the oldest of the most urgent ones.
+ *
+ * @param list - the linked list, with priorities
+ * @param val - a pointer to the value
+ * @param prio - the level of the value, 0 being the most urgent
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_insert_prio(ll_t *list, void *val, int prio) {
+    ll_node_t *prev = NULL;
+    int pos = 0;
+    int new_len;
+    int i;
+
+    if (prio < 0 || prio >= list->priorities)
+        return -1;
+    ll_node_t *new_node = ll_new_node(list, val);
+    if (new_node == NULL)
+        return -1;
+
+    CHECK_INSERTABLE_NODE(list, new_node, -1);
+    for (i = 0; i <= prio; i++) {
+        pos += list->levels[i].len;
+        if (list->levels[i].tl != NULL)
+            prev = list->levels[i].tl;
+    }
+    if (prev != NULL)
+        NODE_RWLOCK(list, prev, l_write);
+    _ll_link_chain_level(list, prev, pos, new_node, new_node, 1, prio);
+    if (prev != NULL)
+        NODE_RWUNLOCK(list, prev);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, 1);
+
+    return new_len;
+}
+
+/**
+ * @function ll_remove_n
+ *
+ * Removes the nth element of the linked list.
+ *
+ * @param list - the linked list
+ * @param n - the index
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+int ll_remove_n(ll_t *list, int n) {
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return _ll_unrolled_remove(list, n, NULL, NULL, NULL);
+
+    ll_node_t *tmp;
+    if (n == 0) {
+        CHECK_VALID(list, l_write, -1);
+        tmp = list->hd;
+        if (tmp == NULL) { // list is empty
+            RWUNLOCK(list);
+            return -1;
+        }
+        _ll_unlink_after(list, NULL, 0, tmp);
+    } else {
+        ll_node_t *nth_node;
+        // ll_select_n_min_1 checks and locks the list for us (on success)
+        if (ll_select_n_min_1(list, &nth_node, n, l_write)) {
+            // that node index doesn't exist
+            return -1;
+        }
+
+        tmp = nth_node->nxt;
+        if (tmp == NULL) { // nth_node is the last one
+            NODE_RWUNLOCK(list, nth_node);
+            RWUNLOCK(list);
+            return -1;
+        }
+        _ll_unlink_after(list, nth_node, n, tmp);
+        NODE_RWUNLOCK(list, nth_node);
+    }
+
+    tmp = _ll_retire_chain(list, tmp, 1, 1);
+
+    n = LEN(list); // read before other threads can change it
+    RWUNLOCK(list);
+    if (tmp != NULL)
+        ll_free_node(list, tmp);
+
+    return n;
+}
+
+/**
+ * @function ll_remove_first
+ *
+ * Wrapper for `ll_remove_n`.
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int ll_remove_first(ll_t *list) {
+    return ll_remove_n(list, 0);
+}
+
+/**
+ * @function ll_pop_first
+ *
+ * returns a pointer to data of the first node and removes it.
+ * NOTE : the caller takes the owner ship of the pointer
+ *        (and thus, needs to call the teardown function on it)
+ *
+ * @param list - the linked list
+ *
+ * @returns pointer to data or NULL
+ */
+void *ll_pop_first(ll_t *list) {
+    void *data = NULL;
+
+    CHECK_VALID(list, l_write, NULL);
+    _ll_pop_first_locked(list, &data);
+    RWUNLOCK(list);
+
+    return data;
+}
+
+/**
+ * @function ll_pop_first_wait
+ *
+ * Like `ll_pop_first`, but sleeps while the list is empty, until something is inserted,
+ * the deadline passes or the list is closed. The sequence number of `wait_m` is read before
+ * each attempt, so an insertion racing with a failed attempt is never missed.
+ * NOTE : the caller takes the owner ship of the pointer
+ *        (and thus, needs to call the teardown function on it)
+ *
+ * @param list - the linked list
+ * @param deadline - absolute time (on `CLOCK_MONOTONIC`) after which to give up, `NULL` to
+ * wait forever
+ *
+ * @returns pointer to data (`errno` then being 0, whatever the locks left in it), or NULL
+ * with `errno` set to `ETIMEDOUT` (deadline passed), `EPIPE` (list closed and empty) or
+ * `EINVAL` (list invalid)
+ */
+void *ll_pop_first_wait(ll_t *list, const struct timespec *deadline) {
+    void *data = NULL;
+    int got = 0;
+    int valid = 0;
+    int timed_out = 0;
+    unsigned long seen;
+
+    pthread_mutex_lock(&list->wait_m);
+    atomic_fetch_add(&list->waiters, 1);
+    for (;;) {
+        seen = list->wait_seq;
+        pthread_mutex_unlock(&list->wait_m);
+
+        RWLOCK(list, l_write);
+        valid = list->valid_flag == VALID;
+        if (valid)
+            got = _ll_pop_first_locked(list, &data);
+        RWUNLOCK(list);
+
+        pthread_mutex_lock(&list->wait_m);
+        if (!valid) {
+            errno = EINVAL;
+            break;
+        }
+        if (got) {
+            errno = 0;
+            break;
+        }
+        if (list->closed) {
+            errno = EPIPE;
+            break;
+        }
+        while (list->wait_seq == seen && !list->closed && !timed_out) {
+            if (deadline == NULL)
+                pthread_cond_wait(&list->nonempty, &list->wait_m);
+            else if (pthread_cond_timedwait(&list->nonempty, &list->wait_m,
+                                            deadline) == ETIMEDOUT)
+                timed_out = 1;
+        }
+        if (timed_out && list->wait_seq == seen && !list->closed) {
+            errno = ETIMEDOUT;
+            break;
+        }
+        timed_out = 0; // something happened in the meantime, try again
+    }
+    atomic_fetch_sub(&list->waiters, 1);
+    pthread_mutex_unlock(&list->wait_m);
+
+    return data;
+}
+
+/**
+ * @function _ll_insert_wait
+ *
+ * `ll_insert_last_wait` and `ll_insert_prio_wait`: like `ll_pop_first_wait` the other way
+ * round, sleeping while the list is full until something is removed, the deadline passes
+ * or the list is closed.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ * @param prio - the level of the value (see `ll_insert_prio`), -1 to append it
+ * @param deadline - absolute time (on `CLOCK_MONOTONIC`) after which to give up, `NULL` to
+ * wait forever
+ *
+ * @returns the new length of the linked list on success, -1 with `errno` set to
+ * `ETIMEDOUT` (deadline passed), `EPIPE` (list closed), `ENOMEM` (out of memory) or
+ * `EINVAL` (list invalid, or not inserted into for another reason) otherwise
+ */
+static int _ll_insert_wait(ll_t *list, void *val, int prio,
+                           const struct timespec *deadline) {
+    int ret;
+    int err;
+    int timed_out = 0;
+    unsigned long seen;
+
+    pthread_mutex_lock(&list->wait_m);
+    atomic_fetch_add(&list->inserters, 1);
+    for (;;) {
+        seen = list->wait_seq;
+        pthread_mutex_unlock(&list->wait_m);
+
+        errno = 0;
+        ret = prio < 0 ? ll_insert_last(list, val) : ll_insert_prio(list, val, prio);
+        err = errno;
+
+        pthread_mutex_lock(&list->wait_m);
+        if (ret >= 0)
+            break;
+        if (list->closed) {
+            errno = EPIPE;
+            break;
+        }
+        if (err != ENOSPC) { // locking may leave `EAGAIN` behind, only these are the insert's
+            errno = err == ENOMEM ? ENOMEM : EINVAL;
+            break;
+        }
+        while (list->wait_seq == seen && !list->closed && !timed_out) {
+            if (deadline == NULL)
+                pthread_cond_wait(&list->notfull, &list->wait_m);
+            else if (pthread_cond_timedwait(&list->notfull, &list->wait_m,
+                                            deadline) == ETIMEDOUT)
+                timed_out = 1;
+        }
+        if (timed_out && list->wait_seq == seen && !list->closed) {
+            errno = ETIMEDOUT;
+            break;
+        }
+        timed_out = 0; // something happened in the meantime, try again
+    }
+    atomic_fetch_sub(&list->inserters, 1);
+    pthread_mutex_unlock(&list->wait_m);
+
+    return ret;
+}
+
+/**
+ * @function ll_insert_last_wait
+ *
+ * Like `ll_insert_last`, but sleeps while the list is full, see `_ll_insert_wait`.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ * @param deadline - absolute time (on `CLOCK_MONOTONIC`) after which to give up, `NULL` to
+ * wait forever
+ *
+ * @returns the new length of the linked list on success, -1 otherwise (`errno` tells why)
+ */
+int ll_insert_last_wait(ll_t *list, void *val, const struct timespec *deadline) {
+    return _ll_insert_wait(list, val, -1, deadline);
+}
+
+/**
+ * @function ll_insert_prio_wait
+ *
+ * Like `ll_insert_prio`, but sleeps while the list is full, see `_ll_insert_wait`.
+ *
+ * @param list - the linked list, with priorities
+ * @param val - a pointer to the value
+ * @param prio - the level of the value, 0 being the most urgent
+ * @param deadline - absolute time (on `CLOCK_MONOTONIC`) after which to give up, `NULL` to
+ * wait forever
+ *
+ * @returns the new length of the linked list on success, -1 otherwise (`errno` tells why)
+ */
+int ll_insert_prio_wait(ll_t *list, void *val, int prio, const struct timespec *deadline) {
+    if (prio < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return _ll_insert_wait(list, val, prio, deadline);
+}
+
+/**
+ * @function ll_close
+ *
+ * Closes the linked list: insertions fail from now on, and threads sleeping in
+ * `ll_pop_first_wait` (they return `NULL` once the list is empty) or `ll_insert_last_wait`
+ * are woken up.
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 if the list is invalid
+ */
+int ll_close(ll_t *list) {
+    CHECK_VALID(list, l_write, -1);
+    pthread_mutex_lock(&list->wait_m);
+    list->closed = 1;
+    list->wait_seq++;
+    pthread_cond_broadcast(&list->nonempty);
+    pthread_cond_broadcast(&list->notfull);
+    pthread_mutex_unlock(&list->wait_m);
+    RWUNLOCK(list);
+    _ll_post_event(list);
+
+    return 0;
+}
+
+/**
+ * @function ll_insert_many
+ *
+ * Inserts `n` values at once: they are linked together before the list is locked, then
+ * spliced in under a single write lock of the list.
+ *
+ * @param list - the linked list
+ * @param vals - the values, `vals[0]` ending up at position `pos`
+ * @param n - the number of values
+ * @param pos - the index of the first inserted value (see `ll_insert_n`), -1 to append
+ *
+ * @returns the number of values inserted (`n`) on success, -1 otherwise
+ */
+int ll_insert_many(ll_t *list, void **vals, size_t n, int pos) {
+    ll_node_t *first;
+    ll_node_t *last;
+    ll_node_t *prev = NULL;
+
+    if (n == 0 || n > (size_t)INT_MAX || pos < -1)
+        return n == 0 ? 0 : -1;
+    if (list->order != NULL) // would break the order
+        return -1;
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return _ll_unrolled_insert(list, vals, n, pos) < 0 ? -1 : (int)n;
+    first = ll_new_chain(list, vals, n, &last);
+    if (first == NULL)
+        return -1;
+
+    if (pos == 0) {
+        CHECK_INSERTABLE(list, first, last, n, -1);
+    } else if (pos == -1) {
+        CHECK_INSERTABLE(list, first, last, n, -1);
+        prev = list->tl;
+        pos = LEN(list);
+        if (prev != NULL)
+            NODE_RWLOCK(list, prev, l_write);
+    } else {
+        // ll_select_n_min_1 checks and locks the list for us (on success)
+        if (ll_select_n_min_1(list, &prev, pos, l_write)) {
+            ll_free_chain(list, first, last, n);
+            return -1;
+        }
+        if (list->closed || _ll_full(list, n)) {
+            NODE_RWUNLOCK(list, prev);
+            RWUNLOCK(list);
+            ll_free_chain(list, first, last, n);
+            return -1;
+        }
+    }
+
+    _ll_link_chain_after(list, prev, pos, first, last, (int)n);
+    if (prev != NULL)
+        NODE_RWUNLOCK(list, prev);
+    RWUNLOCK(list);
+    _ll_wake_waiters(list, (int)n);
+
+    return (int)n;
+}
+
+/**
+ * @function _ll_pop_many_unlock
+ *
+ * `ll_pop_many` once the list is write locked and checked, unlocking it.
+ *
+ * @param list - the linked list
+ * @param out - filled with the popped values, in order
+ * @param max - the maximum number of values to pop (the size of `out`)
+ *
+ * @returns the number of values popped (0 if the list is empty)
+ */
+static int _ll_pop_many_unlock(ll_t *list, void **out, size_t max) {
+    int n = 0;
+
+    if (LEN(list) == 0) // the next insertion signals the readiness descriptor
+        atomic_store(&list->event_armed, 1);
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        n = llu_pop_many(list, out, max);
+        RWUNLOCK(list);
+        return n;
+    }
+    ll_node_t *first = list->hd;
+    ll_node_t *last = NULL;
+    ll_node_t *node = first;
+    while (node != NULL && (size_t)n < max) {
+        out[n++] = node->val;
+        last = node;
+        node = node->nxt;
+    }
+    if (n > 0) {
+        _ll_unlink_chain_after(list, NULL, 0, last, n);
+        first = _ll_retire_chain(list, first, n, 0);
+    }
+    RWUNLOCK(list);
+
+    if (n > 0 && first != NULL)
+        ll_free_chain(list, first, last, n);
+
+    return n;
+}
+
+/**
+ * @function ll_pop_many
+ *
+ * Removes up to `max` values from the front of the list under a single write lock,
+ * handing them to the caller.
+ * NOTE : the caller takes the owner ship of the pointers
+ *        (and thus, needs to call the teardown function on them)
+ *
+ * @param list - the linked list
+ * @param out - filled with the popped values, in order
+ * @param max - the maximum number of values to pop (the size of `out`)
+ *
+ * @returns the number of values popped (0 if the list is empty), -1 if the list is invalid
+ */
+int ll_pop_many(ll_t *list, void **out, size_t max) {
+    CHECK_VALID(list, l_write, -1);
+
+    return _ll_pop_many_unlock(list, out, max);
+}
+
+/**
+ * @function ll_try_insert_last
+ *
+ * Like `ll_insert_last`, but only if the list lock is free: event loops can't wait for
+ * it. The node is made beforehand (the node pool, when the list has one, is only locked
+ * for a few pointer writes), and freed if the value couldn't be inserted.
+ *
+ * @param list - the linked list
+ * @param val - a pointer to the value
+ *
+ * @returns the new length of the linked list on success, -1 otherwise with `errno` set to
+ * `EAGAIN` (list locked), `ENOSPC` (full), `EPIPE` (closed), `EINVAL` (invalid or sorted
+ * list) or `ENOMEM`
+ */
+int ll_try_insert_last(ll_t *list, void *val) {
+    ll_node_t *node = NULL;
+    int new_len = -1;
+
+    if (list->order != NULL) { // would break the order
+        errno = EINVAL;
+        return -1;
+    }
+    if (list->storage == LL_STORAGE_NODES && (node = ll_new_node(list, val)) == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!RWTRYLOCK(list, l_write) && !_ll_try_again(list, l_write)) {
+        errno = EAGAIN;
+    } else if (list->valid_flag != VALID || list->closed) {
+        errno = list->valid_flag != VALID ? EINVAL : EPIPE;
+        RWUNLOCK(list);
+    } else if (_ll_full(list, 1)) {
+        RWUNLOCK(list);
+    } else if (node == NULL) {
+        if (llu_insert(list, -1, &val, 1) == 0)
+            new_len = LEN(list);
+        else
+            errno = ENOMEM;
+        RWUNLOCK(list);
+    } else {
+        ll_node_t *last = list->tl;
+        if (last != NULL)
+            NODE_RWLOCK(list, last, l_write);
+        _ll_link_after(list, last, LEN(list), node);
+        if (last != NULL)
+            NODE_RWUNLOCK(list, last);
+        new_len = LEN(list);
+        node = NULL;
+        RWUNLOCK(list);
+    }
+    if (node != NULL)
+        ll_free_node(list, node);
+    if (new_len >= 0)
+        _ll_wake_waiters(list, 1);
+
+    return new_len;
+}
+
+/**
+ * @function ll_try_pop_many
+ *
+ * Like `ll_pop_many`, but only if the list lock is free.
+ * NOTE : the caller takes the owner ship of the pointers
+ *        (and thus, needs to call the teardown function on them)
+ *
+ * @param list - the linked list
+ * @param out - filled with the popped values, in order
+ * @param max - the maximum number of values to pop (the size of `out`)
+ *
+ * @returns the number of values popped (0 if the list is empty), -1 with `errno` set to
+ * `EAGAIN` if the list is locked, `EINVAL` if invalid
+ */
+int ll_try_pop_many(ll_t *list, void **out, size_t max) {
+    TRY_CHECK_VALID(list, l_write, -1);
+
+    return _ll_pop_many_unlock(list, out, max);
+}
+
+/**
+ * @function ll_try_pop_first
+ *
+ * Like `ll_pop_first`, but only if the list lock is free. The return value tells a `NULL`
+ * value from an empty list.
+ * NOTE : the caller takes the owner ship of the pointer
+ *        (and thus, needs to call the teardown function on it)
+ *
+ * @param list - the linked list
+ * @param val - set to the popped value
+ *
+ * @returns 1 if a value was popped, 0 if the list is empty, -1 with `errno` set to `EAGAIN`
+ * if the list is locked, `EINVAL` if invalid
+ */
+int ll_try_pop_first(ll_t *list, void **val) {
+    int n;
+
+    TRY_CHECK_VALID(list, l_write, -1);
+    n = _ll_pop_first_locked(list, val);
+    RWUNLOCK(list);
+
+    return n;
+}
+
+/**
+ * @function ll_event_fd
+ *
+ * Gives the list a readiness descriptor, for event loops to poll along with their other
+ * descriptors: an eventfd, posted (see `_ll_notify_event()`) by the first insertion after
+ * a pop found the list empty, the first removal after an insertion found it full, when the
+ * list is closed, and by the unlock that follows a try function finding the lock held (see
+ * `_ll_unlocking()`). It is posted once created, so that the loop first tries the list as
+ * is.
+ *
+ * @param list - the linked list
+ *
+ * @returns the descriptor, -1 if the list is invalid or it can't be created
+ */
+int ll_event_fd(ll_t *list) {
+    int fd;
+
+    CHECK_VALID(list, l_write, -1);
+    fd = atomic_load(&list->event_fd);
+    if (fd < 0) {
+        fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        atomic_store(&list->event_fd, fd);
+        _ll_post_event(list);
+    }
+    RWUNLOCK(list);
+
+    return fd;
+}
+
+/**
+ * @function ll_remove_search
+ *
+ * Removes the first item in the list whose value returns 1 if `cond` is called on it.
+ *
+ * @param list - the linked list
+ * @param cond - a function that will be called on the values of each node. It should
+ * return 1 of the element matches.
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+int ll_remove_search(ll_t *list, int cond(void *)) {
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return _ll_unrolled_remove(list, 0, NULL, NULL, cond);
+
+    CHECK_VALID(list, l_write, -1);
+
+    ll_node_t *last = NULL;
+    ll_node_t *node = list->hd;
+    int pos = 0;
+    while ((node != NULL) && !(cond(node->val))) {
+        last = node;
+        node = node->nxt;
+        pos++;
+    }
+
+    if (node == NULL) {
+        RWUNLOCK(list);
+        return -1;
+    } else if (node == list->hd) {
+        _ll_unlink_after(list, NULL, 0, node);
+    } else {
+        NODE_RWLOCK(list, last, l_write);
+        _ll_unlink_after(list, last, pos, node);
+        NODE_RWUNLOCK(list, last);
+    }
+
+    node = _ll_retire_chain(list, node, 1, 1);
+    int new_len = LEN(list); // read before other threads can change it
+    RWUNLOCK(list);
+
+    if (node != NULL)
+        ll_free_node(list, node); // let's chat on IRC !
+
+    return new_len;
+}
+
+/**
+ * @function ll_get_n
+ *
+ * Gets the value of the nth element of a linked list. `LL_LOCK_RCU` lists are walked
+ * without locking, under an epoch guard (the read lock being taken should the thread be
+ * impossible to register).
+ *
+ * @param list - the linked list
+ * @param n - the index
+ *
+ * @returns the `val` attribute of the nth element of `list`.
+ */
+void *ll_get_n(ll_t *list, int n) {
+    ll_node_t *node = NULL;
+    void *val = NULL;
+
+    STAT_ADD(list, LL_STAT_LOOKUPS, 1);
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        CHECK_VALID(list, l_read, NULL);
+        llu_get(list, n, &val);
+        RWUNLOCK(list);
+        return val;
+    }
+    if (list->lock_mode == LL_LOCK_RCU && ll_epoch_enter() == 0) {
+        if (list->valid_flag == VALID && n >= 0) {
+            for (node = RCU_DEREF(list->hd); node != NULL && n > 0; n--)
+                node = RCU_DEREF(node->nxt);
+            if (node != NULL)
+                val = node->val;
+        }
+        ll_epoch_exit();
+        return val;
+    }
+    // ll_select_n_min_1 chacks and locks the list on our behalf
+    if (ll_select_n_min_1(list, &node, n + 1, l_read)) {
+        return NULL;
+    }
+    val = node->val;
+    NODE_RWUNLOCK(list, node);
+    RWUNLOCK(list);
+    return val;
+}
+
+/**
+ * @function ll_get_first
+ *
+ * Wrapper for `ll_get_n`.
+ *
+ * @param list - the linked list
+ *
+ * @returns the `val` attribute of the first element of `list`.
+ */
+void *ll_get_first(ll_t *list) {
+    return ll_get_n(list, 0);
+}
+
+
+static void _ll_map_internal(ll_t *list, gen_fun_t f) {
+    ll_node_t *node = list->hd;
+
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        llu_map(list, f);
+        return;
+    }
+
+    while (node != NULL) {
+        // f() may alterate values, so "lock write", just in case of...
+        NODE_RWLOCK(list, node, l_write);
+        ll_node_t *next = node->nxt;
+        f(node->val);
+        NODE_RWUNLOCK(list, node);
+
+        node = next;
+    }
+}
+
+/**
+ * @function ll_map
+ *
+ * Calls a function on the value of every element of a linked list.
+ * `f` may alter the values: each node is write locked while `f` runs on it or, in
+ * `LL_LOCK_LIST` mode, the whole list is. `LL_LOCK_RCU` lists are walked without locking
+ * (see `ll_get_n`), `f` having to leave the values alone.
+ *
+ * @param list - the linked list
+ * @param f - the function to call on the values.
+ */
+void ll_map(ll_t *list, gen_fun_t f) {
+    STAT_ADD(list, LL_STAT_MAPS, 1);
+    if (list->lock_mode == LL_LOCK_RCU && ll_epoch_enter() == 0) {
+        ll_node_t *node;
+        if (list->valid_flag == VALID)
+            for (node = RCU_DEREF(list->hd); node != NULL; node = RCU_DEREF(node->nxt))
+                f(node->val);
+        ll_epoch_exit();
+        return;
+    }
+    CHECK_VALID(list, list->lock_mode == LL_LOCK_NODES ? l_read : l_write, );
+
+    _ll_map_internal(list, f);
+
+    RWUNLOCK(list);
+}
+
+// segments handed out per worker by `ll_map_parallel()`: enough for the workers that
+// get cheap segments to pick up the slack of the others
+#define LL_MAP_SEGS_PER_THREAD 8
+
+// a parallel map: the list cut into segments, claimed one at a time by the workers
+typedef struct {
+    ll_t *list;
+    gen_fun_t f;
+
+    // first node (or block) of each segment, and how many a segment spans
+    void **starts;
+    size_t nsegs;
+    size_t seg_len;
+
+    // next segment to claim
+    atomic_size_t next;
+} ll_map_job_t;
+
+/**
+ * @function _ll_map_worker
+ *
+ * Claims segments of a parallel map until there is none left, calling `f` on their
+ * values with the same per-node locking as `_ll_map_internal`.
+ *
+ * @param arg - the `ll_map_job_t`
+ *
+ * @returns `NULL`
+ */
+static void *_ll_map_worker(void *arg) {
+    ll_map_job_t *job = (ll_map_job_t *)arg;
+    ll_t *list = job->list;
+    size_t seg;
+
+    while ((seg = atomic_fetch_add(&job->next, 1)) < job->nsegs) {
+        if (list->storage == LL_STORAGE_UNROLLED) {
+            llu_map_blocks((ll_block_t *)job->starts[seg], job->seg_len, job->f);
+            continue;
+        }
+        ll_node_t *node = (ll_node_t *)job->starts[seg];
+        size_t i;
+        for (i = 0; i < job->seg_len && node != NULL; i++) {
+            NODE_RWLOCK(list, node, l_write);
+            ll_node_t *next = node->nxt;
+            job->f(node->val);
+            NODE_RWUNLOCK(list, node);
+            node = next;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @function _ll_map_segments
+ *
+ * Walks the list once to record where each segment of `seg_len` nodes (or blocks) starts.
+ *
+ * @param list - the linked list
+ * @param seg_len - the length of a segment
+ * @param nsegs - set to the number of segments
+ *
+ * @returns the starts of the segments (to be freed), `NULL` if out of memory
+ */
+static void **_ll_map_segments(ll_t *list, size_t seg_len, size_t *nsegs) {
+    size_t cap = 16;
+    void **starts = (void **)malloc(cap * sizeof(void *));
+    void *cur = list->storage == LL_STORAGE_UNROLLED ? (void *)list->bhd : (void *)list->hd;
+
+    *nsegs = 0;
+    while (starts != NULL && cur != NULL) {
+        if (*nsegs == cap) {
+            void **grown = (void **)realloc(starts, 2 * cap * sizeof(void *));
+            if (grown == NULL) {
+                free(starts);
+                return NULL;
+            }
+            starts = grown;
+            cap *= 2;
+        }
+        starts[(*nsegs)++] = cur;
+        if (list->storage == LL_STORAGE_UNROLLED) {
+            cur = llu_map_blocks((ll_block_t *)cur, seg_len, NULL);
+        } else {
+            ll_node_t *node = (ll_node_t *)cur;
+            size_t i;
+            for (i = 0; i < seg_len && node != NULL; i++)
+                node = node->nxt;
+            cur = node;
+        }
+    }
+
+    return starts;
+}
+
+/**
+ * @function ll_map_parallel
+ *
+ * Like `ll_map`, but spreads the calls to `f` over `nthreads` threads (the caller being
+ * one of them). The list is cut into about `LL_MAP_SEGS_PER_THREAD` segments per thread,
+ * which the threads claim one after the other, so that a slow segment doesn't hold the
+ * others back. The locking is that of `ll_map`, hence `f` runs concurrently on different
+ * values and must be thread-safe. Falls back to `ll_map` when there is nothing to share,
+ * and makes do with the threads it could start.
+ *
+ * @param list - the linked list
+ * @param f - the function to call on the values
+ * @param nthreads - the number of threads calling `f`
+ */
+void ll_map_parallel(ll_t *list, gen_fun_t f, int nthreads) {
+    ll_map_job_t job;
+    pthread_t *threads = NULL;
+    int started = 0;
+    size_t per;
+
+    STAT_ADD(list, LL_STAT_MAPS, 1);
+    CHECK_VALID(list, list->lock_mode == LL_LOCK_NODES ? l_read : l_write, );
+    if (nthreads > LEN(list))
+        nthreads = LEN(list);
+    job.starts = NULL;
+    if (nthreads > 1) {
+        per = ((size_t)LEN(list) + (size_t)nthreads * LL_MAP_SEGS_PER_THREAD - 1) /
+              ((size_t)nthreads * LL_MAP_SEGS_PER_THREAD);
+        if (list->storage == LL_STORAGE_UNROLLED)
+            per = per / LL_BLOCK_VALS + 1;
+        job.seg_len = per;
+        job.starts = _ll_map_segments(list, per, &job.nsegs);
+        threads = (pthread_t *)malloc((size_t)(nthreads - 1) * sizeof(pthread_t));
+    }
+    if (job.starts == NULL || threads == NULL) {
+        _ll_map_internal(list, f);
+        RWUNLOCK(list);
+        free(job.starts);
+        free(threads);
+        return;
+    }
+
+    job.list = list;
+    job.f = f;
+    atomic_init(&job.next, 0);
+    for (; started < nthreads - 1; started++) {
+        if (pthread_create(&threads[started], NULL, _ll_map_worker, &job))
+            break;
+    }
+    _ll_map_worker(&job);
+    while (started > 0)
+        pthread_join(threads[--started], NULL);
+    RWUNLOCK(list);
+
+    free(job.starts);
+    free(threads);
+}
+
+/**
+ * @function ll_print
+ *
+ * If `val_printer` has been set on the linked list, that function is called on the values
+ * of all the elements of the linked list.
+ *
+ * @param list - the linked list
+ */
+void ll_print(ll_t list) {
+    int len = -1;
+
+    CHECK_VALID((&list), l_read, );
+    len = list.len;
+
+    if (list.val_printer != NULL) {
+        printf("(ll:");
+        _ll_map_internal(&list, list.val_printer);
+        printf("), length: %d\n", len);
+    }
+    RWUNLOCK((&list));
+}
+
+/**
+ * @function ll_no_teardown
+ *
+ * A generic taredown function for values that don't need anything done.
+ *
+ * @param n - a pointer
+ */
+void ll_no_teardown(void *n) {
+    n += 0; // compiler won't let me just return
+}
+
+
+/**
+ * @function ll_find
+ *
+ * Generically searches for the first node that matches a reference value.
+ * `LL_LOCK_RCU` lists are walked without locking (see `ll_get_n`).
+ *
+ * @param list - the linked list
+ * @param comparator - a function that will be called on the values of each node. (It should return 0 when the element matches the reference value)
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns pointer to value of the first matching node on success, NULL otherwise
+ */
+void* ll_find(ll_t *list, comp_fun_t comparator, const void *ref_value) {
+    int count = 0;
+
+    STAT_ADD(list, LL_STAT_LOOKUPS, 1);
+    if (list->lock_mode == LL_LOCK_RCU && ll_epoch_enter() == 0) {
+        ll_node_t *node = NULL;
+        if (list->valid_flag == VALID) {
+            node = RCU_DEREF(list->hd);
+            while (node != NULL && comparator(node->val, ref_value) != 0) {
+                node = RCU_DEREF(node->nxt);
+                count++;
+            }
+        }
+        STAT_ADD(list, LL_STAT_WALKS, 1);
+        STAT_ADD(list, LL_STAT_WALK_STEPS, count);
+        void *val = node == NULL ? NULL : node->val;
+        ll_epoch_exit();
+        return val;
+    }
+
+    CHECK_VALID(list, l_read, NULL);
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        void *val = NULL;
+        llu_find(list, comparator, ref_value, NULL, 0, &val);
+        RWUNLOCK(list);
+        return val;
+    }
+    if (list->hash != NULL && comparator == ll_hash_comparator(list->hash)) {
+        void *prev;
+        ll_node_t *found = (ll_node_t *)ll_hash_find(list->hash, ref_value, &prev);
+        void *val = found == NULL ? NULL : found->val;
+        RWUNLOCK(list);
+        return val;
+    }
+    ll_node_t *node = list->hd;
+    while ((node != NULL) && (comparator(node->val, ref_value) != 0)) {
+        node = node->nxt;
+        count++;
+    }
+    RWUNLOCK(list);
+    STAT_ADD(list, LL_STAT_WALKS, 1);
+    STAT_ADD(list, LL_STAT_WALK_STEPS, count);
+
+    return (node == NULL)? NULL : node->val;
+}
+
+/**
+ * @function ll_find_sorted
+ *
+ * Searches a sorted list for the first value that sorts with `key`, stopping at the first
+ * one sorting after it: misses cost half a walk on average, rather than a full one.
+ * `LL_LOCK_RCU` lists are walked without locking (see `ll_get_n`).
+ *
+ * @param list - the linked list, sorted
+ * @param key - reference value passed to the order of the list
+ *
+ * @returns pointer to the value found on success, NULL otherwise
+ */
+void *ll_find_sorted(ll_t *list, const void *key) {
+    ll_node_t *node;
+    int cmp = 1;
+
+    if (list->order == NULL)
+        return NULL;
+    STAT_ADD(list, LL_STAT_LOOKUPS, 1);
+    if (list->lock_mode == LL_LOCK_RCU && ll_epoch_enter() == 0) {
+        void *val = NULL;
+        if (list->valid_flag == VALID) {
+            node = RCU_DEREF(list->hd);
+            while (node != NULL && (cmp = list->order(node->val, key)) < 0)
+                node = RCU_DEREF(node->nxt);
+            if (node != NULL && cmp == 0)
+                val = node->val;
+        }
+        ll_epoch_exit();
+        return val;
+    }
+
+    CHECK_VALID(list, l_read, NULL);
+    node = list->hd;
+    while (node != NULL && (cmp = list->order(node->val, key)) < 0)
+        node = node->nxt;
+    RWUNLOCK(list);
+
+    return node == NULL || cmp != 0 ? NULL : node->val;
+}
+
+/**
+ * @function ll_find_key
+ *
+ * Searches a keyed list for the first value whose key is `key`, comparing the keys kept in
+ * the blocks several at a time instead of calling a comparator on every value.
+ *
+ * @param list - the linked list
+ * @param key - the key looked for
+ *
+ * @returns the first value with that key, `NULL` if there is none
+ */
+void *ll_find_key(ll_t *list, int64_t key) {
+    void *val = NULL;
+
+    if (list->key_of == NULL)
+        return NULL;
+    STAT_ADD(list, LL_STAT_LOOKUPS, 1);
+    CHECK_VALID(list, l_read, NULL);
+    llu_find_key(list, key, &val);
+    RWUNLOCK(list);
+
+    return val;
+}
+
+/**
+ * @function _ll_copy_chain
+ *
+ * Chains new nodes of `list` holding the values of `src`, in order, `src` being read
+ * locked for the whole copy.
+ *
+ * @param list - the linked list the nodes are for
+ * @param src - the linked list copied
+ * @param first - set to the first node of the chain, `NULL` if `src` is empty
+ * @param last - set to the last node of the chain
+ *
+ * @returns the number of nodes in the chain on success, -1 otherwise
+ */
+static int _ll_copy_chain(ll_t *list, ll_t *src, ll_node_t **first, ll_node_t **last) {
+    ll_node_t **link = first;
+    ll_iter_t it;
+    void *val;
+    int n = 0;
+
+    *first = *last = NULL;
+    if (ll_iter_begin(src, &it, 0))
+        return -1;
+    while (ll_iter_next(&it, &val)) {
+        ll_node_t *node = ll_new_node(list, val);
+        if (node == NULL) {
+            ll_iter_end(&it);
+            if (n > 0)
+                ll_free_chain(list, *first, *last, (size_t)n);
+            return -1;
+        }
+        *link = *last = node;
+        link = &node->nxt;
+        n++;
+    }
+    ll_iter_end(&it);
+
+    return n;
+}
+
+/**
+ * @function ll_merge
+ *
+ * Merges two sorted lists into a new one. Each is copied under a single read lock, one
+ * after the other (holding both at once could deadlock against another merge of the same
+ * lists, the other way round), and the copies are then merged by relinking their nodes.
+ * Equal values of `a` come before those of `b`.
+ *
+ * @param a - a sorted linked list
+ * @param b - a sorted linked list, in the same order
+ * @param opts - the options of the merged list, in the same order
+ *
+ * @returns the merged list on success, NULL otherwise
+ */
+ll_t *ll_merge(ll_t *a, ll_t *b, const ll_opts_t *opts) {
+    ll_node_t *first[2];
+    ll_node_t *last[2];
+    ll_node_t *merged = NULL;
+    ll_node_t **link = &merged;
+    int len[2];
+
+    if (a->order == NULL || a->order != b->order || opts->order != a->order)
+        return NULL;
+    ll_t *list = ll_new_ex(opts);
+    if (list == NULL)
+        return NULL;
+    if ((len[0] = _ll_copy_chain(list, a, &first[0], &last[0])) < 0 ||
+        (len[1] = _ll_copy_chain(list, b, &first[1], &last[1])) < 0) {
+        if (len[0] > 0)
+            ll_free_chain(list, first[0], last[0], (size_t)len[0]);
+        ll_delete(list);
+        return NULL;
+    }
+    if (len[0] + len[1] == 0)
+        return list;
+    if (_ll_full(list, (size_t)(len[0] + len[1]))) {
+        if (len[0] > 0)
+            ll_free_chain(list, first[0], last[0], (size_t)len[0]);
+        if (len[1] > 0)
+            ll_free_chain(list, first[1], last[1], (size_t)len[1]);
+        ll_delete(list);
+        return NULL;
+    }
+
+    ll_node_t *x = first[0];
+    ll_node_t *y = first[1];
+    while (x != NULL && y != NULL) {
+        if (list->order(y->val, x->val) < 0) {
+            *link = y;
+            y = y->nxt;
+        } else {
+            *link = x;
+            x = x->nxt;
+        }
+        link = &(*link)->nxt;
+    }
+    *link = x != NULL ? x : y;
+
+    // nobody else knows of the list yet, but linking keeps its indexes right
+    RWLOCK(list, l_write);
+    _ll_link_chain_after(list, NULL, 0, merged, y == NULL ? last[0] : last[1],
+                         len[0] + len[1]);
+    RWUNLOCK(list);
+
+    return list;
+}
+
+/**
+ * @function _ll_lock_pair
+ *
+ * Write locks two distinct lists in the order of their addresses, which every thread
+ * locking two lists follows, so that moves between them both ways can't deadlock.
+ *
+ * @param a - a linked list
+ * @param b - another linked list
+ *
+ * @returns 0 if both lists are valid (and left locked), -1 otherwise (nothing locked)
+ */
+static int _ll_lock_pair(ll_t *a, ll_t *b) {
+    ll_t *first = (uintptr_t)a < (uintptr_t)b ? a : b;
+    ll_t *second = first == a ? b : a;
+
+    RWLOCK(first, l_write);
+    RWLOCK(second, l_write);
+    if (a->valid_flag != VALID || b->valid_flag != VALID) {
+        RWUNLOCK(second);
+        RWUNLOCK(first);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @function _ll_node_at
+ *
+ * Finds the node at position `n` of a locked list, through its positional index if it
+ * has one.
+ *
+ * @param list - the linked list
+ * @param n - the position, less than the length of the list
+ *
+ * @returns the node
+ */
+static ll_node_t *_ll_node_at(ll_t *list, int n) {
+    ll_node_t *node = list->hd;
+
+    if (n == LEN(list) - 1)
+        return list->tl;
+    if (list->index != NULL)
+        return (ll_node_t *)ll_index_get(list->index, n);
+    for (; n > 0; n--)
+        node = node->nxt;
+
+    return node;
+}
+
+/**
+ * @function _ll_splice
+ *
+ * `ll_splice`, `count` being -1 for all the values from `from` on. Holding the write lock
+ * of both lists keeps everybody off their nodes, which aren't locked.
+ *
+ * @param dst - the linked list the values move to
+ * @param pos - where they go in `dst`, -1 for the end
+ * @param src - the linked list the values come from
+ * @param from - the position of the first value in `src`
+ * @param count - the number of values, -1 for the rest of `src`
+ *
+ * @returns the new length of `dst` on success, -1 otherwise
+ */
+static int _ll_splice(ll_t *dst, int pos, ll_t *src, int from, int count) {
+    ll_node_t *prev;
+    ll_node_t *first;
+    ll_node_t *last;
+    int new_len;
+
+    if (dst == src || dst->storage != LL_STORAGE_NODES || src->storage != LL_STORAGE_NODES ||
+        dst->lock_mode != src->lock_mode || dst->lock_mode == LL_LOCK_RCU ||
+        dst->doubly_linked != src->doubly_linked || dst->pool != src->pool ||
+        dst->order != NULL || pos < -1 || from < 0 || count < -1)
+        return -1;
+    if (_ll_lock_pair(dst, src))
+        return -1;
+    if (count == -1)
+        count = LEN(src) - from;
+    if (dst->closed || count < 0 || from + count > LEN(src) || pos > LEN(dst) ||
+        _ll_full(dst, (size_t)count)) {
+        RWUNLOCK(src);
+        RWUNLOCK(dst);
+        return -1;
+    }
+    if (count > 0) {
+        prev = from == 0 ? NULL : _ll_node_at(src, from - 1);
+        first = prev == NULL ? src->hd : prev->nxt;
+        last = from + count == LEN(src) ? src->tl : _ll_node_at(src, from + count - 1);
+        _ll_unlink_chain_after(src, prev, from, last, count);
+
+        if (pos == -1)
+            pos = LEN(dst);
+        prev = pos == 0 ? NULL : _ll_node_at(dst, pos - 1);
+        _ll_link_chain_after(dst, prev, pos, first, last, count);
+    }
+    new_len = LEN(dst);
+    RWUNLOCK(src);
+    RWUNLOCK(dst);
+    if (count > 0)
+        _ll_wake_waiters(dst, count);
+
+    return new_len;
+}
+
+/**
+ * @function ll_splice
+ *
+ * Moves a range of values from a list to another by relinking their nodes: it costs a
+ * walk to both ends of the range and to `pos`, rather than an allocation, a free and
+ * two lock cycles per value.
+ *
+ * @param dst - the linked list the values move to
+ * @param pos - where they go in `dst`, -1 for the end
+ * @param src - the linked list the values come from
+ * @param from - the position of the first value in `src`
+ * @param count - the number of values
+ *
+ * @returns the new length of `dst` on success, -1 otherwise
+ */
+int ll_splice(ll_t *dst, int pos, ll_t *src, int from, int count) {
+    if (count < 0)
+        return -1;
+
+    return _ll_splice(dst, pos, src, from, count);
+}
+
+/**
+ * @function ll_concat
+ *
+ * Moves all the values of `src` to the end of `dst`. Both ends of the chain are known, so
+ * this is constant time (the indexes aside).
+ *
+ * @param dst - the linked list the values move to
+ * @param src - the linked list the values come from, left empty
+ *
+ * @returns the new length of `dst` on success, -1 otherwise
+ */
+int ll_concat(ll_t *dst, ll_t *src) {
+    return _ll_splice(dst, -1, src, 0, -1);
+}
+
+/**
+ * @function ll_split
+ *
+ * Moves the tail of a list, from position `n` on, to a new list with the same settings.
+ * The lists share the node pool of `list`, so that values can keep moving between them.
+ * Neither the hash index (see `ll_set_index`) nor `priorities` carry over: the tail is a
+ * plain list whose values keep their order, whatever level they had.
+ *
+ * @param list - the linked list
+ * @param n - the position of the first value moved, up to the length of `list`
+ *
+ * @returns the new list on success, NULL otherwise
+ */
+ll_t *ll_split(ll_t *list, int n) {
+    ll_opts_t opts = {0};
+    ll_t *tail;
+
+    if (n < 0 || list->storage != LL_STORAGE_NODES || list->lock_mode == LL_LOCK_RCU)
+        return NULL;
+    opts.val_teardown = list->val_teardown;
+    opts.lock_mode = list->lock_mode;
+    opts.lock_backend = list->m.backend;
+    opts.pos_index = list->index != NULL;
+    opts.async_teardown = list->reclaimer != NULL;
+    opts.doubly_linked = list->doubly_linked;
+    opts.capacity = list->capacity;
+    if ((tail = ll_new_ex(&opts)) == NULL)
+        return NULL;
+    if (list->pool != NULL)
+        tail->pool = ll_pool_ref(list->pool);
+    if (_ll_splice(tail, 0, list, n, -1) < 0) {
+        ll_delete(tail);
+        return NULL;
+    }
+    tail->order = list->order; // set last, sorted lists don't take spliced values
+
+    return tail;
+}
+
+
+/**
+ * @function ll_remove_find
+ *
+ * More generic replacement for ll_remove_search().
+ *
+ * @param list - the linked list
+ * @param comparator - see ll_find() for details on comparator
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns the new length of thew linked list on success, -1 otherwise
+ */
+int ll_remove_find(ll_t *list, comp_fun_t comparator, const void *ref_value) {
+    if (list->storage == LL_STORAGE_UNROLLED)
+        return _ll_unrolled_remove(list, 0, comparator, ref_value, NULL);
+
+    int new_len = -1;
+    ll_node_t *last = NULL;
+    CHECK_VALID(list, l_write, -1);
+    ll_node_t *node = list->hd;
+    int pos = 0;
+
+    // the hash index doesn't know positions, which the positional one and levels need
+    if (list->hash != NULL && list->index == NULL && list->levels == NULL &&
+        comparator == ll_hash_comparator(list->hash)) {
+        void *prev = NULL;
+        node = (ll_node_t *)ll_hash_find(list->hash, ref_value, &prev);
+        last = (ll_node_t *)prev;
+    } else {
+        while ((node != NULL) && (comparator(node->val, ref_value) != 0)) {
+            last = node;
+            node = node->nxt;
+            pos++;
+        }
+    }
+
+    if (node == NULL) {
+        RWUNLOCK(list);
+        return -1;
+    } else if (node == list->hd) {
+        _ll_unlink_after(list, NULL, 0, node);
+    } else {
+        NODE_RWLOCK(list, last, l_write);
+        _ll_unlink_after(list, last, pos, node);
+        NODE_RWUNLOCK(list, last);
+    }
+
+    if (_ll_retire_chain(list, node, 1, 1) != NULL)
+        ll_free_node(list, node);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+
+
+
+
+
+/**
+ * @function ll_iter_begin
+ *
+ * Locks the list for an iteration. A read iterator lets other readers in; write ones
+ * exclude everybody, as their removals change the structure of the list.
+ *
+ * @param list - the linked list
+ * @param it - the iterator to set up
+ * @param write - whether values are to be removed
+ *
+ * @returns 0 if successful, -1 if the list is invalid
+ */
+int ll_iter_begin(ll_t *list, ll_iter_t *it, int write) {
+    CHECK_VALID(list, write ? l_write : l_read, -1);
+    it->list = list;
+    it->write = write;
+    it->cur = NULL;
+    it->prev = NULL;
+    it->idx = 0;
+    it->pos = 0;
+    it->state = 0;
+
+    return 0;
+}
+
+/**
+ * @function ll_iter_next
+ *
+ * Moves the iterator one value forward, locking nodes hand over hand like
+ * `ll_select_n_min_1()` does: the next node is locked before the current one is released,
+ * and the value handed out stays locked until the following call.
+ *
+ * @param it - the iterator
+ * @param val - set to the next value
+ *
+ * @returns 1 if there was a next value, 0 at the end
+ */
+int ll_iter_next(ll_iter_t *it, void **val) {
+    ll_t *list = it->list;
+    ll_node_t *next;
+
+    if (it->state == 3)
+        return 0;
+
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        if (it->state == 0) {
+            it->blk = list->bhd;
+        } else if (it->state == 1) {
+            it->idx++;
+            it->pos++;
+        }
+        it->state = llu_iter_next(&it->bprev, &it->blk, &it->idx, val) ? 1 : 3;
+        return it->state == 1;
+    }
+
+    if (it->state == 0)
+        next = list->hd;
+    else if (it->state == 1)
+        next = it->cur->nxt;
+    else // the current node was removed
+        next = it->prev == NULL ? list->hd : it->prev->nxt;
+
+    if (next != NULL)
+        NODE_RWLOCK(list, next, it->write ? l_write : l_read);
+    if (it->state == 1) {
+        NODE_RWUNLOCK(list, it->cur);
+        it->prev = it->cur;
+        it->pos++;
+    }
+    it->cur = next;
+    if (next == NULL) {
+        it->state = 3;
+        return 0;
+    }
+    it->state = 1;
+    *val = next->val;
+
+    return 1;
+}
+
+/**
+ * @function ll_iter_remove
+ *
+ * Unlinks the current value, tears it down and frees its node.
+ *
+ * @param it - the iterator
+ *
+ * @returns the new length of the linked list on success, -1 otherwise
+ */
+int ll_iter_remove(ll_iter_t *it) {
+    ll_t *list = it->list;
+    ll_node_t *node = it->cur;
+    void *val;
+
+    if (!it->write || it->state != 1)
+        return -1;
+
+    it->state = 2;
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        val = llu_iter_remove(list, it->bprev, &it->blk, &it->idx);
+        _ll_teardown(list, val);
+        return LEN(list);
+    }
+
+    NODE_RWUNLOCK(list, node); // never lock backwards, the list write lock is enough
+    if (it->prev == NULL) {
+        _ll_unlink_after(list, NULL, it->pos, node);
+    } else {
+        NODE_RWLOCK(list, it->prev, l_write);
+        _ll_unlink_after(list, it->prev, it->pos, node);
+        NODE_RWUNLOCK(list, it->prev);
+    }
+    if (_ll_retire_chain(list, node, 1, 1) != NULL)
+        ll_free_node(list, node);
+    it->cur = NULL;
+
+    return LEN(list);
+}
+
+/**
+ * @function ll_iter_end
+ *
+ * Releases the node the iterator is on, if any, and the list.
+ *
+ * @param it - the iterator
+ */
+void ll_iter_end(ll_iter_t *it) {
+    ll_t *list = it->list;
+
+    if (it->state == 1 && list->storage == LL_STORAGE_NODES)
+        NODE_RWUNLOCK(list, it->cur);
+    it->state = 3;
+    RWUNLOCK(list);
+}
+
+/**
+ * @function _ll_snapshots_of
+ *
+ * Returns what the snapshots of a list share, setting it up the first time.
+ *
+ * @param list - the linked list
+ *
+ * @returns the `struct ll_snapshots` of the list, `NULL` if out of memory
+ */
+static struct ll_snapshots *_ll_snapshots_of(ll_t *list) {
+    struct ll_snapshots *s = __atomic_load_n(&list->snaps, __ATOMIC_ACQUIRE);
+    struct ll_snapshots *none = NULL;
+    ll_opts_t opts = {0};
+
+    if (s != NULL)
+        return s;
+    if ((s = (struct ll_snapshots *)malloc(sizeof(struct ll_snapshots))) == NULL)
+        return NULL;
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = LL_LOCK_LIST;
+    if ((s->held = ll_new_ex(&opts)) == NULL) {
+        free(s);
+        return NULL;
+    }
+    pthread_mutex_init(&s->m, NULL);
+    atomic_init(&s->count, 0);
+    if (!__atomic_compare_exchange_n(&list->snaps, &none, s, 0, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) { // another snapshot beat us to it
+        ll_delete(s->held);
+        pthread_mutex_destroy(&s->m);
+        free(s);
+        s = none;
+    }
+
+    return s;
+}
+
+/**
+ * @function ll_snapshot
+ *
+ * Copies the values of the list into a snapshot, with a single walk under the read lock.
+ * The snapshot is counted before the list is unlocked, so that the values it holds are
+ * not torn down until it is released, whenever they are removed.
+ *
+ * @param list - the linked list
+ *
+ * @returns the snapshot, `NULL` if unsuccessful
+ */
+ll_snapshot_t *ll_snapshot(ll_t *list) {
+    struct ll_snapshots *s;
+    ll_snapshot_t *snap = NULL;
+    int cap = ll_length(list);
+    void *val;
+
+    if (cap < 0 || (s = _ll_snapshots_of(list)) == NULL) // cleared lists get none
+        return NULL;
+    for (;;) { // the array is sized before locking, with room for the list to grow a bit
+        cap = (cap < 0 ? 0 : cap) + cap / 8 + 16;
+        free(snap);
+        snap = (ll_snapshot_t *)malloc(sizeof(ll_snapshot_t) + cap * sizeof(void *));
+        if (snap == NULL)
+            return NULL;
+        CHECK_VALID(list, l_read, (free(snap), NULL));
+        if (LEN(list) <= cap)
+            break;
+        cap = LEN(list);
+        RWUNLOCK(list);
+    }
+
+    pthread_mutex_lock(&s->m);
+    atomic_fetch_add(&s->count, 1);
+    pthread_mutex_unlock(&s->m);
+    snap->list = list;
+    snap->len = 0;
+    if (list->storage == LL_STORAGE_UNROLLED) {
+        ll_block_t *prev = NULL;
+        ll_block_t *block = list->bhd;
+        int idx = 0;
+        while (llu_iter_next(&prev, &block, &idx, &val)) {
+            snap->vals[snap->len++] = val;
+            idx++;
+        }
+    } else {
+        ll_node_t *node;
+        for (node = list->hd; node != NULL; node = node->nxt)
+            snap->vals[snap->len++] = node->val;
+    }
+    RWUNLOCK(list);
+
+    return snap;
+}
+
+/**
+ * @function ll_snapshot_length
+ *
+ * @param snap - the snapshot
+ *
+ * @returns the number of values in the snapshot
+ */
+int ll_snapshot_length(const ll_snapshot_t *snap) {
+    return snap->len;
+}
+
+/**
+ * @function ll_snapshot_get_n
+ *
+ * @param snap - the snapshot
+ * @param n - the position of the value
+ *
+ * @returns the value at position `n`, `NULL` if out of range
+ */
+void *ll_snapshot_get_n(const ll_snapshot_t *snap, int n) {
+    return n < 0 || n >= snap->len ? NULL : snap->vals[n];
+}
+
+/**
+ * @function ll_snapshot_map
+ *
+ * Runs `f` on the values of the snapshot, without locking anything.
+ *
+ * @param snap - the snapshot
+ * @param f - the function
+ */
+void ll_snapshot_map(const ll_snapshot_t *snap, gen_fun_t f) {
+    int i;
+
+    for (i = 0; i < snap->len; i++)
+        f(snap->vals[i]);
+}
+
+/**
+ * @function ll_snapshot_release
+ *
+ * Releases a snapshot. The last one out tears down the values held for the snapshots,
+ * under the mutex they share so that a snapshot taken meanwhile doesn't see them go.
+ *
+ * @param snap - the snapshot
+ */
+void ll_snapshot_release(ll_snapshot_t *snap) {
+    struct ll_snapshots *s = snap->list->snaps;
+    void *vals[LL_RECLAIM_BATCH];
+    int i, n;
+
+    pthread_mutex_lock(&s->m);
+    if (atomic_fetch_sub(&s->count, 1) == 1) {
+        while ((n = ll_pop_many(s->held, vals, LL_RECLAIM_BATCH)) > 0)
+            for (i = 0; i < n; i++)
+                _ll_teardown(snap->list, vals[i]); // not held anymore, `count` is 0
+    }
+    pthread_mutex_unlock(&s->m);
+    free(snap);
+}
+
+/**
+ * @function ll_set_index
+ *
+ * Builds a hash index of the values currently in the list and attaches it, replacing the
+ * previous one if any. From then on, the insertion and removal paths keep it in sync and
+ * `ll_find()`/`ll_remove_find()` use it whenever they are given `comparator`.
+ *
+ * @param list - the linked list
+ * @param hash - hashes the values, `NULL` to drop the index
+ * @param comparator - see `ll_find()`
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int ll_set_index(ll_t *list, hash_fun_t hash, comp_fun_t comparator) {
+    ll_hash_t *table = NULL;
+
+    CHECK_VALID(list, l_write, -1);
+    if (hash != NULL) {
+        if (list->storage != LL_STORAGE_NODES || list->lock_mode == LL_LOCK_RCU ||
+            comparator == NULL ||
+            (table = ll_hash_new(hash, comparator)) == NULL) {
+            RWUNLOCK(list);
+            return -1;
+        }
+        ll_node_t *prev = NULL;
+        ll_node_t *node;
+        for (node = list->hd; node != NULL; prev = node, node = node->nxt) {
+            if (ll_hash_insert(table, node->val, node, prev)) {
+                ll_hash_delete(table);
+                RWUNLOCK(list);
+                return -1;
+            }
+        }
+    }
+    if (list->hash != NULL)
+        ll_hash_delete(list->hash);
+    list->hash = table;
+    RWUNLOCK(list);
+
+    return 0;
+}
+
+/**
+ * @function ll_synchronize
+ *
+ * Waits for a grace period, without holding the list lock (readers in their critical
+ * sections may be waiting for it), then reclaims everything the list retired before
+ * (waiting for the values to be torn down, with `async_teardown`).
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 if the list is invalid or if called from a read-side
+ * critical section
+ */
+int ll_synchronize(ll_t *list) {
+    if (list->lock_mode == LL_LOCK_RCU && ll_epoch_wait())
+        return -1;
+    CHECK_VALID(list, l_write, -1);
+    if (list->epoch != NULL)
+        ll_epoch_collect(list->epoch);
+    RWUNLOCK(list);
+
+    return ll_flush_teardowns(list);
+}
+
+/**
+ * @function ll_flush_teardowns
+ *
+ * Waits for the background thread to catch up with the values queued so far, tearing
+ * down the ones still in the queue meanwhile rather than just waiting.
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 if the list is invalid
+ */
+int ll_flush_teardowns(ll_t *list) {
+    struct ll_reclaimer *r;
+    unsigned long target;
+
+    CHECK_VALID(list, l_read, -1);
+    r = list->reclaimer;
+    RWUNLOCK(list);
+    if (r == NULL)
+        return 0;
+
+    target = atomic_load(&r->queued);
+    while (atomic_load(&r->torn) < target) {
+        void *val;
+        if (ll_pop_many(r->queue, &val, 1) == 1)
+            atomic_fetch_add(&r->torn, _ll_reclaim(r, val));
+        else
+            sched_yield();
+    }
+
+    return 0;
+}
+
+/**
+ * @function ll_pool_stats
+ *
+ * Reports the state of the node pool of a linked list.
+ *
+ * @param list - the linked list
+ * @param stats - filled with the pool statistics
+ *
+ * @returns 0 if successful, -1 if the list is invalid or doesn't use a pool
+ */
+int ll_pool_stats(ll_t *list, ll_pool_stats_t *stats) {
+    CHECK_VALID(list, l_read, -1);
+    if (list->pool == NULL) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    ll_pool_get_stats(list->pool, stats);
+    RWUNLOCK(list);
+
+    return 0;
+}
+
+/**
+ * @function ll_stats
+ *
+ * Reports the instrumentation counters of a linked list. They are read without locking
+ * the list, which they would otherwise account for.
+ *
+ * @param list - the linked list
+ * @param stats - filled with the counters
+ *
+ * @returns 0 if successful, -1 if the library isn't built with `LL_STATS`
+ */
+int ll_stats(ll_t *list, ll_stats_t *stats) {
+    if (list->stats == NULL)
+        return -1;
+    ll_counters_read(list->stats, stats);
+
+    return 0;
+}
+
+/**
+ * @function ll_stats_reset
+ *
+ * Zeroes the instrumentation counters of a linked list, for the next `ll_stats()` to
+ * report what happened since.
+ *
+ * @param list - the linked list
+ *
+ * @returns 0 if successful, -1 if the library isn't built with `LL_STATS`
+ */
+int ll_stats_reset(ll_t *list) {
+    if (list->stats == NULL)
+        return -1;
+    ll_counters_reset(list->stats);
+
+    return 0;
+}
+
+#ifdef LL
+/* this following code is just for testing this library */
+
+#include <fcntl.h>
+#include <poll.h>
+
+#include "ll_tmpl.h"
+
+void num_teardown(void *n) {
+    *(int *)n *= -1; // just so we can visually inspect removals afterwards
+}
+
+void num_printer(void *n) {
+    printf(" %d", *(int *)n);
+}
+
+int num_equals_3(void *n) {
+    return *(int *)n == 3;
+}
+
+int num_equals(const void *n, const void *ref) {
+    return *(const int *)n - *(const int *)ref;
+}
+
+size_t num_hash(const void *n) {
+    return (size_t)*(const int *)n;
+}
+
+static int test_count = 1;
+static int fail_count = 0;
+
+// checks that `got` is `expected` and reports the result the same way `main()` does
+static void expect_int(int expected, int got) {
+    if (expected != got) {
+        fprintf(stderr, "FAIL Test %d: Expected %d, but got %d.\n", test_count, expected, got);
+        fail_count++;
+    } else
+        fprintf(stderr, "PASS Test %d!\n", test_count);
+    test_count++;
+}
+
+// the tail pointer must follow every mutator, appending after each of them
+static void test_tail(void) {
+    int v[6] = {0, 1, 2, 3, 4, 5};
+    ll_t *list = ll_new(ll_no_teardown);
+
+    expect_int(-1, ll_remove_n(list, 0));       // empty list
+    expect_int(1, ll_insert_last(list, &v[0])); // (0)
+    expect_int(2, ll_insert_n(list, &v[1], 1)); // (0 1), appended through ll_insert_n
+    expect_int(3, ll_insert_last(list, &v[2])); // (0 1 2)
+    expect_int(2, *(int *)ll_get_n(list, 2));
+    expect_int(-1, ll_remove_n(list, 3));       // out of range
+    expect_int(2, ll_remove_n(list, 2));        // (0 1), tail removed by index
+    expect_int(3, ll_insert_last(list, &v[3])); // (0 1 3)
+    expect_int(3, *(int *)ll_get_n(list, 2));
+    expect_int(2, ll_remove_find(list, num_equals, &v[3])); // (0 1), tail removed by search
+    expect_int(-1, ll_remove_find(list, num_equals, &v[3])); // not found, list unlocked
+    expect_int(3, ll_insert_last(list, &v[4]));             // (0 1 4)
+    expect_int(4, *(int *)ll_get_n(list, 2));
+    ll_pop_first(list);
+    ll_pop_first(list);
+    ll_pop_first(list);                         // ()
+    expect_int(0, ll_length(list));
+    expect_int(1, ll_insert_last(list, &v[5])); // (5)
+    expect_int(5, *(int *)ll_get_first(list));
+
+    ll_delete(list);
+}
+
+// nodes must come from (and go back to) the pool, which only grows when it runs dry
+static void test_pool(void) {
+    int v[5] = {0, 1, 2, 3, 4};
+    int i;
+    ll_pool_stats_t stats;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = 4;
+
+    ll_t *list = ll_new_ex(&opts);
+    ll_t *plain = ll_new(ll_no_teardown);
+    expect_int(-1, ll_pool_stats(plain, &stats)); // no pool
+    ll_delete(plain);
+
+    expect_int(0, ll_pool_stats(list, &stats));
+    expect_int(1, stats.slabs);                   // first slab is preallocated
+    expect_int(4, stats.free);
+    for (i = 0; i < 5; i++)
+        ll_insert_last(list, &v[i]);              // (0 1 2 3 4), needs a second slab
+    ll_pool_stats(list, &stats);
+    expect_int(2, stats.slabs);
+    expect_int(5, stats.in_use);
+    expect_int(3, stats.free);
+    expect_int(0, *(int *)ll_pop_first(list));    // (1 2 3 4)
+    expect_int(3, ll_remove_n(list, 1));          // (1 3 4)
+    expect_int(2, ll_remove_find(list, num_equals, &v[4])); // (1 3)
+    for (i = 0; i < 3; i++)
+        ll_insert_first(list, &v[i]);             // (2 1 0 1 3), recycled nodes
+    ll_pool_stats(list, &stats);
+    expect_int(2, stats.slabs);
+    expect_int(5, stats.in_use);
+    expect_int(8, (int)(stats.gets - stats.puts + stats.free));
+    expect_int(2, *(int *)ll_get_first(list));
+    expect_int(3, *(int *)ll_get_n(list, 4));
+
+    ll_delete(list);
+}
+
+void num_increment(void *n) {
+    (*(int *)n)++;
+}
+
+// lists with nothing but the list lock must behave like the others
+static void test_lock_list(size_t pool_slab_nodes) {
+    int v[4] = {0, 1, 2, 3};
+    int sum = 0;
+    int i;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = pool_slab_nodes;
+    opts.lock_mode = LL_LOCK_LIST;
+
+    ll_t *list = ll_new_ex(&opts);
+    expect_int(1, ll_insert_last(list, &v[1]));  // (1)
+    expect_int(2, ll_insert_first(list, &v[0])); // (0 1)
+    expect_int(3, ll_insert_n(list, &v[3], 2));  // (0 1 3)
+    expect_int(4, ll_insert_n(list, &v[2], 2));  // (0 1 2 3)
+    for (i = 0; i < 4; i++)
+        sum += *(int *)ll_get_n(list, i) == i;
+    expect_int(4, sum);
+    ll_map(list, num_increment);                 // (1 2 3 4)
+    expect_int(4, *(int *)ll_find(list, num_equals, &v[3]));
+    expect_int(3, ll_remove_n(list, 3));         // (1 2 3)
+    expect_int(2, ll_remove_find(list, num_equals, &v[1])); // (1 3)
+    expect_int(1, *(int *)ll_pop_first(list));   // (3)
+    expect_int(3, *(int *)ll_get_first(list));
+
+    ll_delete(list);
+    opts.lock_mode = 3;
+    expect_int(1, ll_new_ex(&opts) == NULL);     // unknown mode
+}
+
+// batches must land where asked, in order, whatever the node allocator and storage
+static void test_batch(size_t pool_slab_nodes, ll_storage_t storage) {
+    int v[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    void *vals[8];
+    void *out[8];
+    int i, in_order = 0;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = pool_slab_nodes;
+    opts.storage = storage;
+
+    for (i = 0; i < 8; i++)
+        vals[i] = &v[i];
+    ll_t *list = ll_new_ex(&opts);
+    expect_int(2, ll_insert_many(list, &vals[3], 2, 0));  // (3 4)
+    expect_int(3, ll_insert_many(list, &vals[0], 3, 0));  // (0 1 2 3 4)
+    expect_int(2, ll_insert_many(list, &vals[6], 2, -1)); // (0 1 2 3 4 6 7)
+    expect_int(1, ll_insert_many(list, &vals[5], 1, 5));  // (0 1 2 3 4 5 6 7)
+    expect_int(-1, ll_insert_many(list, vals, 2, 9));     // out of range
+    expect_int(8, ll_length(list));
+    for (i = 0; i < 8; i++)
+        in_order += *(int *)ll_get_n(list, i) == i;
+    expect_int(8, in_order);
+
+    expect_int(3, ll_pop_many(list, out, 3));             // (3 4 5 6 7)
+    expect_int(2, *(int *)out[2]);
+    expect_int(5, ll_pop_many(list, out, 8));             // ()
+    expect_int(7, *(int *)out[4]);
+    expect_int(0, ll_pop_many(list, out, 8));
+    expect_int(1, ll_insert_last(list, &v[0]));           // tail was reset
+    expect_int(0, *(int *)ll_get_n(list, 0));
+
+    ll_clear(list);
+    expect_int(-1, ll_insert_many(list, vals, 3, -1));    // invalid list, nothing leaks
+    expect_int(-1, ll_pop_many(list, out, 3));
+    ll_delete(list);
+}
+
+// unrolled blocks split and merge, and the positional index rebalances, as values come
+// and go: check them against a plain array
+static void test_positions(ll_opts_t opts) {
+    enum { N = 1000 };
+    static int v[N + 3];
+    static int ref[N + 3];
+    void *batch[3];
+    void *out[2];
+    int ref_len = 0;
+    int i, j, in_order = 0, sum = 0;
+    opts.val_teardown = ll_no_teardown;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        int pos = (i * 7) % (ref_len + 1); // heads, tails and middles
+        v[i] = i;
+        for (j = ref_len; j > pos; j--)
+            ref[j] = ref[j - 1];
+        ref[pos] = i;
+        ref_len++;
+        if (ll_insert_n(list, &v[i], pos) != ref_len)
+            break;
+    }
+    expect_int(N, ll_length(list));
+    for (i = 0; i < N; i++)
+        in_order += *(int *)ll_get_n(list, i) == ref[i];
+    expect_int(N, in_order);
+
+    for (i = 0; i < N / 2; i++) {
+        int pos = (i * 13) % ref_len;
+        for (j = pos; j < ref_len - 1; j++)
+            ref[j] = ref[j + 1];
+        ref_len--;
+        if (ll_remove_n(list, pos) != ref_len)
+            break;
+    }
+    expect_int(N / 2, ll_length(list));
+    in_order = 0;
+    for (i = 0; i < ref_len; i++)
+        in_order += *(int *)ll_get_n(list, i) == ref[i];
+    expect_int(N / 2, in_order);
+    expect_int(-1, ll_remove_n(list, ref_len));    // out of range
+    expect_int(1, ll_get_n(list, ref_len) == NULL);
+
+    int mid = ref_len / 3;
+    for (i = 0; i < 3; i++) {                      // a batch in the middle...
+        int pos = mid + i;
+        v[N + i] = N + i;
+        batch[i] = &v[N + i];
+        for (j = ref_len; j > pos; j--)
+            ref[j] = ref[j - 1];
+        ref[pos] = N + i;
+        ref_len++;
+    }
+    expect_int(3, ll_insert_many(list, batch, 3, mid));
+    expect_int(2, ll_pop_many(list, out, 2));      // ...and one off the front
+    expect_int(ref[1], *(int *)out[1]);
+    for (j = 0; j < ref_len - 2; j++)
+        ref[j] = ref[j + 2];
+    ref_len -= 2;
+    in_order = 0;
+    for (i = 0; i < ref_len; i++)
+        in_order += *(int *)ll_get_n(list, i) == ref[i];
+    expect_int(ref_len, in_order);
+
+    expect_int(ref[ref_len - 1], *(int *)ll_find(list, num_equals, &ref[ref_len - 1]));
+    expect_int(ref_len - 1, ll_remove_find(list, num_equals, &ref[ref_len - 1]));
+    ref_len--;
+    ll_map(list, num_increment);
+    for (i = 0; i < ref_len; i++)
+        sum += *(int *)ll_get_n(list, i) == ref[i] + 1;
+    expect_int(ref_len, sum);
+    expect_int(ref[0] + 1, *(int *)ll_pop_first(list));
+    expect_int(ref_len - 2, ll_remove_first(list));
+    expect_int(ref_len - 1, ll_insert_last(list, &v[0]));
+    expect_int(0, *(int *)ll_get_n(list, ll_length(list) - 1));
+
+    ll_delete(list);
+    opts.storage = 2;
+    expect_int(1, ll_new_ex(&opts) == NULL);       // unknown storage
+    opts.storage = LL_STORAGE_UNROLLED;
+    opts.pos_index = 1;
+    expect_int(1, ll_new_ex(&opts) == NULL);       // blocks can't be indexed
+}
+
+// lookups through the hash index must agree with the list, whatever changed it
+static void test_hash(int pos_index) {
+    enum { N = 200 };
+    static int v[N];
+    void *batch[N / 2];
+    int i, key, found = 0, len_ok = 0;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.pos_index = pos_index;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++)
+        v[i] = i;
+    for (i = 0; i < N / 2; i++)
+        ll_insert_last(list, &v[i]);
+    expect_int(0, ll_set_index(list, num_hash, num_equals)); // indexes what is there...
+    for (i = 0; i < N / 2; i++)
+        batch[i] = &v[N / 2 + i];
+    expect_int(N / 2, ll_insert_many(list, batch, N / 2, 10)); // ...and what comes next
+    for (i = 0; i < N; i++)
+        found += ll_find(list, num_equals, &v[i]) == &v[i];
+    expect_int(N, found);
+
+    key = 150;
+    expect_int(N - 1, ll_remove_find(list, num_equals, &key));
+    expect_int(1, ll_find(list, num_equals, &key) == NULL);
+    expect_int(N - 2, ll_remove_n(list, 10));                // 100
+    expect_int(1, ll_find(list, num_equals, &v[100]) == NULL);
+    expect_int(0, *(int *)ll_pop_first(list));
+    expect_int(1, ll_find(list, num_equals, &v[0]) == NULL);
+
+    // scrambled removals: each one relies on the predecessor left by the previous ones
+    for (i = 0; i < N; i++) {
+        key = (i * 37) % N;
+        if (key == 0 || key == 100 || key == 150)
+            continue;
+        int new_len = ll_remove_find(list, num_equals, &key);
+        len_ok += new_len >= 0 && new_len == ll_length(list);
+    }
+    expect_int(N - 3, len_ok);
+    expect_int(1, ll_insert_last(list, &v[7]));              // tail was kept right
+    expect_int(7, *(int *)ll_find(list, num_equals, &v[7]));
+
+    expect_int(0, ll_set_index(list, NULL, NULL));           // back to walking
+    expect_int(7, *(int *)ll_find(list, num_equals, &v[7]));
+    ll_delete(list);
+
+    opts.pos_index = 0;
+    opts.storage = LL_STORAGE_UNROLLED;
+    list = ll_new_ex(&opts);
+    expect_int(-1, ll_set_index(list, num_hash, num_equals)); // no nodes to index
+    ll_delete(list);
+}
+
+int num_is_even(void *n) {
+    return *(int *)n % 2 == 0;
+}
+
+// cursors walk, stop early and filter in place whatever the list is made of
+static void test_iter(ll_opts_t opts) {
+    enum { N = 40 };
+    static int v[N];
+    void *val;
+    int i, seen = 0, in_order = 0;
+    ll_iter_t it;
+    opts.val_teardown = ll_no_teardown;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last(list, &v[i]);
+    }
+    expect_int(0, ll_iter_begin(list, &it, 0));
+    while (ll_iter_next(&it, &val))
+        in_order += *(int *)val == seen++;
+    expect_int(-1, ll_iter_remove(&it));           // read only
+    ll_iter_end(&it);
+    expect_int(N, in_order);
+
+    ll_iter_begin(list, &it, 0);                   // stopping early leaves nothing locked
+    ll_iter_next(&it, &val);
+    ll_iter_end(&it);
+    expect_int(N, ll_length(list));
+
+    ll_iter_begin(list, &it, 1);                   // drop the even values, in one pass
+    while (ll_iter_next(&it, &val)) {
+        if (num_is_even(val))
+            ll_iter_remove(&it);
+    }
+    ll_iter_end(&it);
+    expect_int(N / 2, ll_length(list));
+    in_order = 0;
+    for (i = 0; i < N / 2; i++)
+        in_order += *(int *)ll_get_n(list, i) == 2 * i + 1;
+    expect_int(N / 2, in_order);
+
+    ll_iter_begin(list, &it, 1);                   // everything, up to the tail
+    while (ll_iter_next(&it, &val))
+        ll_iter_remove(&it);
+    ll_iter_end(&it);
+    expect_int(0, ll_length(list));
+    expect_int(1, ll_insert_last(list, &v[0]));
+    expect_int(0, *(int *)ll_get_n(list, 0));
+
+    ll_clear(list);
+    expect_int(-1, ll_iter_begin(list, &it, 0));   // invalid list
+    ll_delete(list);
+}
+
+void num_atomic_increment(void *n) {
+    atomic_fetch_add((atomic_int *)n, 1);
+}
+
+// every value gets exactly one call, whatever the number of threads
+static void test_map_parallel(ll_opts_t opts) {
+    enum { N = 5000 };
+    static atomic_int v[N];
+    int i, threads, once;
+    opts.val_teardown = ll_no_teardown;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        atomic_init(&v[i], 0);
+        ll_insert_last(list, &v[i]);
+    }
+    for (threads = 0; threads <= 8; threads += 4) { // 0 (sequential), 4 and 8 threads
+        ll_map_parallel(list, num_atomic_increment, threads);
+        once = 0;
+        for (i = 0; i < N; i++)
+            once += atomic_load(&v[i]) == threads / 4 + 1;
+        expect_int(N, once);
+    }
+    ll_delete(list);
+
+    list = ll_new_ex(&opts);
+    ll_map_parallel(list, num_atomic_increment, 4);  // empty list
+    expect_int(0, ll_length(list));
+    ll_delete(list);
+}
+
+// ll_length() doesn't lock: it answers even while the list is write locked
+static void test_length(void) {
+    int v = 0;
+    ll_iter_t it;
+    ll_t *list = ll_new(ll_no_teardown);
+
+    ll_insert_last(list, &v);
+    ll_iter_begin(list, &it, 1);                       // holds the write lock
+    expect_int(1, ll_length(list));
+    ll_iter_end(&it);
+    ll_clear(list);
+    expect_int(-1, ll_length(list));                   // invalid list
+    ll_delete(list);
+}
+
+// teardowns of the async teardown test, which hold the first teardown until `slow_gate`
+// opens
+static atomic_int slow_torn;
+static atomic_int slow_gate;
+
+void slow_teardown(void *n) {
+    while (!atomic_load(&slow_gate))
+        sched_yield();
+    *(int *)n = -1;
+    atomic_fetch_add(&slow_torn, 1);
+}
+
+// teardowns of `NULL` values, by the contended async teardown test
+static atomic_int null_torn;
+
+void null_teardown(void *n) {
+    (void)n;
+    atomic_fetch_add(&null_torn, 1);
+}
+
+void *null_remover(void *arg) {
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        ll_insert_last((ll_t *)arg, NULL);
+        ll_remove_n((ll_t *)arg, 0);
+    }
+
+    return NULL;
+}
+
+// threads queueing `NULL` values for the background thread as it empties its queue, both
+// fighting over the lock of the queue: a `NULL` value is never taken for its end, and the
+// thread keeps going
+static void test_async_null(void) {
+    struct timespec pause = {0, 1000 * 1000};
+    pthread_t threads[4];
+    ll_opts_t opts = {0};
+    int i;
+
+    opts.val_teardown = null_teardown;
+    opts.async_teardown = 1;
+    atomic_store(&null_torn, 0);
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < 4; i++)
+        pthread_create(&threads[i], NULL, null_remover, list);
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(0, ll_flush_teardowns(list));
+    expect_int(4000, atomic_load(&null_torn));
+
+    ll_insert_last(list, NULL);
+    ll_remove_n(list, 0);
+    for (i = 0; i < 2000 && atomic_load(&null_torn) < 4001; i++)
+        nanosleep(&pause, NULL);                    // no flush: the thread tears it down
+    expect_int(4001, atomic_load(&null_torn));
+    ll_delete(list);
+}
+
+// removals don't wait for teardowns, which all happen by the time the list is deleted
+static void test_async_teardown(ll_storage_t storage, ll_lock_mode_t lock_mode) {
+    enum { N = 20 };
+    int v[N];
+    int i, torn = 0;
+    ll_iter_t it;
+    void *val;
+    ll_opts_t opts = {0};
+    opts.val_teardown = slow_teardown;
+    opts.storage = storage;
+    opts.lock_mode = lock_mode;
+    opts.async_teardown = 1;
+
+    atomic_store(&slow_torn, 0);
+    atomic_store(&slow_gate, 0);
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last(list, &v[i]);
+    }
+    expect_int(N - 1, ll_remove_n(list, 0));        // the teardown is stuck...
+    expect_int(N - 2, ll_remove_find(list, num_equals, &v[5]));
+    expect_int(N - 3, ll_remove_search(list, num_equals_3));
+    expect_int(0, atomic_load(&slow_torn));         // ...and nobody waited for it
+    atomic_store(&slow_gate, 1);
+    if (lock_mode == LL_LOCK_RCU)                   // nodes are retired first
+        expect_int(0, ll_synchronize(list));
+    else
+        expect_int(0, ll_flush_teardowns(list));
+    expect_int(3, atomic_load(&slow_torn));
+    expect_int(-1, v[3]);
+
+    ll_iter_begin(list, &it, 1);
+    while (ll_iter_next(&it, &val)) {
+        if (num_is_even(val))
+            ll_iter_remove(&it);
+    }
+    ll_iter_end(&it);
+    expect_int(1, *(int *)ll_pop_first(list));      // popped values aren't torn down
+    ll_delete(list);
+    for (i = 0; i < N; i++)
+        torn += v[i] == -1;
+    expect_int(N - 1, torn);
+    expect_int(N - 1, atomic_load(&slow_torn));
+}
+
+// ll_reset() empties a list that stays usable, and lists with `async_teardown` leave all
+// the teardowns to their background thread
+static void test_reset(ll_opts_t opts) {
+    enum { N = 100 };
+    static int v[N];
+    static int w[10];
+    int lazy = opts.async_teardown && opts.storage == LL_STORAGE_NODES &&
+               opts.lock_mode != LL_LOCK_RCU;
+    int i, torn = 0;
+    ll_pool_stats_t pool;
+
+    opts.val_teardown = slow_teardown;
+    opts.capacity = N;
+    atomic_store(&slow_torn, 0);
+    atomic_store(&slow_gate, !lazy);
+    ll_t *list = ll_new_ex(&opts);
+    expect_int(0, ll_reset(list));                  // nothing to remove
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last(list, &v[i]);
+    }
+    if (opts.storage == LL_STORAGE_NODES && opts.lock_mode != LL_LOCK_RCU)
+        expect_int(0, ll_set_index(list, num_hash, num_equals));
+    expect_int(0, ll_reset(list));
+    expect_int(0, ll_length(list));
+    expect_int(1, ll_pop_first(list) == NULL);
+    if (lazy)
+        expect_int(0, atomic_load(&slow_torn));     // stuck in the background
+    else if (!opts.async_teardown)
+        expect_int(N, atomic_load(&slow_torn));
+
+    for (i = 0; i < 10; i++) {                      // room again, and nothing left over
+        w[i] = i;
+        expect_int(i + 1, ll_insert_last(list, &w[i]));
+    }
+    expect_int(3, *(int *)ll_get_n(list, 3));
+    expect_int(7, *(int *)ll_find(list, num_equals, &w[7]));
+    atomic_store(&slow_gate, 1);
+    if (opts.lock_mode == LL_LOCK_RCU)
+        expect_int(0, ll_synchronize(list));
+    else
+        expect_int(0, ll_flush_teardowns(list));
+    expect_int(N, atomic_load(&slow_torn));
+    for (i = 0; i < N; i++)
+        torn += v[i] == -1;
+    expect_int(N, torn);
+    if (opts.pool_slab_nodes > 0) {                 // the nodes went back to the pool
+        expect_int(0, ll_pool_stats(list, &pool));
+        expect_int(10, (int)pool.in_use);
+    }
+
+    ll_clear(list);
+    expect_int(N + 10, atomic_load(&slow_torn));
+    expect_int(-1, ll_reset(list));
+    ll_delete(list);
+}
+
+// whether the values of `list` are the `n` ones of `ref`, in order
+static int list_is(ll_t *list, int **ref, int n) {
+    int i;
+
+    if (ll_length(list) != n)
+        return 0;
+    for (i = 0; i < n; i++) {
+        if (ll_get_n(list, i) != ref[i])
+            return 0;
+    }
+    return 1;
+}
+
+// handles remove their values wherever they are, in constant time, LRU style
+static void test_doubly(ll_lock_mode_t lock_mode) {
+    enum { N = 64 };
+    static int v[N];
+    int *ref[N];
+    ll_handle_t h[N];
+    void *batch[2];
+    int i, n, key, new_len, len_ok = 0;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.lock_mode = lock_mode;
+    opts.doubly_linked = 1;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < 6; i++) {
+        v[i] = i;
+        ll_insert_last_handle(list, &v[i], &h[i]);
+    }
+    expect_int(5, ll_remove_handle(list, h[0]));           // head
+    expect_int(4, ll_remove_handle(list, h[3]));           // middle
+    expect_int(3, ll_remove_handle(list, h[5]));           // tail...
+    expect_int(4, ll_insert_last_handle(list, &v[5], &h[5])); // ...was kept right
+    ref[0] = &v[1], ref[1] = &v[2], ref[2] = &v[4], ref[3] = &v[5];
+    expect_int(1, list_is(list, ref, 4));
+    expect_int(5, ll_insert_first_handle(list, &v[0], &h[0]));
+    expect_int(6, ll_insert_n_handle(list, &v[3], 3, &h[3]));
+    batch[0] = &v[6], batch[1] = &v[7];
+    expect_int(2, ll_insert_many(list, batch, 2, 4));     // 0 1 2 3 6 7 4 5
+    expect_int(7, ll_remove_handle(list, h[3]));           // links around the chain hold
+    expect_int(6, ll_remove_handle(list, h[4]));
+    ref[0] = &v[0], ref[1] = &v[1], ref[2] = &v[2], ref[3] = &v[6], ref[4] = &v[7];
+    ref[5] = &v[5];
+    expect_int(1, list_is(list, ref, 6));
+    ll_clear(list);
+    ll_delete(list);
+
+    // the hash index learns of the removals, and keeps the predecessors it knows right
+    list = ll_new_ex(&opts);
+    if (lock_mode != LL_LOCK_RCU)
+        expect_int(0, ll_set_index(list, num_hash, num_equals));
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last_handle(list, &v[i], &h[i]);
+    }
+    for (i = 0; i < N; i += 3)
+        n = ll_remove_handle(list, h[i]);
+    for (i = 0; i < N; i++) {
+        key = i;
+        new_len = ll_remove_find(list, num_equals, &key);
+        len_ok += i % 3 == 0 ? new_len == -1 : new_len == --n;
+    }
+    expect_int(N, len_ok);
+    ll_delete(list);
+
+    // LRU churn: touched values move to the front, the least recently used go first
+    list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++)
+        ref[i] = NULL;
+    for (i = 0, n = 0; i < 20 * N; i++) {
+        int j, k = (i * 7919) % N;
+        for (j = 0; j < n && ref[j] != &v[k]; j++)
+            ;
+        if (j < n) {                                   // touched...
+            ll_remove_handle(list, h[k]);
+        } else {                                       // ...or loaded, evicting if full
+            if (n == N / 2) {
+                int evicted = *ref[--n];
+                ll_remove_handle(list, h[evicted]);
+            }
+            j = n++;
+        }
+        for (; j > 0; j--)
+            ref[j] = ref[j - 1];
+        ll_insert_first_handle(list, &v[k], &h[k]);
+        ref[0] = &v[k];
+    }
+    expect_int(1, list_is(list, ref, n));
+    ll_delete(list);
+
+    // only doubly linked lists of nodes hand out handles
+    opts.storage = LL_STORAGE_UNROLLED;
+    expect_int(1, ll_new_ex(&opts) == NULL);
+    opts.storage = LL_STORAGE_NODES;
+    opts.pos_index = 1;
+    expect_int(1, ll_new_ex(&opts) == NULL);
+    opts.pos_index = 0;
+    opts.doubly_linked = 0;
+    list = ll_new_ex(&opts);
+    expect_int(-1, ll_insert_last_handle(list, &v[0], &h[0]));
+    expect_int(-1, ll_insert_first_handle(list, &v[0], &h[0]));
+    expect_int(0, ll_length(list));
+    expect_int(-1, ll_remove_handle(list, NULL));
+    ll_delete(list);
+}
+
+// comparisons made by the sorted list tests
+static int order_calls;
+
+int num_order(const void *n, const void *m) {
+    order_calls++;
+    return *(int *)n - *(int *)m;
+}
+
+int num_order_desc(const void *n, const void *m) {
+    return *(int *)m - *(int *)n;
+}
+
+// sorted lists stay sorted, are searched up to the key only and merge in order
+static void test_sorted(ll_opts_t opts) {
+    enum { N = 50 };
+    static int v[N], twin, key;
+    int *ref[2 * N];
+    void *batch[1];
+    int i, len_ok = 0, found = 0;
+    opts.val_teardown = ll_no_teardown;
+    opts.order = num_order;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++)
+        v[i] = 2 * i;
+    for (i = 0; i < N; i++)
+        len_ok += ll_insert_sorted(list, &v[(i * 17) % N]) == i + 1;
+    expect_int(N, len_ok);
+    twin = v[10];
+    expect_int(N + 1, ll_insert_sorted(list, &twin));      // equal values keep their order
+    for (i = 0; i <= 10; i++)
+        ref[i] = &v[i];
+    for (ref[i++] = &twin; i < N + 1; i++)
+        ref[i] = &v[i - 1];
+    expect_int(1, list_is(list, ref, N + 1));
+    expect_int(1, ll_get_n(list, N / 2 + 1) == &v[N / 2]);
+    expect_int(N + 1, ll_remove_n(list, 11) + 1);         // twin
+    for (i = 0; i < N; i++) {
+        key = 2 * i;
+        found += ll_find_sorted(list, &key) == &v[i];
+    }
+    expect_int(N, found);
+    order_calls = 0;
+    key = -1;
+    expect_int(1, ll_find_sorted(list, &key) == NULL);     // sorts first, a single look...
+    expect_int(1, order_calls);
+    key = 9;
+    expect_int(1, ll_find_sorted(list, &key) == NULL);     // ...or up to where it would be
+    expect_int(6, order_calls - 1);
+
+    // positional insertions would break the order
+    batch[0] = &v[0];
+    expect_int(-1, ll_insert_first(list, &v[0]));
+    expect_int(-1, ll_insert_last(list, &v[0]));
+    expect_int(-1, ll_insert_n(list, &v[0], 3));
+    expect_int(-1, ll_insert_many(list, batch, 1, -1));
+    expect_int(N, ll_length(list));
+
+    // the odd numbers, merged with the even ones
+    static int odd[N];
+    ll_t *odds = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        odd[i] = 2 * (N - i) - 1;
+        ll_insert_sorted(odds, &odd[i]);
+    }
+    ll_t *merged = ll_merge(list, odds, &opts);
+    for (i = 0; i < N; i++) {
+        ref[2 * i] = &v[i];
+        ref[2 * i + 1] = &odd[N - 1 - i];
+    }
+    expect_int(1, list_is(merged, ref, 2 * N));
+    expect_int(N, ll_length(list));                        // the sources are left as they are
+    expect_int(N, ll_length(odds));
+    key = 2 * N - 1;
+    expect_int(1, ll_find_sorted(merged, &key) == &odd[0]);
+    expect_int(2 * N + 1, ll_insert_sorted(merged, &twin)); // the tail is known
+    ll_delete(merged);
+    ll_delete(odds);
+    odds = ll_new_ex(&opts);
+    merged = ll_merge(odds, list, &opts);                  // one of them empty...
+    for (i = 0; i < N; i++)
+        ref[i] = &v[i];
+    expect_int(1, list_is(merged, ref, N));
+    ll_delete(merged);
+    merged = ll_merge(odds, odds, &opts);                  // ...or both
+    expect_int(0, ll_length(merged));
+    ll_delete(merged);
+    ll_delete(odds);
+
+    // lists must be sorted, in the same order
+    ll_opts_t desc = opts;
+    desc.order = num_order_desc;
+    odds = ll_new_ex(&desc);
+    expect_int(1, ll_merge(list, odds, &opts) == NULL);
+    expect_int(1, ll_merge(list, list, &desc) == NULL);
+    ll_delete(odds);
+    ll_delete(list);
+    opts.order = NULL;
+    list = ll_new_ex(&opts);
+    expect_int(-1, ll_insert_sorted(list, &v[0]));
+    expect_int(1, ll_find_sorted(list, &v[0]) == NULL);
+    expect_int(1, ll_merge(list, list, &opts) == NULL);
+    ll_delete(list);
+    opts.order = num_order;
+    opts.storage = LL_STORAGE_UNROLLED;
+    opts.lock_mode = LL_LOCK_LIST;
+    opts.pos_index = 0;
+    expect_int(1, ll_new_ex(&opts) == NULL);              // node storage only
+}
+
+typedef struct {
+    ll_t *a;
+    ll_t *b;
+    int rounds;
+} splice_arg_t;
+
+// moves values from `a` to `b`, a few at a time
+void *splice_worker(void *arg) {
+    splice_arg_t *w = (splice_arg_t *)arg;
+    int i;
+
+    for (i = 0; i < w->rounds; i++) {
+        if (ll_splice(w->b, i % 3 == 0 ? 0 : -1, w->a, 0, 1 + i % 4) < 0)
+            ll_concat(w->b, w->a);
+    }
+
+    return NULL;
+}
+
+// ranges of values move between lists by relinking nodes, whatever the lists keep aside
+static void test_splice(ll_opts_t opts) {
+    enum { N = 20, ROUNDS = 2000 };
+    static int v[N];
+    int *ref[N];
+    int i, found = 0;
+    opts.val_teardown = ll_no_teardown;
+
+    ll_t *a = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last(a, &v[i]);
+    }
+    ll_t *b = ll_split(a, N / 2);
+    expect_int(N / 2, ll_length(b));
+    expect_int(0, ll_set_index(a, num_hash, num_equals));
+    expect_int(14, ll_splice(a, 3, b, 2, 4));             // a: 0 1 2 12..15 3..9
+    expect_int(1, ll_find(a, num_equals, &v[13]) == &v[13]);
+    expect_int(1, ll_find(b, num_equals, &v[13]) == NULL);
+    for (i = 0; i < 3; i++)
+        ref[i] = &v[i];
+    for (; i < 7; i++)
+        ref[i] = &v[i + 9];
+    for (; i < 14; i++)
+        ref[i] = &v[i - 4];
+    expect_int(1, list_is(a, ref, 14));
+    ref[0] = &v[10], ref[1] = &v[11], ref[2] = &v[16], ref[3] = &v[17], ref[4] = &v[18];
+    ref[5] = &v[19];
+    expect_int(1, list_is(b, ref, 6));
+    expect_int(7, ll_splice(b, -1, a, 13, 1));            // the tails move along...
+    expect_int(14, ll_insert_last(a, &v[9]));
+    expect_int(1, ll_get_n(a, 13) == &v[9] && ll_get_n(b, 6) == &v[9]);
+    expect_int(7, ll_remove_n(b, 6) + 1);
+    expect_int(-1, ll_splice(a, 0, b, 0, 7));             // ...out of range otherwise
+    expect_int(-1, ll_splice(a, 15, b, 0, 1));
+    expect_int(-1, ll_splice(a, 0, a, 0, 1));
+
+    expect_int(20, ll_concat(a, b));                      // b is left empty, but usable
+    expect_int(0, ll_length(b));
+    expect_int(1, ll_insert_last(b, &v[0]));
+    expect_int(1, ll_get_first(b) == &v[0]);
+    expect_int(0, ll_remove_first(b));
+    expect_int(20, ll_concat(a, b));                      // nothing to move
+    for (i = 0; i < N; i++)
+        found += ll_find(a, num_equals, &v[i]) == &v[i];
+    expect_int(N, found);
+
+    ll_delete(b);
+    ll_t *tail = ll_split(a, 15);
+    expect_int(15, ll_length(a));
+    expect_int(5, ll_length(tail));
+    expect_int(1, ll_get_first(tail) == &v[11]);
+    expect_int(16, ll_insert_last(a, &v[0]));
+    expect_int(6, ll_insert_last(tail, &v[1]));
+    expect_int(22, ll_concat(a, tail));                   // sharing a pool if there is one
+    ll_delete(tail);
+    tail = ll_split(a, 22);
+    expect_int(0, ll_length(tail));
+    expect_int(22, ll_length(a));
+    ll_delete(tail);
+    tail = ll_split(a, 0);
+    expect_int(0, ll_length(a));
+    ll_delete(a);                                         // the pool outlives the list...
+    expect_int(23, ll_insert_first(tail, &v[2]));         // ...as long as the other needs it
+    expect_int(1, ll_split(tail, 24) == NULL);
+
+    // no values are lost by threads moving them both ways
+    a = ll_split(tail, 0);
+    for (i = 0; i < N; i++)
+        ll_insert_last(a, &v[i]);
+    splice_arg_t args[2] = {{a, tail, ROUNDS}, {tail, a, ROUNDS}};
+    pthread_t threads[2];
+    for (i = 0; i < 2; i++)
+        pthread_create(&threads[i], NULL, splice_worker, &args[i]);
+    for (i = 0; i < 2; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(N + 23, ll_length(a) + ll_length(tail));
+    ll_delete(a);
+    ll_delete(tail);
+
+    // nodes only move between lists laid out the same, in a shared pool if any
+    a = ll_new_ex(&opts);
+    opts.lock_mode = opts.lock_mode == LL_LOCK_LIST ? LL_LOCK_NODES : LL_LOCK_LIST;
+    b = ll_new_ex(&opts);
+    ll_insert_last(b, &v[0]);
+    expect_int(-1, ll_splice(a, 0, b, 0, 1));
+    expect_int(-1, ll_concat(a, b));
+    ll_delete(b);
+    opts.lock_mode = opts.lock_mode == LL_LOCK_LIST ? LL_LOCK_NODES : LL_LOCK_LIST;
+    opts.doubly_linked = !opts.doubly_linked;
+    opts.pos_index = 0;
+    b = ll_new_ex(&opts);
+    ll_insert_last(b, &v[0]);
+    expect_int(-1, ll_splice(a, 0, b, 0, 1));
+    ll_delete(b);
+    opts.doubly_linked = !opts.doubly_linked;
+    if (opts.pool_slab_nodes > 0) {
+        b = ll_new_ex(&opts);
+        ll_insert_last(b, &v[0]);
+        expect_int(-1, ll_splice(a, 0, b, 0, 1));     // pools of their own
+        ll_delete(b);
+    }
+    ll_delete(a);
+}
+
+// sorted lists split, but take no values they would have to sort; RCU lists move nothing
+static void test_splice_modes(void) {
+    static int v[8];
+    int i;
+    ll_opts_t opts = {0};
+    opts.val_teardown = ll_no_teardown;
+    opts.order = num_order;
+
+    ll_t *sorted = ll_new_ex(&opts);
+    for (i = 0; i < 8; i++) {
+        v[i] = 7 - i;
+        ll_insert_sorted(sorted, &v[i]);
+    }
+    ll_t *tail = ll_split(sorted, 4);
+    expect_int(4, *(int *)ll_get_first(tail));
+    expect_int(5, ll_insert_sorted(tail, &v[7]));        // 0
+    expect_int(0, *(int *)ll_get_first(tail));
+    expect_int(-1, ll_concat(sorted, tail));
+    opts.order = NULL;
+    ll_t *plain = ll_new_ex(&opts);
+    expect_int(5, ll_concat(plain, tail));               // unsorted lists take them all
+    ll_delete(plain);
+    ll_delete(tail);
+    ll_delete(sorted);
+
+    opts.lock_mode = LL_LOCK_RCU;
+    ll_t *a = ll_new_ex(&opts);
+    ll_t *b = ll_new_ex(&opts);
+    ll_insert_last(b, &v[0]);
+    expect_int(-1, ll_concat(a, b));
+    expect_int(1, ll_split(b, 0) == NULL);
+    ll_delete(a);
+    ll_delete(b);
+    opts.lock_mode = LL_LOCK_NODES;
+    opts.storage = LL_STORAGE_UNROLLED;
+    a = ll_new_ex(&opts);
+    ll_insert_last(a, &v[0]);
+    expect_int(1, ll_split(a, 0) == NULL);
+    ll_delete(a);
+}
+
+void *stats_inserter(void *arg) {
+    static int v;
+    int i;
+
+    for (i = 0; i < 1000; i++)
+        ll_insert_last((ll_t *)arg, &v);
+
+    return NULL;
+}
+
+typedef struct {
+    int x;
+    int y;
+} point_t;
+
+static int point_teardowns;
+
+static int point_equals(const point_t *p, const point_t *q) {
+    return p->x != q->x || p->y != q->y;
+}
+
+#define point_teardown(p) (point_teardowns++, (void)(p))
+
+LL_DEFINE(points, point_t, point_equals, point_teardown)
+
+static void point_flip(point_t *p) {
+    p->y = -p->y;
+}
+
+static void *points_worker(void *arg) {
+    int i;
+
+    for (i = 0; i < 1000; i++)
+        points_insert_last((points_t *)arg, (point_t){i, i});
+
+    return NULL;
+}
+
+// lists generated by `LL_DEFINE()` must behave like `ll_t` ones, values copied in and out
+static void test_tmpl(void) {
+    pthread_t threads[4];
+    point_t p = {0, 0};
+    int i, sum = 0;
+
+    points_t *list = points_new(LL_BACKEND_RWLOCK);
+    expect_int(1, points_insert_last(list, (point_t){1, 10}));
+    expect_int(2, points_insert_last(list, (point_t){3, 30}));
+    expect_int(3, points_insert_first(list, (point_t){0, 0}));
+    expect_int(4, points_insert_n(list, (point_t){2, 20}, 2));   // (0 1 2 3)
+    expect_int(-1, points_insert_n(list, p, 5));
+    for (i = 0; i < 4; i++)
+        sum += points_get_n(list, i, &p) == 0 && p.x == i && p.y == 10 * i;
+    expect_int(4, sum);
+    expect_int(-1, points_get_n(list, 4, &p));
+    expect_int(2, points_find(list, &(point_t){2, 20}, &p));
+    expect_int(20, p.y);
+    expect_int(-1, points_find(list, &(point_t){2, 21}, NULL));
+
+    points_map(list, point_flip);
+    expect_int(0, points_get_n(list, 3, &p));
+    expect_int(-30, p.y);
+    expect_int(3, points_remove_find(list, &(point_t){1, -10})); // (0 2 3)
+    expect_int(1, point_teardowns);
+    expect_int(0, points_pop_first(list, &p));                   // (2 3), not torn down
+    expect_int(1, point_teardowns);
+    expect_int(1, points_remove_n(list, 1));                     // (2)
+    expect_int(1, points_insert_last(list, (point_t){4, 40}) - 1);
+    expect_int(0, points_get_n(list, 1, &p));                    // tail was kept right
+    expect_int(4, p.x);
+    expect_int(1, points_remove_first(list));
+    expect_int(3, point_teardowns);
+    points_clear(list);
+    expect_int(4, point_teardowns);
+    expect_int(-1, points_length(list));
+    expect_int(-1, points_insert_last(list, p));
+    points_delete(list);
+
+    list = points_new(LL_BACKEND_TICKET);
+    for (i = 0; i < 4; i++)
+        pthread_create(&threads[i], NULL, points_worker, list);
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(4000, points_length(list));
+    points_delete(list);
+    expect_int(4004, point_teardowns);
+    expect_int(1, points_new(3) == NULL);                        // unknown backend
+}
+
+static int snapshot_sum;
+
+static void num_add_to_snapshot_sum(void *n) {
+    snapshot_sum += *(int *)n;
+}
+
+// inserts values that the main thread of `test_snapshot()` then finds in its snapshots,
+// while removing older ones: they must not be torn down before the snapshots are released
+static void *snapshot_worker(void *arg) {
+    ll_t *list = (ll_t *)arg;
+    static int v[2000];
+    int i;
+
+    for (i = 0; i < 2000; i++) {
+        v[i] = i + 1;
+        ll_insert_first(list, &v[i]);
+        if (ll_length(list) > 8)
+            ll_remove_n(list, 8);
+    }
+
+    return NULL;
+}
+
+// snapshots must keep the values of the list as it was, torn down only once released
+static void test_snapshot(ll_opts_t opts) {
+    enum { N = 10 };
+    static int v[N];
+    pthread_t thread;
+    int i, ok = 0;
+
+    opts.val_teardown = num_teardown; // negates the values
+    ll_t *list = ll_new_ex(&opts);
+    ll_snapshot_t *empty = ll_snapshot(list);
+    for (i = 0; i < N; i++) {
+        v[i] = i + 1;
+        ll_insert_last(list, &v[i]);
+    }
+    expect_int(0, ll_snapshot_length(empty));
+    expect_int(1, ll_snapshot_get_n(empty, 0) == NULL);
+    ll_snapshot_t *snap = ll_snapshot(list);
+    for (i = 0; i < N / 2; i++)
+        ll_remove_first(list);
+    expect_int(N, ll_snapshot_length(snap));
+    for (i = 0; i < N; i++)
+        ok += ll_snapshot_get_n(snap, i) == &v[i] && v[i] == i + 1;
+    expect_int(N, ok);
+    snapshot_sum = 0;
+    ll_snapshot_map(snap, num_add_to_snapshot_sum);
+    expect_int(N * (N + 1) / 2, snapshot_sum);
+    ll_snapshot_release(empty);                        // another one is still out
+    expect_int(2, v[1]);
+    ll_snapshot_release(snap);                         // the last one tears them down
+    ll_synchronize(list);
+    ll_flush_teardowns(list);
+    expect_int(-2, v[1]);
+    expect_int(-5, v[4]);
+    expect_int(6, v[5]);
+    ll_remove_first(list);                             // no snapshot out, not held
+    ll_synchronize(list);
+    ll_flush_teardowns(list);
+    expect_int(-6, v[5]);
+
+    pthread_create(&thread, NULL, snapshot_worker, list);
+    for (i = 0; i < 200; i++) {
+        ll_snapshot_t *s = ll_snapshot(list);
+        int j, n = ll_snapshot_length(s), pos = 0;
+        for (j = 0; j < n; j++)
+            pos += *(int *)ll_snapshot_get_n(s, j) > 0;
+        ok += pos == n;
+        ll_snapshot_release(s);
+    }
+    pthread_join(thread, NULL);
+    expect_int(N + 200, ok);
+    ll_delete(list);
+
+    list = ll_new(NULL);
+    ll_clear(list);
+    expect_int(1, ll_snapshot(list) == NULL);          // invalid
+    ll_delete(list);
+}
+
+static size_t str_serialize(const void *val, void *buf, size_t size) {
+    size_t len = strlen((const char *)val) + 1;
+
+    if (len <= size)
+        memcpy(buf, val, len);
+    return len;
+}
+
+static size_t fail_serialize(const void *val, void *buf, size_t size) {
+    (void)val, (void)buf, (void)size;
+    return SIZE_MAX;
+}
+
+static int str_equals(const void *s, const void *t) {
+    return strcmp((const char *)s, (const char *)t);
+}
+
+static int str_order(const void *s, const void *t) {
+    return strcmp((const char *)s, (const char *)t);
+}
+
+static int str_order_desc(const void *s, const void *t) {
+    return strcmp((const char *)t, (const char *)s);
+}
+
+// lists saved with `ll_save()` must come back from `ll_load_mmap()` as they were
+static void test_file(ll_opts_t opts) {
+    enum { N = 3000 };
+    static char strs[N][24];
+    char path[] = "/tmp/ll_test_XXXXXX";
+    int i, ok = 0, fd = mkstemp(path);
+    ll_opts_t src_opts = {0};
+
+    src_opts.val_teardown = ll_no_teardown;
+    ll_t *list = ll_new_ex(&src_opts);
+    for (i = 0; i < N; i++) {
+        snprintf(strs[i], sizeof(strs[i]), "v%05d%.*s", i, i % 8, "xxxxxxxx");
+        ll_insert_last(list, strs[i]);
+    }
+    expect_int(N, ll_save(list, fd, str_serialize));
+    expect_int(-1, ll_save(list, fd, fail_serialize));
+    ll_t *cleared = ll_new_ex(&src_opts);
+    ll_clear(cleared);
+    errno = 0;
+    expect_int(-1, ll_save(cleared, fd, str_serialize));
+    expect_int(EINVAL, errno);
+    ll_delete(cleared);
+    close(fd);
+
+    opts.val_teardown = ll_no_teardown;
+    ll_t *loaded = ll_load_mmap(path, &opts);
+    expect_int(N, ll_length(loaded));
+    for (i = 0; i < N; i++) {
+        const char *s = (const char *)ll_get_n(loaded, i);
+        ok += s != strs[i] && strcmp(s, strs[i]) == 0 && (uintptr_t)s % 8 == 0;
+    }
+    expect_int(N, ok);
+    expect_int(1, ll_find(loaded, str_equals, "v01234xx") != NULL);
+    ((char *)ll_get_n(loaded, 1))[6] = 'y';                // private, in place
+    expect_int(0, strcmp("v00001y", (char *)ll_get_n(loaded, 1)));
+    expect_int(N - 1, ll_remove_n(loaded, 10));
+    if (opts.order != NULL)                                // not from the file
+        expect_int(N, ll_insert_sorted(loaded, "v99999"));
+    else
+        expect_int(N, ll_insert_last(loaded, "v99999"));
+    expect_int(0, strcmp("v99999", (char *)ll_get_n(loaded, N - 1)));
+    ll_delete(loaded);
+    ll_delete(list);
+
+    list = ll_load_mmap(path, &opts);                      // the file is left as it was
+    expect_int(0, strcmp("v00001x", (char *)ll_get_n(list, 1)));
+    ll_delete(list);
+    ll_opts_t desc = {0};                                  // saved in another order
+    desc.val_teardown = ll_no_teardown;
+    desc.order = str_order_desc;
+    errno = 0;
+    expect_int(1, ll_load_mmap(path, &desc) == NULL);
+    expect_int(EINVAL, errno);
+
+    fd = open(path, O_WRONLY | O_TRUNC);
+    list = ll_new_ex(&src_opts);
+    expect_int(0, ll_save(list, fd, str_serialize));
+    ll_delete(list);
+    list = ll_load_mmap(path, &opts);
+    expect_int(0, ll_length(list));
+    ll_delete(list);
+    ll_opts_t bad = opts;                                  // turned down by ll_new_ex()
+    bad.storage = LL_STORAGE_UNROLLED;
+    bad.order = str_order;
+    errno = 0;
+    expect_int(1, ll_load_mmap(path, &bad) == NULL);
+    expect_int(EINVAL, errno);
+    expect_int(0, ftruncate(fd, 20));                      // cut in the header
+    close(fd);
+    expect_int(1, ll_load_mmap(path, &opts) == NULL);
+    unlink(path);
+    expect_int(1, ll_load_mmap(path, &opts) == NULL);       // gone
+}
+
+// keys that differ in their upper half only: a match needs all 64 bits to agree
+static int64_t num_key(const void *n) {
+    return ((int64_t)*(int *)n << 32) | 7;
+}
+
+// `ll_find_key()` must find every value by its key, wherever the blocks moved it
+static void test_keys(size_t pool_slab_nodes) {
+    enum { N = 100 };
+    static int v[N];
+    void *out[8];
+    int i, found = 0;
+    ll_opts_t opts = {0};
+    opts.storage = LL_STORAGE_UNROLLED;
+    opts.pool_slab_nodes = pool_slab_nodes;
+    opts.key_of = num_key;
+    opts.val_teardown = ll_no_teardown;
+
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++)
+        v[i] = i;
+    for (i = 0; i < N; i += 2)
+        ll_insert_last(list, &v[i]);
+    for (i = 1; i < N; i += 2)                       // splits full blocks
+        ll_insert_n(list, &v[i], i);
+    for (i = 0; i < N; i++)
+        found += ll_find_key(list, num_key(&v[i])) == &v[i];
+    expect_int(N, found);
+    expect_int(1, ll_find_key(list, ((int64_t)N << 32) | 7) == NULL); // upper half differs
+    expect_int(1, ll_find_key(list, num_key(&v[0])) == &v[0]);
+
+    expect_int(N - 1, ll_remove_n(list, 50));        // 50, leaves blocks to merge
+    for (i = 40; i < 50; i++)
+        ll_remove_n(list, 40);
+    expect_int(8, ll_pop_many(list, out, 8));        // 0 to 7
+    expect_int(80, ll_remove_find(list, num_equals, &v[20]));
+    found = 0;
+    for (i = 0; i < N; i++) {
+        int gone = i < 8 || i == 20 || (i >= 40 && i <= 50);
+        found += ll_find_key(list, num_key(&v[i])) == (gone ? NULL : &v[i]);
+    }
+    expect_int(N, found);
+    ll_delete(list);
+
+    opts.storage = LL_STORAGE_NODES;
+    expect_int(1, ll_new_ex(&opts) == NULL);         // nodes keep no keys
+    opts.key_of = NULL;
+    list = ll_new_ex(&opts);
+    ll_insert_last(list, &v[1]);
+    expect_int(1, ll_find_key(list, num_key(&v[1])) == NULL);
+    ll_delete(list);
+}
 
-        tmp = nth_node->nxt;
-        nth_node->nxt = nth_node->nxt == NULL ? NULL : nth_node->nxt->nxt;
-        RWUNLOCK(nth_node);
+// the counters follow what was done to the list, whichever thread did it
+static void test_stats(void) {
+    static int v[3] = {0, 1, 2};
+    ll_stats_t stats;
+    pthread_t threads[4];
+    int i;
+
+    ll_t *list = ll_new(ll_no_teardown);
+#ifdef LL_STATS
+    for (i = 0; i < 3; i++)
+        ll_insert_last(list, &v[i]);
+    ll_get_n(list, 1);                                // walks 1 node...
+    ll_find(list, num_equals, &v[2]);                 // ...then 2
+    ll_remove_n(list, 0);
+    ll_map(list, ll_no_teardown);
+    expect_int(0, ll_stats(list, &stats));
+    expect_int(3, (int)stats.inserts);
+    expect_int(1, (int)stats.removes);
+    expect_int(2, (int)stats.lookups);
+    expect_int(1, (int)stats.maps);
+    expect_int(3, (int)stats.allocs);
+    expect_int(1, (int)stats.frees);
+    expect_int(2, (int)stats.walks);
+    expect_int(3, (int)stats.walk_steps);
+    expect_int(3, (int)stats.read_locks);             // the gets, find and map
+    expect_int(4, (int)stats.write_locks);
+    expect_int(1, stats.lock_hold_ns > 0);
+
+    expect_int(0, ll_stats_reset(list));
+    for (i = 0; i < 4; i++)
+        pthread_create(&threads[i], NULL, stats_inserter, list);
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    ll_stats(list, &stats);
+    expect_int(4000, (int)stats.inserts);             // no count lost across the stripes
+    expect_int(4000, (int)stats.write_locks);
+    expect_int(0, (int)stats.removes);
+#else
+    (void)v, (void)threads, (void)i;
+    expect_int(-1, ll_stats(list, &stats));           // not built in
+    expect_int(-1, ll_stats_reset(list));
+#endif
+    ll_delete(list);
+}
+
+// lists placed on a NUMA node. this only checks what holds on any machine: that they work,
+// and that a list touched by the thread that created it sees no remote lock
+static void test_numa(ll_storage_t storage) {
+    static int v[100];
+    ll_pool_stats_t pool;
+    ll_opts_t opts = {0};
+    int ids[8];
+    int i, offline;
+
+    expect_int(1, ll_numa_nodes() >= 1);
+    expect_int(1, ll_numa_index(ll_numa_node()) >= 0);
+    for (i = 0; i < ll_numa_nodes(); i++)
+        expect_int(i, ll_numa_index(ll_numa_node_at(i)));
+    expect_int(-1, ll_numa_node_at(ll_numa_nodes()));
+    expect_int(2, ll_numa_parse("0,2\n", ids, 8));          // node 1 is offline
+    expect_int(2, ids[1]);
+    expect_int(5, ll_numa_parse("0-1,4-6", ids, 8));
+    expect_int(4, ids[2]);
+    expect_int(3, ll_numa_parse("3,6-9", ids, 8));           // 8 and 9 past `max`
+    expect_int(0, ll_numa_parse("", ids, 8));
+
+    opts.storage = storage;
+    opts.val_teardown = ll_no_teardown;
+    opts.numa_bind = 1;
+    opts.numa_node = -1;
+    expect_int(1, ll_new_ex(&opts) == NULL);
+    for (offline = 0; ll_numa_index(offline) >= 0; offline++)
+        ;
+    opts.numa_node = offline;
+    expect_int(1, ll_new_ex(&opts) == NULL);
+
+    opts.numa_node = ll_numa_node();
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < 100; i++) {
+        v[i] = i;
+        expect_int(i + 1, ll_insert_last(list, &v[i]));
+    }
+    if (storage == LL_STORAGE_NODES) {
+        expect_int(0, ll_pool_stats(list, &pool));    // even without `pool_slab_nodes`
+        expect_int(LL_NUMA_SLAB_NODES, (int)pool.capacity);
+        expect_int(100, (int)pool.in_use);
     }
+    for (i = 0; i < 100; i++)
+        expect_int(i, *(int *)ll_pop_first(list));
+#ifdef LL_STATS
+    ll_stats_t stats;
+    expect_int(0, ll_stats(list, &stats));
+    expect_int(0, (int)stats.remote_locks);
+#endif
+    ll_delete(list);
 
-    (list->len)--;
-    list->val_teardown(tmp->val);
+    opts.pool_slab_nodes = 8;
+    list = ll_new_ex(&opts);
+    for (i = 0; i < 20; i++)
+        ll_insert_first(list, &v[i]);
+    expect_int(20, ll_length(list));
+    if (storage == LL_STORAGE_NODES) {
+        ll_pool_stats(list, &pool);
+        expect_int(3, (int)pool.slabs);
+    }
+    ll_delete(list);
+}
 
-    RWUNLOCK(list);
-    pthread_rwlock_destroy(&(tmp->m));
-    free(tmp);
+// teardowns seen by the RCU tests, and torn down values their readers came across
+static atomic_int rcu_torn;
+static atomic_int rcu_bad;
 
-    return list->len;
+void rcu_count_teardown(void *n) {
+    (void)n;
+    atomic_fetch_add(&rcu_torn, 1);
 }
 
-/**
- * @function ll_remove_first
- *
- * Wrapper for `ll_remove_n`.
- *
- * @param list - the linked list
- *
- * @returns 0 if successful, -1 otherwise
- */
-int ll_remove_first(ll_t *list) {
-    return ll_remove_n(list, 0);
+// values of the concurrent RCU test are malloc'ed, and poisoned before being freed
+void rcu_free_teardown(void *n) {
+    *(int *)n = -1;
+    free(n);
 }
 
-/**
- * @function ll_pop_first
- *
- * returns a pointer to data of the first node and removes it.
- * NOTE : the caller takes the owner ship of the pointer
- *        (and thus, needs to call the teardown function on it)
- *
- * @param list - the linked list
- *
- * @returns pointer to data or NULL
- */
-void *ll_pop_first(ll_t *list) {
-    void *data = NULL;
+void rcu_check(void *n) {
+    if (*(int *)n < 0)
+        atomic_fetch_add(&rcu_bad, 1);
+}
 
-    CHECK_VALID(list, l_write, NULL);
-    ll_node_t *node = list->hd;
-    if (node != NULL) {
-        data = node->val;
-        list->len--;
-        list->hd = node->nxt;
-        pthread_rwlock_destroy(&(node->m));
-        free(node);
+int rcu_check_equals(const void *n, const void *ref) {
+    rcu_check((void *)n);
+    return num_equals(n, ref);
+}
+
+typedef struct {
+    ll_t *list;
+    atomic_int *stop;
+} rcu_reader_t;
+
+void *rcu_reader(void *arg) {
+    rcu_reader_t *r = (rcu_reader_t *)arg;
+    int key = 0;
+
+    while (!atomic_load(r->stop)) {
+        ll_find(r->list, rcu_check_equals, &key);
+        ll_get_n(r->list, key % 32);
+        if (key % 16 == 0)
+            ll_map(r->list, rcu_check);
+        key = (key + 7) % 1000;
     }
-    RWUNLOCK(list);
 
-    return data;
+    return NULL;
 }
 
+// nested guards: a callback of a lockless ll_map() can read the list again
+static ll_t *rcu_nested_list;
+static int rcu_nested_found;
 
-/**
- * @function ll_remove_search
- *
- * Removes the first item in the list whose value returns 1 if `cond` is called on it.
- *
- * @param list - the linked list
- * @param cond - a function that will be called on the values of each node. It should
- * return 1 of the element matches.
- *
- * @returns the new length of thew linked list on success, -1 otherwise
- */
-int ll_remove_search(ll_t *list, int cond(void *)) {
-    CHECK_VALID(list, l_write, -1);
+void rcu_nested(void *n) {
+    rcu_nested_found += ll_find(rcu_nested_list, num_equals, n) == n;
+    rcu_nested_found += ll_synchronize(rcu_nested_list) == -1; // would wait for itself
+}
 
-    ll_node_t *last = NULL;
-    ll_node_t *node = list->hd;
-    while ((node != NULL) && !(cond(node->val))) {
-        last = node;
-        node = node->nxt;
-    }
+// lockless readers never see a value torn down, writers reclaim in batches
+static void test_rcu(void) {
+    enum { N = 10, READERS = 3 };
+    int v[N];
+    int i, sum = 0;
+    pthread_t threads[READERS];
+    rcu_reader_t readers[READERS];
+    atomic_int stop;
+    void *popped[16];
+    ll_opts_t opts = {0};
+    opts.val_teardown = rcu_count_teardown;
+    opts.lock_mode = LL_LOCK_RCU;
 
-    if (node == NULL) {
-        return -1;
-    } else if (node == list->hd) {
-        list->hd = node->nxt;
-    } else {
-        RWLOCK(last, l_write);
-        last->nxt = node->nxt;
-        RWUNLOCK(last);
+    ll_t *list = ll_new_ex(&opts);
+    for (i = 0; i < N; i++) {
+        v[i] = i;
+        ll_insert_last(list, &v[i]);
     }
+    for (i = 0; i < N; i++)
+        sum += *(int *)ll_get_n(list, i) == i;
+    expect_int(N, sum);
+    expect_int(1, ll_get_n(list, N) == NULL);
+    expect_int(7, *(int *)ll_find(list, num_equals, &v[7]));
+    expect_int(N - 1, ll_remove_n(list, 3));
+    expect_int(N - 2, ll_remove_find(list, num_equals, &v[7]));
+    expect_int(N - 3, ll_remove_first(list));
+    expect_int(1, ll_find(list, num_equals, &v[7]) == NULL);
+    expect_int(0, atomic_load(&rcu_torn));          // deferred...
+    expect_int(0, ll_synchronize(list));
+    expect_int(3, atomic_load(&rcu_torn));          // ...until a grace period is over
 
-    list->val_teardown(node->val);
-    pthread_rwlock_destroy(&(node->m));
-    (list->len)--;
-    RWUNLOCK(list);
+    rcu_nested_list = list;
+    rcu_nested_found = 0;
+    ll_map(list, rcu_nested);
+    expect_int(2 * (N - 3), rcu_nested_found);
+    expect_int(-1, ll_set_index(list, num_hash, num_equals));
+    ll_delete(list);
+    expect_int(N, atomic_load(&rcu_torn));          // what was left, on deletion
 
-    free(node); // let's chat on IRC !
+    opts.pos_index = 1;
+    expect_int(1, ll_new_ex(&opts) == NULL);        // indexes, ...
+    opts.pos_index = 0;
+    opts.storage = LL_STORAGE_UNROLLED;
+    expect_int(1, ll_new_ex(&opts) == NULL);        // ...and blocks change in place
+
+    // a writer churning under the readers' feet
+    opts.storage = LL_STORAGE_NODES;
+    opts.val_teardown = rcu_free_teardown;
+    opts.pool_slab_nodes = 64;
+    list = ll_new_ex(&opts);
+    atomic_init(&stop, 0);
+    atomic_store(&rcu_bad, 0);
+    for (i = 0; i < READERS; i++) {
+        readers[i].list = list;
+        readers[i].stop = &stop;
+        pthread_create(&threads[i], NULL, rcu_reader, &readers[i]);
+    }
+    for (i = 0; i < 20000; i++) {
+        int *val = (int *)malloc(sizeof(int));
+        *val = i % 1000;
+        ll_insert_n(list, val, ll_length(list) / 2);
+        if (ll_length(list) > 32) {
+            if (i % 3 == 0)
+                ll_remove_n(list, i % 32);
+            else if (i % 3 == 1)
+                ll_remove_find(list, num_equals, val);
+            else
+                ll_remove_first(list);
+        }
+        if (i % 1000 == 999) { // popped values stay in the readers' sight until...
+            int j, n = ll_pop_many(list, popped, 16);
+            ll_synchronize(list); // ...this returns
+            for (j = 0; j < n; j++)
+                free(popped[j]);
+        }
+    }
+    atomic_store(&stop, 1);
+    for (i = 0; i < READERS; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(0, atomic_load(&rcu_bad));
+    ll_delete(list);
 
-    return list->len;
+    opts.val_teardown = ll_no_teardown;
+    opts.pool_slab_nodes = 0;
+    test_iter(opts);                                // the locked paths work as ever
+    test_map_parallel(opts);
 }
 
-/**
- * @function ll_get_n
- *
- * Gets the value of the nth element of a linked list.
- *
- * @param list - the linked list
- * @param n - the index
- *
- * @returns the `val` attribute of the nth element of `list`.
- */
-void *ll_get_n(ll_t *list, int n) {
-    ll_node_t *node = NULL;
-    void *val = NULL;
-    // ll_select_n_min_1 chacks and locks the list on our behalf
-    if (ll_select_n_min_1(list, &node, n + 1, l_read)) {
-        return NULL;
+// threads pushing and popping the same list, to make its lock contended
+typedef struct {
+    ll_t *list;
+    int popped;
+} churner_t;
+
+void *churner(void *arg) {
+    churner_t *c = (churner_t *)arg;
+    int i;
+
+    for (i = 0; i < 20000; i++) {
+        ll_insert_first(c->list, c);
+        c->popped += ll_pop_first(c->list) != NULL;
     }
-    val = node->val;
-    RWUNLOCK(node);
-    RWUNLOCK(list);
-    return val;
-}
 
-/**
- * @function ll_get_first
- *
- * Wrapper for `ll_get_n`.
- *
- * @param list - the linked list
- *
- * @returns the `val` attribute of the first element of `list`.
- */
-void *ll_get_first(ll_t *list) {
-    return ll_get_n(list, 0);
+    return NULL;
 }
 
+// every lock backend must keep the list consistent under contention
+static void test_backends(void) {
+    ll_lock_backend_t backend;
+    churner_t c[4];
+    pthread_t threads[4];
+    int i, popped;
 
-static void _ll_map_internal(ll_t *list, gen_fun_t f) {
-    ll_node_t *node = list->hd;
-
-    while (node != NULL) {
-        // f() may alterate values, so "lock write", just in case of...
-        RWLOCK(node, l_write);
-        ll_node_t *next = node->nxt;
-        f(node->val);
-        RWUNLOCK(node);
+    for (backend = LL_BACKEND_RWLOCK; backend <= LL_BACKEND_FUTEX; backend++) {
+        ll_opts_t opts = {0};
+        opts.val_teardown = ll_no_teardown;
+        opts.lock_backend = backend;
+        ll_t *list = ll_new_ex(&opts);
+        for (i = 0; i < 4; i++) {
+            c[i].list = list;
+            c[i].popped = 0;
+            pthread_create(&threads[i], NULL, churner, &c[i]);
+        }
+        popped = 0;
+        for (i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+            popped += c[i].popped;
+        }
+        expect_int(4 * 20000, popped);                 // a pop always follows a push
+        expect_int(0, ll_length(list));
+        ll_delete(list);
 
-        node = next;
+        test_positions((ll_opts_t){.lock_backend = backend});
+        test_iter((ll_opts_t){.lock_backend = backend, .pos_index = 1});
     }
+    expect_int(1, ll_new_ex(&(ll_opts_t){.lock_backend = 3}) == NULL);
 }
 
-/**
- * @function ll_map
- *
- * Calls a function on the value of every element of a linked list.
- *
- * @param list - the linked list
- * @param f - the function to call on the values.
- */
-void ll_map(ll_t *list, gen_fun_t f) {
-    CHECK_VALID(list, l_read, );
+// what a thread blocked in ll_pop_first_wait() got
+typedef struct {
+    ll_t *list;
+    void *val;
+    int err;
+} waiter_t;
 
-    _ll_map_internal(list, f);
+void *pop_waiter(void *arg) {
+    waiter_t *w = (waiter_t *)arg;
 
-    RWUNLOCK(list);
+    errno = 0;
+    w->val = ll_pop_first_wait(w->list, NULL);
+    w->err = errno;
+
+    return NULL;
 }
 
-/**
- * @function ll_print
- *
- * If `val_printer` has been set on the linked list, that function is called on the values
- * of all the elements of the linked list.
- *
- * @param list - the linked list
- */
-void ll_print(ll_t list) {
-    int len = -1;
+// consumers sleep until a value comes in, a deadline passes, or the list is closed
+static void test_wait(void) {
+    int v[2] = {0, 1};
+    struct timespec deadline;
+    pthread_t t;
+    waiter_t w = {NULL, NULL, 0};
+    struct timespec pause = {0, 20 * 1000 * 1000};
 
-    CHECK_VALID((&list), l_read, );
-    len = list.len;
+    ll_t *list = ll_new(ll_no_teardown);
+    w.list = list;
 
-    if (list.val_printer != NULL) {
-        printf("(ll:");
-        _ll_map_internal(&list, list.val_printer);
-        printf("), length: %d\n", len);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += 10 * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000 * 1000 * 1000;
     }
-    RWUNLOCK((&list));
-}
+    errno = 0;
+    expect_int(1, ll_pop_first_wait(list, &deadline) == NULL);
+    expect_int(ETIMEDOUT, errno);
 
-/**
- * @function ll_no_teardown
- *
- * A generic taredown function for values that don't need anything done.
- *
- * @param n - a pointer
- */
-void ll_no_teardown(void *n) {
-    n += 0; // compiler won't let me just return
+    pthread_create(&t, NULL, pop_waiter, &w);
+    nanosleep(&pause, NULL);                        // let it fall asleep
+    ll_insert_last(list, &v[1]);
+    pthread_join(t, NULL);
+    expect_int(1, *(int *)w.val);
+
+    pthread_create(&t, NULL, pop_waiter, &w);
+    nanosleep(&pause, NULL);
+    expect_int(0, ll_close(list));
+    pthread_join(t, NULL);
+    expect_int(1, w.val == NULL);
+    expect_int(EPIPE, w.err);
+    expect_int(-1, ll_insert_last(list, &v[0]));    // closed
+
+    ll_delete(list);
+
+    // values inserted before closing can still be drained
+    list = ll_new(ll_no_teardown);
+    ll_insert_last(list, &v[0]);
+    ll_close(list);
+    expect_int(-1, ll_insert_first(list, &v[1]));
+    expect_int(-1, ll_insert_n(list, &v[1], 1));
+    expect_int(0, *(int *)ll_pop_first_wait(list, NULL));
+    errno = 0;
+    expect_int(1, ll_pop_first_wait(list, NULL) == NULL);
+    expect_int(EPIPE, errno);
+    ll_delete(list);
+
+    // a popped `NULL` value clears `errno`, whatever was left in it
+    list = ll_new(ll_no_teardown);
+    ll_insert_last(list, NULL);
+    errno = EAGAIN;
+    expect_int(1, ll_pop_first_wait(list, NULL) == NULL);
+    expect_int(0, errno);
+    ll_delete(list);
 }
 
+typedef struct {
+    ll_t *list;
+    void *val;
+    int prio;
+    int ret;
+    int err;
+} inserter_t;
 
-/**
- * @function ll_find
- *
- * Generically searches for the first node that matches a reference value.
- *
- * @param list - the linked list
- * @param comparator - a function that will be called on the values of each node. (It should return 0 when the element matches the reference value)
- * @param ref_value - reference value passed to the comparator
- *
- * @returns pointer to value of the first matching node on success, NULL otherwise
- */
-void* ll_find(ll_t *list, comp_fun_t comparator, const void *ref_value) {
-//     int count = 0;
+void *insert_waiter(void *arg) {
+    inserter_t *w = (inserter_t *)arg;
 
-    CHECK_VALID(list, l_read, NULL);
-    ll_node_t *node = list->hd;
-    while ((node != NULL) && (comparator(node->val, ref_value) != 0)) {
-        node = node->nxt;
-//         count++;
-    }
-    RWUNLOCK(list);
+    errno = 0;
+    if (w->prio < 0)
+        w->ret = ll_insert_last_wait(w->list, w->val, NULL);
+    else
+        w->ret = ll_insert_prio_wait(w->list, w->val, w->prio, NULL);
+    w->err = errno;
 
-    return (node == NULL)? NULL : node->val;
+    return NULL;
 }
 
+// full lists refuse values, or have producers sleep until consumers make room
+static void test_bounded(ll_opts_t opts) {
+    int v[6] = {0, 1, 2, 3, 4, 5};
+    void *vals[2] = {&v[4], &v[5]};
+    struct timespec deadline;
+    pthread_t t;
+    inserter_t w = {NULL, &v[5], -1, 0, 0};
+    struct timespec pause = {0, 20 * 1000 * 1000};
 
-/**
- * @function ll_remove_find
- *
- * More generic replacement for ll_remove_search().
- *
- * @param list - the linked list
- * @param comparator - see ll_find() for details on comparator
- * @param ref_value - reference value passed to the comparator
- *
- * @returns the new length of thew linked list on success, -1 otherwise
- */
-int ll_remove_find(ll_t *list, comp_fun_t comparator, const void *ref_value) {
+    opts.val_teardown = ll_no_teardown;
+    opts.capacity = 3;
+    ll_t *list = ll_new_ex(&opts);
+    w.list = list;
 
-    int new_len = -1;
-    ll_node_t *last = NULL;
-    CHECK_VALID(list, l_write, -1);
-    ll_node_t *node = list->hd;
+    expect_int(1, ll_insert_last(list, &v[0]));
+    expect_int(2, ll_insert_first(list, &v[1]));
+    expect_int(3, ll_insert_n(list, &v[2], 1));
+    errno = 0;
+    expect_int(-1, ll_insert_last(list, &v[3]));
+    expect_int(ENOSPC, errno);
+    expect_int(-1, ll_insert_first(list, &v[3]));
+    expect_int(-1, ll_insert_n(list, &v[3], 2));
+    expect_int(-1, ll_insert_many(list, vals, 2, -1));
+    expect_int(3, ll_length(list));
+    expect_int(1, *(int *)ll_pop_first(list));
+    expect_int(-1, ll_insert_many(list, vals, 2, 0)); // all or nothing
+    expect_int(3, ll_insert_last(list, &v[3]));
 
-    while ((node != NULL) && (comparator(node->val, ref_value) != 0)) {
-        last = node;
-        node = node->nxt;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += 10 * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000 * 1000 * 1000;
     }
+    errno = 0;
+    expect_int(-1, ll_insert_last_wait(list, &v[4], &deadline));
+    expect_int(ETIMEDOUT, errno);
 
-    if (node == NULL) {
-        return -1;
-    } else if (node == list->hd) {
-        list->hd = node->nxt;
-    } else {
-        RWLOCK(last, l_write);
-        last->nxt = node->nxt;
-        RWUNLOCK(last);
+    pthread_create(&t, NULL, insert_waiter, &w);
+    nanosleep(&pause, NULL);                        // let it fall asleep
+    expect_int(3, ll_length(list));
+    expect_int(2, *(int *)ll_pop_first(list));
+    pthread_join(t, NULL);
+    expect_int(3, w.ret);
+    expect_int(5, *(int *)ll_get_n(list, 2));
+
+    pthread_create(&t, NULL, insert_waiter, &w);
+    nanosleep(&pause, NULL);
+    expect_int(2, ll_remove_n(list, 1));            // any removal makes room
+    pthread_join(t, NULL);
+    expect_int(3, w.ret);
+
+    pthread_create(&t, NULL, insert_waiter, &w);
+    nanosleep(&pause, NULL);
+    expect_int(0, ll_close(list));
+    pthread_join(t, NULL);
+    expect_int(-1, w.ret);
+    expect_int(EPIPE, w.err);
+    ll_delete(list);
+
+    // bounded producers and consumers see every value through
+    list = ll_new_ex(&opts);
+    w.list = list;
+    w.val = &v[0];
+    pthread_t producers[4];
+    inserter_t p[4];
+    int i, n;
+    for (i = 0; i < 4; i++) {
+        p[i] = w;
+        pthread_create(&producers[i], NULL, insert_waiter, &p[i]);
     }
+    for (n = 0; n < 4; n++)
+        expect_int(0, *(int *)ll_pop_first_wait(list, NULL));
+    for (i = 0; i < 4; i++) {
+        pthread_join(producers[i], NULL);
+        expect_int(1, p[i].ret > 0);
+    }
+    expect_int(0, ll_length(list));
+    ll_delete(list);
 
-    list->val_teardown(node->val);
-    pthread_rwlock_destroy(&(node->m));
-    free(node);
-    (list->len)--;
-    new_len = list->len;
-    RWUNLOCK(list);
+    opts.order = num_order;                         // refused, not because it is full
+    if (opts.storage == LL_STORAGE_NODES && (list = ll_new_ex(&opts)) != NULL) {
+        errno = 0;
+        expect_int(-1, ll_insert_last_wait(list, &v[0], NULL));
+        expect_int(EINVAL, errno);
+        ll_delete(list);
+    }
 
-    return new_len;
+    expect_int(1, ll_new_ex(&(ll_opts_t){.capacity = -1}) == NULL);
 }
 
+// whether the readiness descriptor of a list is readable, reading it if so
+static int event_posted(int fd) {
+    struct pollfd p = {.fd = fd, .events = POLLIN};
+    uint64_t n;
 
+    if (poll(&p, 1, 0) != 1)
+        return 0;
 
+    return read(fd, &n, sizeof(n)) == sizeof(n);
+}
 
+// the try functions fail rather than wait for the lock, and the readiness descriptor is
+// posted whenever trying again may work
+static void test_try(ll_opts_t opts) {
+    static int v[3] = {0, 1, 2};
+    void *vals[4];
+    void *val;
 
+    opts.val_teardown = ll_no_teardown;
+    opts.capacity = 2;
+    ll_t *list = ll_new_ex(&opts);
+    int fd = ll_event_fd(list);
+    expect_int(1, fd >= 0);
+    expect_int(fd, ll_event_fd(list));
+    expect_int(1, event_posted(fd));                 // try the list first
+    expect_int(0, ll_try_pop_first(list, &val));     // empty...
+    expect_int(0, event_posted(fd));
+    expect_int(1, ll_try_insert_last(list, &v[0]));  // ...not anymore
+    expect_int(1, event_posted(fd));
+    expect_int(2, ll_try_insert_last(list, &v[1]));
+    expect_int(0, event_posted(fd));                 // nobody found it empty since
+    expect_int(-1, ll_try_insert_last(list, &v[2]));
+    expect_int(ENOSPC, errno);
+    expect_int(1, ll_try_pop_first(list, &val));     // room again
+    expect_int(0, *(int *)val);
+    expect_int(1, event_posted(fd));
 
-#ifdef LL
-/* this following code is just for testing this library */
+    RWLOCK(list, l_write);                           // as another thread would
+    expect_int(-1, ll_try_pop_first(list, &val));
+    expect_int(EAGAIN, errno);
+    event_posted(fd);                                // once at most, unsure of this holder
+    expect_int(-1, ll_try_pop_many(list, vals, 4));
+    expect_int(EAGAIN, errno);
+    expect_int(-1, ll_try_insert_last(list, &v[2]));
+    expect_int(EAGAIN, errno);
+    expect_int(0, event_posted(fd));                 // no use coming back yet...
+    RWUNLOCK(list);
+    expect_int(1, event_posted(fd));                 // ...but now
+    expect_int(1, ll_length(list));
+    expect_int(0, event_posted(fd));                 // nobody found it locked since
 
-void num_teardown(void *n) {
-    *(int *)n *= -1; // just so we can visually inspect removals afterwards
+    expect_int(2, ll_try_insert_last(list, &v[2]));
+    expect_int(2, ll_try_pop_many(list, vals, 4));
+    expect_int(1, *(int *)vals[0]);
+    expect_int(2, *(int *)vals[1]);
+    expect_int(0, ll_try_pop_many(list, vals, 4));
+    expect_int(0, ll_close(list));
+    expect_int(1, event_posted(fd));
+    expect_int(-1, ll_try_insert_last(list, &v[0]));
+    expect_int(EPIPE, errno);
+    ll_delete(list);
 }
 
-void num_printer(void *n) {
-    printf(" %d", *(int *)n);
-}
+// an event loop thread draining the list as inserting threads fill it, sleeping in
+// `poll()` in between: no insertion goes unnoticed
+static void test_event_loop(ll_opts_t opts) {
+    pthread_t threads[4];
+    struct pollfd p;
+    void *val;
+    int popped = 0;
+    int i;
 
-int num_equals_3(void *n) {
-    return *(int *)n == 3;
+    opts.val_teardown = ll_no_teardown;
+    ll_t *list = ll_new_ex(&opts);
+    p.fd = ll_event_fd(list);
+    p.events = POLLIN;
+    for (i = 0; i < 4; i++)
+        pthread_create(&threads[i], NULL, stats_inserter, list);
+    while (popped < 4000 && poll(&p, 1, 10000) == 1) {
+        event_posted(p.fd);
+        while (ll_try_pop_first(list, &val) == 1)
+            popped++;
+    }
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(4000, popped);
+    ll_delete(list);
 }
 
-int num_equals(const void *n, const void *ref) {
-    return *(const int *)n - *(const int *)ref;
+// the front of a list with priorities is always the oldest of its most urgent values
+static void test_priorities(ll_opts_t opts) {
+    enum { N = 8 };
+    static int v[N];
+    int *ref[N];
+    int i;
+
+    for (i = 0; i < N; i++)
+        v[i] = i;
+    opts.val_teardown = ll_no_teardown;
+    opts.priorities = 3;
+    ll_t *list = ll_new_ex(&opts);
+
+    expect_int(1, ll_insert_prio(list, &v[0], 2));
+    expect_int(2, ll_insert_prio(list, &v[1], 0));
+    expect_int(3, ll_insert_prio(list, &v[2], 1));
+    expect_int(4, ll_insert_prio(list, &v[3], 0));
+    expect_int(5, ll_insert_prio(list, &v[4], 2));
+    expect_int(-1, ll_insert_prio(list, &v[5], 3));
+    expect_int(-1, ll_insert_prio(list, &v[5], -1));
+    ref[0] = &v[1]; ref[1] = &v[3]; ref[2] = &v[2]; ref[3] = &v[0]; ref[4] = &v[4];
+    expect_int(1, list_is(list, ref, 5));
+
+    expect_int(1, *(int *)ll_pop_first(list));
+    expect_int(3, *(int *)ll_pop_first(list));
+    expect_int(4, ll_insert_prio(list, &v[5], 0)); // level 0 empty, goes before level 1
+    ref[0] = &v[5]; ref[1] = &v[2]; ref[2] = &v[0]; ref[3] = &v[4];
+    expect_int(1, list_is(list, ref, 4));
+
+    // the levels follow other insertions and removals
+    expect_int(3, ll_remove_n(list, 1));           // level 1 empty
+    expect_int(4, ll_insert_prio(list, &v[6], 1));
+    expect_int(5, ll_insert_last(list, &v[7]));    // least urgent
+    expect_int(4, ll_remove_find(list, num_equals, &v[4]));
+    expect_int(5, ll_insert_prio(list, &v[1], 2));
+    ref[0] = &v[5]; ref[1] = &v[6]; ref[2] = &v[0]; ref[3] = &v[7]; ref[4] = &v[1];
+    expect_int(1, list_is(list, ref, 5));
+    expect_int(6, ll_insert_first(list, &v[2]));   // joins level 0, at its front
+    expect_int(7, ll_insert_prio(list, &v[3], 0));
+    ref[0] = &v[2]; ref[1] = &v[5]; ref[2] = &v[3];
+    ref[3] = &v[6]; ref[4] = &v[0]; ref[5] = &v[7]; ref[6] = &v[1];
+    expect_int(1, list_is(list, ref, 7));
+
+    void *out[3];
+    expect_int(3, ll_pop_many(list, out, 3));      // all of level 0
+    expect_int(5, ll_insert_prio(list, &v[4], 0));
+    expect_int(4, *(int *)ll_pop_first(list));
+    expect_int(6, *(int *)ll_pop_first(list));
+    expect_int(0, *(int *)ll_pop_first(list));
+    expect_int(3, ll_insert_prio(list, &v[4], 1)); // before the rest of level 2
+    expect_int(4, *(int *)ll_pop_first(list));
+    expect_int(2, ll_length(list));
+
+    ll_delete(list);
+
+    // bounded lists with priorities
+    opts.capacity = 2;
+    list = ll_new_ex(&opts);
+    pthread_t t;
+    inserter_t w = {list, &v[0], 0, 0, 0};
+    struct timespec pause = {0, 20 * 1000 * 1000};
+    expect_int(1, ll_insert_prio(list, &v[1], 1));
+    expect_int(2, ll_insert_prio(list, &v[2], 1));
+    errno = 0;
+    expect_int(-1, ll_insert_prio(list, &v[3], 0));
+    expect_int(ENOSPC, errno);
+    pthread_create(&t, NULL, insert_waiter, &w);
+    nanosleep(&pause, NULL);
+    expect_int(1, *(int *)ll_pop_first(list));
+    pthread_join(t, NULL);
+    expect_int(2, w.ret);
+    expect_int(0, *(int *)ll_pop_first(list));     // urgent work first
+    errno = 0;
+    expect_int(-1, ll_insert_prio_wait(list, &v[3], 3, NULL));
+    expect_int(EINVAL, errno);
+    ll_delete(list);
+
+    expect_int(-1, ll_insert_prio(list = ll_new(ll_no_teardown), &v[0], 0));
+    ll_delete(list);
+    expect_int(1, ll_new_ex(&(ll_opts_t){.priorities = 2,
+                                         .storage = LL_STORAGE_UNROLLED}) == NULL);
+    expect_int(1, ll_new_ex(&(ll_opts_t){.priorities = 2, .doubly_linked = 1}) == NULL);
+    expect_int(1, ll_new_ex(&(ll_opts_t){.priorities = 2, .order = num_order}) == NULL);
 }
 
 int main() {
     int *_n; // for storing returned ones
-    int test_count = 1;
-    int fail_count = 0;
     int a = 0;
     int b = 1;
     int c = 2;
@@ -690,16 +5534,21 @@ int main() {
 
     ll_insert_n(list, &g, 6); // 6 at index 6 -> 0, 1, 2, 3, 4, 5, 6
 
-    int _i;
-    for (_i = 0; _i < list->len; _i++) { // O(n^2) test lol
-        _n = (int *)ll_get_n(list, _i);
+    int _i = 0;
+    void *_v;
+    ll_iter_t _it;
+    ll_iter_begin(list, &_it, 0);
+    while (ll_iter_next(&_it, &_v)) { // O(n) now
+        _n = (int *)_v;
         if (!(*_n == _i)) {
             fail_count++;
             fprintf(stderr, "FAIL Test %d: Expected %d, but got %d.\n", 1, _i, *_n);
         } else
             fprintf(stderr, "PASS Test %d!\n", test_count);
         test_count++;
+        _i++;
     }
+    ll_iter_end(&_it);
 
     // (ll: 0 1 2 3 4 5 6), length: 7
 
@@ -731,6 +5580,80 @@ int main() {
 
     ll_delete(list);
 
+    test_tail();
+    test_pool();
+    test_lock_list(0);
+    test_lock_list(4);
+    test_batch(0, LL_STORAGE_NODES);
+    test_batch(4, LL_STORAGE_NODES);
+    test_batch(0, LL_STORAGE_UNROLLED);
+    test_batch(4, LL_STORAGE_UNROLLED);
+    test_positions((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_positions((ll_opts_t){.storage = LL_STORAGE_UNROLLED, .pool_slab_nodes = 4});
+    test_positions((ll_opts_t){.pos_index = 1});
+    test_positions((ll_opts_t){.pos_index = 1, .lock_mode = LL_LOCK_LIST,
+                               .pool_slab_nodes = 4});
+    test_hash(0);
+    test_hash(1);
+    test_iter((ll_opts_t){0});
+    test_iter((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pos_index = 1});
+    test_iter((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_map_parallel((ll_opts_t){0});
+    test_map_parallel((ll_opts_t){.lock_mode = LL_LOCK_LIST});
+    test_map_parallel((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_length();
+    test_backends();
+    test_rcu();
+    test_async_teardown(LL_STORAGE_NODES, LL_LOCK_NODES);
+    test_async_teardown(LL_STORAGE_UNROLLED, LL_LOCK_LIST);
+    test_async_teardown(LL_STORAGE_NODES, LL_LOCK_RCU);
+    test_async_null();
+    test_reset((ll_opts_t){0});
+    test_reset((ll_opts_t){.async_teardown = 1});
+    test_reset((ll_opts_t){.async_teardown = 1, .pool_slab_nodes = 16, .pos_index = 1});
+    test_reset((ll_opts_t){.async_teardown = 1, .lock_mode = LL_LOCK_LIST, .priorities = 2});
+    test_reset((ll_opts_t){.async_teardown = 1, .doubly_linked = 1, .pool_slab_nodes = 8});
+    test_reset((ll_opts_t){.async_teardown = 1, .lock_mode = LL_LOCK_RCU});
+    test_reset((ll_opts_t){.async_teardown = 1, .storage = LL_STORAGE_UNROLLED});
+    test_doubly(LL_LOCK_NODES);
+    test_doubly(LL_LOCK_LIST);
+    test_doubly(LL_LOCK_RCU);
+    test_sorted((ll_opts_t){0});
+    test_sorted((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pos_index = 1});
+    test_sorted((ll_opts_t){.lock_mode = LL_LOCK_RCU});
+    test_splice((ll_opts_t){0});
+    test_splice((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pos_index = 1});
+    test_splice((ll_opts_t){.doubly_linked = 1, .pool_slab_nodes = 8});
+    test_splice_modes();
+    test_keys(0);
+    test_keys(4);
+    test_tmpl();
+    test_snapshot((ll_opts_t){0});
+    test_snapshot((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pool_slab_nodes = 4});
+    test_snapshot((ll_opts_t){.lock_mode = LL_LOCK_RCU});
+    test_snapshot((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_snapshot((ll_opts_t){.async_teardown = 1});
+    test_file((ll_opts_t){0});
+    test_file((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_file((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pos_index = 1, .order = str_order});
+    test_stats();
+    test_numa(LL_STORAGE_NODES);
+    test_numa(LL_STORAGE_UNROLLED);
+    test_wait();
+    test_bounded((ll_opts_t){0});
+    test_bounded((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pool_slab_nodes = 4});
+    test_bounded((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_priorities((ll_opts_t){0});
+    test_priorities((ll_opts_t){.lock_mode = LL_LOCK_LIST, .pos_index = 1});
+    test_priorities((ll_opts_t){.lock_mode = LL_LOCK_RCU});
+    test_try((ll_opts_t){0});
+    test_try((ll_opts_t){.lock_mode = LL_LOCK_LIST, .lock_backend = LL_BACKEND_TICKET});
+    test_try((ll_opts_t){.lock_backend = LL_BACKEND_FUTEX, .pool_slab_nodes = 4});
+    test_try((ll_opts_t){.lock_mode = LL_LOCK_RCU, .priorities = 2});
+    test_try((ll_opts_t){.storage = LL_STORAGE_UNROLLED});
+    test_event_loop((ll_opts_t){0});
+    test_event_loop((ll_opts_t){.lock_backend = LL_BACKEND_FUTEX});
+
     if (fail_count) {
         fprintf(stderr, "FAILED %d tests of %d.\n", fail_count, test_count);
         return fail_count;
@@ -0,0 +1,357 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_epoch.c implements the epoch-based reclamation of `LL_LOCK_RCU` lists.
+ *
+ * A global epoch counter moves forward whenever every thread in a read-side critical
+ * section has seen its current value. Something retired during epoch `e` was unlinked
+ * before the epoch reached `e + 1`, so once it reaches `e + 2` none of the readers left
+ * can have started early enough to see it. Each thread publishes the epoch it entered
+ * with in a record of its own, which writers scan: readers never write to anything shared.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ll_epoch.h"
+
+/* macros */
+
+// pointers retired between two attempts to reclaim some
+#define LL_EPOCH_BATCH 64
+
+/* type definitions */
+
+struct ll_epoch_rec;
+
+// ll_epoch_rec is what a thread publishes about its read-side critical sections. records
+// are never freed: those of the threads that exited are taken over by new ones
+struct ll_epoch_rec {
+    // the global epoch seen when entering, shifted left by one, the lowest bit being set
+    // while in a critical section (0 outside)
+    atomic_ulong state;
+
+    // nesting depth of the critical sections, only touched by the owner
+    int nest;
+
+    // whether a thread owns the record
+    atomic_int taken;
+
+    // the next record
+    struct ll_epoch_rec *nxt;
+};
+
+// a retired pointer, along with the global epoch it was retired in
+typedef struct {
+    void *ptr;
+    int arg;
+    unsigned long epoch;
+} ll_retired_t;
+
+// ll_epoch models the pointers a list retired
+struct ll_epoch {
+    // reclaims a pointer
+    ll_epoch_fun_t reclaim;
+    void *ctx;
+
+    // the pointers still retired, oldest first, from `head` to `n`
+    ll_retired_t *retired;
+    size_t head;
+    size_t n;
+    size_t cap;
+
+    // number of pointers retired at which reclaiming is tried next
+    size_t next_try;
+};
+
+/* globals */
+
+// the global epoch
+static atomic_ulong ll_epoch_global = 1;
+
+// the records of all the threads that ever entered a critical section
+static struct ll_epoch_rec *_Atomic ll_epoch_recs = NULL;
+
+// gives the record of a thread back when it exits
+static pthread_once_t ll_epoch_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ll_epoch_key;
+static int ll_epoch_key_ok = 0;
+
+// the record of the calling thread, `NULL` until it first enters a critical section
+static _Thread_local struct ll_epoch_rec *ll_epoch_self = NULL;
+
+/**
+ * @function _ll_epoch_release_rec
+ *
+ * Thread exit destructor: the record can be taken over by another thread.
+ *
+ * @param rec - the record of the exiting thread
+ */
+static void _ll_epoch_release_rec(void *rec) {
+    atomic_store(&((struct ll_epoch_rec *)rec)->taken, 0);
+}
+
+static void _ll_epoch_make_key(void) {
+    ll_epoch_key_ok = pthread_key_create(&ll_epoch_key, _ll_epoch_release_rec) == 0;
+}
+
+/**
+ * @function _ll_epoch_rec
+ *
+ * Finds the record of the calling thread, taking over one left by an exited thread or
+ * allocating and registering a new one the first time around.
+ *
+ * @returns the record, `NULL` if out of memory
+ */
+static struct ll_epoch_rec *_ll_epoch_rec(void) {
+    struct ll_epoch_rec *rec = ll_epoch_self;
+
+    if (rec != NULL)
+        return rec;
+    pthread_once(&ll_epoch_once, _ll_epoch_make_key);
+    for (rec = atomic_load(&ll_epoch_recs); rec != NULL; rec = rec->nxt) {
+        int free = 0;
+        if (atomic_compare_exchange_strong(&rec->taken, &free, 1))
+            break;
+    }
+    if (rec == NULL) {
+        rec = (struct ll_epoch_rec *)malloc(sizeof(struct ll_epoch_rec));
+        if (rec == NULL)
+            return NULL;
+        atomic_init(&rec->state, 0);
+        atomic_init(&rec->taken, 1);
+        rec->nxt = atomic_load(&ll_epoch_recs);
+        while (!atomic_compare_exchange_weak(&ll_epoch_recs, &rec->nxt, rec))
+            ;
+    }
+    rec->nest = 0;
+    if (ll_epoch_key_ok)
+        pthread_setspecific(ll_epoch_key, rec);
+    ll_epoch_self = rec;
+
+    return rec;
+}
+
+/**
+ * @function ll_epoch_enter
+ *
+ * Publishes the current global epoch in the record of the thread, unless it already is in
+ * a critical section. The fence orders that store before the loads of the traversal that
+ * follows, with respect to the fences of the writers scanning the records.
+ *
+ * @returns 0 if successful, -1 if out of memory
+ */
+int ll_epoch_enter(void) {
+    struct ll_epoch_rec *rec = _ll_epoch_rec();
+
+    if (rec == NULL)
+        return -1;
+    if (rec->nest++ == 0) {
+        atomic_store(&rec->state, atomic_load(&ll_epoch_global) << 1 | 1);
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+
+    return 0;
+}
+
+/**
+ * @function ll_epoch_exit
+ *
+ * Leaves a critical section. The release store orders the loads of the traversal before
+ * the reclamation of what it saw.
+ */
+void ll_epoch_exit(void) {
+    struct ll_epoch_rec *rec = ll_epoch_self;
+
+    if (--rec->nest == 0)
+        atomic_store_explicit(&rec->state, 0, memory_order_release);
+}
+
+/**
+ * @function _ll_epoch_advance
+ *
+ * Moves the global epoch forward if every thread in a critical section entered it during
+ * the current one.
+ *
+ * @returns the global epoch
+ */
+static unsigned long _ll_epoch_advance(void) {
+    struct ll_epoch_rec *rec;
+    unsigned long epoch;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    epoch = atomic_load(&ll_epoch_global);
+    for (rec = atomic_load(&ll_epoch_recs); rec != NULL; rec = rec->nxt) {
+        unsigned long state = atomic_load(&rec->state);
+        if ((state & 1) && state >> 1 != epoch)
+            return epoch;
+    }
+    // on failure, another thread moved it forward and `epoch` is its new value
+    if (atomic_compare_exchange_strong(&ll_epoch_global, &epoch, epoch + 1))
+        epoch++;
+
+    return epoch;
+}
+
+/**
+ * @function _ll_epoch_collect
+ *
+ * Reclaims the oldest retired pointers, up to the first one retired too recently for
+ * `epoch`.
+ *
+ * @param ep - the retired pointers
+ * @param epoch - the global epoch
+ */
+static void _ll_epoch_collect(ll_epoch_t *ep, unsigned long epoch) {
+    while (ep->head < ep->n && ep->retired[ep->head].epoch + 2 <= epoch) {
+        ll_retired_t *r = &ep->retired[ep->head++];
+        ep->reclaim(ep->ctx, r->ptr, r->arg);
+    }
+    if (ep->head == ep->n)
+        ep->head = ep->n = 0;
+}
+
+/**
+ * @function ll_epoch_new
+ *
+ * Allocates an empty set of retired pointers, the array holding them being allocated by
+ * the first retirement.
+ *
+ * @param reclaim - called on each pointer once it can be reclaimed
+ * @param ctx - passed to `reclaim`
+ *
+ * @returns a pointer to the new set, `NULL` on failure
+ */
+ll_epoch_t *ll_epoch_new(ll_epoch_fun_t reclaim, void *ctx) {
+    ll_epoch_t *ep = (ll_epoch_t *)malloc(sizeof(ll_epoch_t));
+
+    if (ep == NULL)
+        return NULL;
+    ep->reclaim = reclaim;
+    ep->ctx = ctx;
+    ep->retired = NULL;
+    ep->head = 0;
+    ep->n = 0;
+    ep->cap = 0;
+    ep->next_try = LL_EPOCH_BATCH;
+
+    return ep;
+}
+
+/**
+ * @function ll_epoch_delete
+ *
+ * Reclaims all the pointers still retired, whatever their epoch, and frees the set.
+ *
+ * @param ep - the retired pointers
+ */
+void ll_epoch_delete(ll_epoch_t *ep) {
+    for (; ep->head < ep->n; ep->head++)
+        ep->reclaim(ep->ctx, ep->retired[ep->head].ptr, ep->retired[ep->head].arg);
+    free(ep->retired);
+    free(ep);
+}
+
+/**
+ * @function ll_epoch_retire
+ *
+ * Records `ptr` with the current global epoch (read after a fence, so that the unlinking
+ * that made it unreachable comes first). Every `LL_EPOCH_BATCH` pointers, the global
+ * epoch is moved forward (twice, which is enough to reclaim everything when no reader is
+ * around) and the pointers old enough are reclaimed.
+ *
+ * @param ep - the retired pointers
+ * @param ptr - the pointer to retire
+ * @param arg - passed to the reclaim function along with `ptr`
+ */
+void ll_epoch_retire(ll_epoch_t *ep, void *ptr, int arg) {
+    if (ep->n == ep->cap && ep->head >= ep->n / 2 && ep->head > 0) {
+        memmove(ep->retired, ep->retired + ep->head,
+                (ep->n - ep->head) * sizeof(ll_retired_t));
+        ep->n -= ep->head;
+        ep->head = 0;
+    }
+    if (ep->n == ep->cap) {
+        size_t cap = ep->cap == 0 ? LL_EPOCH_BATCH : 2 * ep->cap;
+        ll_retired_t *grown = (ll_retired_t *)realloc(ep->retired, cap * sizeof(ll_retired_t));
+        if (grown == NULL) {
+            if (ll_epoch_wait() == 0) {
+                ll_epoch_collect(ep);
+                ep->reclaim(ep->ctx, ptr, arg);
+            }
+            return;
+        }
+        ep->retired = grown;
+        ep->cap = cap;
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+    ep->retired[ep->n].ptr = ptr;
+    ep->retired[ep->n].arg = arg;
+    ep->retired[ep->n].epoch = atomic_load(&ll_epoch_global);
+    ep->n++;
+    if (ep->n - ep->head >= ep->next_try) {
+        _ll_epoch_advance();
+        _ll_epoch_collect(ep, _ll_epoch_advance());
+        ep->next_try = ep->n - ep->head + LL_EPOCH_BATCH;
+    }
+}
+
+/**
+ * @function ll_epoch_wait
+ *
+ * Moves the global epoch two steps past the current one, yielding while readers that
+ * entered earlier are still in their critical sections.
+ *
+ * @returns 0 if successful, -1 if the calling thread is in a critical section
+ */
+int ll_epoch_wait(void) {
+    unsigned long target;
+
+    if (ll_epoch_self != NULL && ll_epoch_self->nest > 0)
+        return -1;
+    atomic_thread_fence(memory_order_seq_cst);
+    target = atomic_load(&ll_epoch_global) + 2;
+    while (_ll_epoch_advance() < target)
+        sched_yield();
+
+    return 0;
+}
+
+/**
+ * @function ll_epoch_collect
+ *
+ * Reclaims the retired pointers that the current global epoch allows.
+ *
+ * @param ep - the retired pointers
+ */
+void ll_epoch_collect(ll_epoch_t *ep) {
+    _ll_epoch_collect(ep, atomic_load(&ll_epoch_global));
+}
@@ -0,0 +1,79 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_epoch.h declares the epoch-based reclamation behind the lockless readers of
+ * `LL_LOCK_RCU` lists. It is internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_EPOCH_H
+#define LL_EPOCH_H
+
+#include <stddef.h>
+
+/* type definitions */
+
+// what a list retired and can't reclaim until the readers that may still see it are done
+typedef struct ll_epoch ll_epoch_t;
+
+// reclaims `ptr`, retired with `arg`, on behalf of `ctx` (see `ll_epoch_new()`)
+typedef void (*ll_epoch_fun_t)(void *ctx, void *ptr, int arg);
+
+/* function prototypes */
+
+// enters a read-side critical section, shared by all the lists of the process: nothing
+// retired from now on is reclaimed before the matching `ll_epoch_exit()`. sections nest.
+// returns 0 if successful, -1 if the thread couldn't be registered (out of memory)
+int ll_epoch_enter(void);
+
+// leaves the read-side critical section entered last
+void ll_epoch_exit(void);
+
+// returns an empty set of retired pointers, reclaimed by calling `reclaim` with `ctx`.
+// `NULL` if out of memory
+ll_epoch_t *ll_epoch_new(ll_epoch_fun_t reclaim, void *ctx);
+
+// reclaims everything still retired at once and frees `ep`: no reader may be left
+void ll_epoch_delete(ll_epoch_t *ep);
+
+// retires `ptr`, which readers can't reach anymore but may still be looking at, and
+// reclaims what past grace periods allow. calls on a given `ep` are serialized by the
+// caller (the write lock of the list). should there be no memory to keep `ptr`, it waits
+// for the readers to reclaim it right away (or leaks it, from a read-side critical section)
+void ll_epoch_retire(ll_epoch_t *ep, void *ptr, int arg);
+
+// waits for a grace period: returns once every read-side critical section in progress
+// has been left, so that whatever was retired before can be reclaimed.
+// returns 0 if successful, -1 if called from a read-side critical section (it would wait
+// for itself)
+int ll_epoch_wait(void);
+
+// reclaims the retired pointers no reader can see anymore (all of them, after
+// `ll_epoch_wait()`). serialized like `ll_epoch_retire()`
+void ll_epoch_collect(ll_epoch_t *ep);
+
+// LL_EPOCH_H
+#endif
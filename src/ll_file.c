@@ -0,0 +1,377 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_file.c saves lists to files and maps them back (`ll_save()` and
+ * `ll_load_mmap()`). A file is a header, an array of entries (where each value is in the
+ * arena, and how long it is), then the arena of serialized values, each aligned on
+ * `LL_FILE_ALIGN` bytes. Loading maps the file privately and links nodes pointing into the
+ * arena, whose pages are only read in once the values are used.
+ *
+ * Files are in the byte order and type sizes of the machine that saved them.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ll_internal.h"
+
+/* macros */
+
+// values are aligned in the arena (so that structs can be used in place), and the arena
+// on a cache line
+#define LL_FILE_ALIGN 8
+#define LL_FILE_ARENA_ALIGN 64
+#define ALIGN_UP(n, a) (((n) + (a) - 1) / (a) * (a))
+
+// what `ll_save()` buffers before writing
+#define LL_FILE_BUF (1 << 16)
+
+// values linked per `ll_insert_many()` by `ll_load_mmap()`, and the largest slab of the
+// node pool it gives the lists that have none
+#define LL_LOAD_BATCH 1024
+#define LL_LOAD_SLAB_NODES 4096
+
+#define LL_FILE_MAGIC "llfile\0"
+#define LL_FILE_VERSION 1
+#define LL_FILE_BYTE_ORDER 0x01020304u
+
+/* type definitions */
+
+// the header of a file
+typedef struct {
+    char magic[8];
+    uint32_t version;
+
+    // `LL_FILE_BYTE_ORDER` as written by the machine that saved the file
+    uint32_t byte_order;
+
+    // number of values, and where their arena is in the file (and how long it is)
+    uint64_t count;
+    uint64_t arena_off;
+    uint64_t arena_len;
+} ll_file_header_t;
+
+// where a value is in the arena, one per value, in order
+typedef struct {
+    uint64_t off;
+    uint64_t len;
+} ll_file_entry_t;
+
+// buffered writes to a file descriptor
+typedef struct {
+    int fd;
+    size_t used;
+    char buf[LL_FILE_BUF];
+} ll_file_out_t;
+
+/* static functions */
+
+/**
+ * @function ll_file_write
+ *
+ * Writes `len` bytes to a file descriptor, resuming after partial writes and signals.
+ *
+ * @param fd - the file descriptor
+ * @param buf - the bytes
+ * @param len - the number of bytes
+ *
+ * @returns 0 if successful, -1 otherwise (`errno` tells why)
+ */
+static int ll_file_write(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/**
+ * @function ll_file_flush
+ *
+ * @param out - the buffered output
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+static int ll_file_flush(ll_file_out_t *out) {
+    int ret = ll_file_write(out->fd, out->buf, out->used);
+
+    out->used = 0;
+    return ret;
+}
+
+/**
+ * @function ll_file_put
+ *
+ * Appends bytes to the buffered output, `NULL` ones being zeros (for padding).
+ *
+ * @param out - the buffered output
+ * @param buf - the bytes, `NULL` for zeros
+ * @param len - the number of bytes
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+static int ll_file_put(ll_file_out_t *out, const void *buf, size_t len) {
+    while (len > 0) {
+        size_t n = LL_FILE_BUF - out->used;
+        if (n == 0) {
+            if (ll_file_flush(out))
+                return -1;
+            continue;
+        }
+        if (n > len)
+            n = len;
+        if (buf == NULL) {
+            memset(&out->buf[out->used], 0, n);
+        } else {
+            memcpy(&out->buf[out->used], buf, n);
+            buf = (const char *)buf + n;
+        }
+        out->used += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/**
+ * @function ll_file_put_value
+ *
+ * Serializes a value into the buffered output, padded to `LL_FILE_ALIGN` bytes, straight
+ * into the buffer when it fits.
+ *
+ * @param out - the buffered output
+ * @param serialize - the serializer, see `ser_fun_t`
+ * @param val - the value
+ * @param len - its serialized size, as the serializer told before
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+static int ll_file_put_value(ll_file_out_t *out, ser_fun_t serialize, const void *val,
+                             size_t len) {
+    if (len > LL_FILE_BUF - out->used && ll_file_flush(out))
+        return -1;
+    if (len <= LL_FILE_BUF - out->used) {
+        if (serialize(val, &out->buf[out->used], len) != len)
+            goto changed;
+        out->used += len;
+    } else { // larger than the buffer
+        char *tmp = (char *)malloc(len);
+        if (tmp == NULL)
+            return -1;
+        if (serialize(val, tmp, len) != len) {
+            free(tmp);
+            goto changed;
+        }
+        int ret = ll_file_write(out->fd, tmp, len);
+        free(tmp);
+        if (ret)
+            return -1;
+    }
+
+    return ll_file_put(out, NULL, ALIGN_UP(len, LL_FILE_ALIGN) - len);
+
+changed: // the value changed between the two passes of `ll_save()`
+    errno = EINVAL;
+    return -1;
+}
+
+/* API */
+
+/**
+ * @function ll_save
+ *
+ * Writes the values of the list to `fd` in the format of `ll_load_mmap()`. The values are
+ * taken from a snapshot (see `ll_snapshot()`), so that the list is only locked to copy
+ * them, and serialized twice: once for their sizes, then into the file.
+ *
+ * @param list - the linked list
+ * @param fd - the file descriptor written to, from its current offset
+ * @param serialize - how values are written, see `ser_fun_t`
+ *
+ * @returns the number of values saved if successful, -1 otherwise (`errno` tells why)
+ */
+int ll_save(ll_t *list, int fd, ser_fun_t serialize) {
+    ll_snapshot_t *snap = ll_snapshot(list);
+    ll_file_entry_t *entries = NULL;
+    ll_file_out_t *out = NULL;
+    ll_file_header_t hdr;
+    uint64_t arena_len = 0;
+    int i, n, ret = -1;
+
+    if (snap == NULL) {
+        errno = ll_length(list) < 0 ? EINVAL : ENOMEM;
+        return -1;
+    }
+    n = ll_snapshot_length(snap);
+    entries = (ll_file_entry_t *)malloc((n > 0 ? n : 1) * sizeof(ll_file_entry_t));
+    out = (ll_file_out_t *)malloc(sizeof(ll_file_out_t));
+    if (entries == NULL || out == NULL)
+        goto done;
+    for (i = 0; i < n; i++) {
+        size_t len = serialize(ll_snapshot_get_n(snap, i), NULL, 0);
+        if (len == SIZE_MAX) {
+            errno = EINVAL;
+            goto done;
+        }
+        entries[i].off = arena_len;
+        entries[i].len = len;
+        arena_len += ALIGN_UP(len, LL_FILE_ALIGN);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, LL_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = LL_FILE_VERSION;
+    hdr.byte_order = LL_FILE_BYTE_ORDER;
+    hdr.count = (uint64_t)n;
+    hdr.arena_off = ALIGN_UP(sizeof(hdr) + n * sizeof(ll_file_entry_t), LL_FILE_ARENA_ALIGN);
+    hdr.arena_len = arena_len;
+    out->fd = fd;
+    out->used = 0;
+    if (ll_file_put(out, &hdr, sizeof(hdr)) ||
+        ll_file_put(out, entries, n * sizeof(ll_file_entry_t)) ||
+        ll_file_put(out, NULL, hdr.arena_off - sizeof(hdr) - n * sizeof(ll_file_entry_t)))
+        goto done;
+    for (i = 0; i < n; i++)
+        if (ll_file_put_value(out, serialize, ll_snapshot_get_n(snap, i), entries[i].len))
+            goto done;
+    if (ll_file_flush(out) == 0)
+        ret = n;
+
+done:
+    free(out);
+    free(entries);
+    ll_snapshot_release(snap);
+    return ret;
+}
+
+/**
+ * @function ll_load_mmap
+ *
+ * Maps a file written by `ll_save()` and makes a list of its values, which point into the
+ * mapping. The file is checked first (header, then every entry, then the order of the
+ * values for sorted lists), so that a damaged file doesn't get as far as making a list. Node storage lists without a pool get one, so that
+ * loading costs an allocation per `LL_LOAD_SLAB_NODES` nodes rather than one per node.
+ *
+ * @param path - the file
+ * @param opts - the options of the list, see `ll_opts_t`
+ *
+ * @returns the new list on success, NULL otherwise (`errno` tells why)
+ */
+ll_t *ll_load_mmap(const char *path, const ll_opts_t *opts) {
+    const ll_file_header_t *hdr;
+    const ll_file_entry_t *entries;
+    void *vals[LL_LOAD_BATCH];
+    ll_opts_t o = *opts;
+    struct stat st;
+    char *map;
+    ll_t *list;
+    uint64_t i;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        return NULL;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(ll_file_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    // private: the values can be written to, without changing the file
+    map = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                       0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    hdr = (const ll_file_header_t *)map;
+    entries = (const ll_file_entry_t *)(map + sizeof(ll_file_header_t));
+    if (memcmp(hdr->magic, LL_FILE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != LL_FILE_VERSION || hdr->byte_order != LL_FILE_BYTE_ORDER ||
+        hdr->count > (uint64_t)INT_MAX ||
+        hdr->arena_off < sizeof(ll_file_header_t) + hdr->count * sizeof(ll_file_entry_t) ||
+        hdr->arena_off > (uint64_t)st.st_size ||
+        hdr->arena_len > (uint64_t)st.st_size - hdr->arena_off)
+        goto invalid;
+    madvise(map, hdr->arena_off, MADV_WILLNEED); // read in full right away, unlike the arena
+    for (i = 0; i < hdr->count; i++)
+        if (entries[i].off % LL_FILE_ALIGN != 0 || entries[i].off > hdr->arena_len ||
+            entries[i].len > hdr->arena_len - entries[i].off)
+            goto invalid;
+    // a sorted list is only as good as its order, which the file may have been saved out of
+    for (i = 1; opts->order != NULL && i < hdr->count; i++)
+        if (opts->order(map + hdr->arena_off + entries[i - 1].off,
+                        map + hdr->arena_off + entries[i].off) > 0)
+            goto invalid;
+
+    if (o.storage == LL_STORAGE_NODES && o.pool_slab_nodes == 0 && hdr->count > 0)
+        o.pool_slab_nodes = hdr->count < LL_LOAD_SLAB_NODES ? hdr->count : LL_LOAD_SLAB_NODES;
+    errno = EINVAL; // options ll_new_ex() turns down, unless it runs out of memory
+    if ((list = ll_new_ex(&o)) == NULL) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    list->order = NULL; // set back last, sorted lists don't take values in bulk
+    for (i = 0; i < hdr->count; i += LL_LOAD_BATCH) {
+        uint64_t j, n = hdr->count - i < LL_LOAD_BATCH ? hdr->count - i : LL_LOAD_BATCH;
+        for (j = 0; j < n; j++)
+            vals[j] = map + hdr->arena_off + entries[i + j].off;
+        if (ll_insert_many(list, vals, n, -1) < 0) {
+            list->val_teardown = ll_no_teardown; // the values were never the caller's
+            ll_delete(list);
+            munmap(map, (size_t)st.st_size);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    list->order = opts->order;
+    list->map = map;
+    list->map_len = (size_t)st.st_size;
+
+    return list;
+
+invalid:
+    munmap(map, (size_t)st.st_size);
+    errno = EINVAL;
+    return NULL;
+}
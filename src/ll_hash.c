@@ -0,0 +1,307 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_hash.c implements the hash index declared in `ll_hash.h`: a chained hash table
+ * whose bucket array doubles whenever there are more entries than buckets. Entries come
+ * from a pool and remember the hash of their value, so growing never calls the user hash
+ * function again.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ll_hash.h"
+#include "ll_pool.h"
+
+/* macros */
+
+// initial number of buckets (log2)
+#define LL_HASH_MIN_BITS 4
+
+// number of entries allocated at once by the pool of a table
+#define LL_HASH_SLAB 256
+
+/* type definitions */
+
+typedef struct ll_hash_entry ll_hash_entry_t;
+
+// ll_hash_entry models an indexed item
+struct ll_hash_entry {
+    // next entry of the bucket
+    ll_hash_entry_t *nxt;
+
+    // the value, as passed to the hash function
+    void *val;
+
+    // the item holding it and the one before
+    void *item;
+    void *prev;
+
+    // what the hash function returned for `val`
+    size_t hash;
+};
+
+// ll_hash models the table
+struct ll_hash {
+    // `1 << bits` buckets
+    ll_hash_entry_t **buckets;
+    unsigned int bits;
+
+    // number of entries
+    size_t count;
+
+    // user supplied hashing and matching of values
+    hash_fun_t hash;
+    comp_fun_t comparator;
+
+    // where the entries come from
+    ll_pool_t *pool;
+};
+
+/* static functions */
+
+/**
+ * @function ll_hash_bucket
+ *
+ * Picks the bucket of a hash with a multiplicative (Fibonacci) hash, so that the top bits
+ * are used and user hashes that only vary in their high or low bits still spread.
+ */
+static size_t ll_hash_bucket(const ll_hash_t *table, size_t hash) {
+    return (size_t)(((uint64_t)hash * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - table->bits));
+}
+
+/**
+ * @function ll_hash_grow
+ *
+ * Doubles the number of buckets. Keeps the table as is if that can't be allocated: it
+ * only gets slower.
+ */
+static void ll_hash_grow(ll_hash_t *table) {
+    size_t old_n = (size_t)1 << table->bits;
+    ll_hash_entry_t **old = table->buckets;
+    ll_hash_entry_t **buckets = (ll_hash_entry_t **)calloc(old_n * 2, sizeof(*buckets));
+    size_t i;
+
+    if (buckets == NULL)
+        return;
+    table->buckets = buckets;
+    table->bits++;
+    for (i = 0; i < old_n; i++) {
+        ll_hash_entry_t *e = old[i];
+        while (e != NULL) {
+            ll_hash_entry_t *nxt = e->nxt;
+            size_t b = ll_hash_bucket(table, e->hash);
+            e->nxt = buckets[b];
+            buckets[b] = e;
+            e = nxt;
+        }
+    }
+    free(old);
+}
+
+/**
+ * @function ll_hash_entry_of
+ *
+ * Finds the link pointing to the entry of `item`.
+ *
+ * @returns the address of that link, `NULL` if `item` isn't in the table
+ */
+static ll_hash_entry_t **ll_hash_entry_of(const ll_hash_t *table, void *val, void *item) {
+    ll_hash_entry_t **link = &table->buckets[ll_hash_bucket(table, table->hash(val))];
+
+    while (*link != NULL && (*link)->item != item)
+        link = &(*link)->nxt;
+
+    return *link == NULL ? NULL : link;
+}
+
+/* interface */
+
+/**
+ * @function ll_hash_new
+ *
+ * Allocates an empty table.
+ *
+ * @param hash - hashes the values, equal values must have equal hashes
+ * @param comparator - returns 0 when both values are equal
+ *
+ * @returns a pointer to a new table, `NULL` if out of memory
+ */
+ll_hash_t *ll_hash_new(hash_fun_t hash, comp_fun_t comparator) {
+    ll_hash_t *table = (ll_hash_t *)malloc(sizeof(ll_hash_t));
+    if (table == NULL)
+        return NULL;
+
+    table->bits = LL_HASH_MIN_BITS;
+    table->buckets = (ll_hash_entry_t **)calloc((size_t)1 << table->bits,
+                                                sizeof(*table->buckets));
+    table->pool = ll_pool_new(sizeof(ll_hash_entry_t), _Alignof(ll_hash_entry_t),
+                              offsetof(ll_hash_entry_t, nxt), LL_HASH_SLAB, NULL, NULL,
+                              -1);
+    if (table->buckets == NULL || table->pool == NULL) {
+        if (table->pool != NULL)
+            ll_pool_delete(table->pool);
+        free(table->buckets);
+        free(table);
+        return NULL;
+    }
+    table->count = 0;
+    table->hash = hash;
+    table->comparator = comparator;
+
+    return table;
+}
+
+/**
+ * @function ll_hash_delete
+ *
+ * Releases the buckets, and all the entries at once through the pool.
+ *
+ * @param table - the table
+ */
+void ll_hash_delete(ll_hash_t *table) {
+    ll_pool_delete(table->pool);
+    free(table->buckets);
+    free(table);
+}
+
+/**
+ * @function ll_hash_comparator
+ *
+ * @param table - the table
+ *
+ * @returns the comparator the table matches values with
+ */
+comp_fun_t ll_hash_comparator(const ll_hash_t *table) {
+    return table->comparator;
+}
+
+/**
+ * @function ll_hash_fun
+ *
+ * @param table - the table
+ *
+ * @returns the function the table hashes values with
+ */
+hash_fun_t ll_hash_fun(const ll_hash_t *table) {
+    return table->hash;
+}
+
+/**
+ * @function ll_hash_insert
+ *
+ * Adds an entry for `item`, growing the table when it gets more entries than buckets.
+ *
+ * @param table - the table
+ * @param val - the value held by `item`
+ * @param item - the item
+ * @param prev - the item before `item`
+ *
+ * @returns 0 if successful, -1 if out of memory
+ */
+int ll_hash_insert(ll_hash_t *table, void *val, void *item, void *prev) {
+    ll_hash_entry_t *e = (ll_hash_entry_t *)ll_pool_get(table->pool);
+    size_t b;
+
+    if (e == NULL)
+        return -1;
+    if (table->count >= (size_t)1 << table->bits)
+        ll_hash_grow(table);
+    e->val = val;
+    e->item = item;
+    e->prev = prev;
+    e->hash = table->hash(val);
+    b = ll_hash_bucket(table, e->hash);
+    e->nxt = table->buckets[b];
+    table->buckets[b] = e;
+    table->count++;
+
+    return 0;
+}
+
+/**
+ * @function ll_hash_remove
+ *
+ * Removes the entry of `item`, if any.
+ *
+ * @param table - the table
+ * @param val - the value held by `item`
+ * @param item - the item
+ */
+void ll_hash_remove(ll_hash_t *table, void *val, void *item) {
+    ll_hash_entry_t **link = ll_hash_entry_of(table, val, item);
+    ll_hash_entry_t *e;
+
+    if (link == NULL)
+        return;
+    e = *link;
+    *link = e->nxt;
+    ll_pool_put(table->pool, e);
+    table->count--;
+}
+
+/**
+ * @function ll_hash_set_prev
+ *
+ * Updates the predecessor recorded for `item`.
+ *
+ * @param table - the table
+ * @param val - the value held by `item`
+ * @param item - the item
+ * @param prev - the item now before `item`
+ */
+void ll_hash_set_prev(ll_hash_t *table, void *val, void *item, void *prev) {
+    ll_hash_entry_t **link = ll_hash_entry_of(table, val, item);
+
+    if (link != NULL)
+        (*link)->prev = prev;
+}
+
+/**
+ * @function ll_hash_find
+ *
+ * Looks up the bucket of `ref`, comparing only the values whose hash is the same.
+ *
+ * @param table - the table
+ * @param ref - the value looked for
+ * @param prev - set to the item before the one found
+ *
+ * @returns the item holding a value equal to `ref`, `NULL` if there is none
+ */
+void *ll_hash_find(const ll_hash_t *table, const void *ref, void **prev) {
+    size_t hash = table->hash(ref);
+    ll_hash_entry_t *e = table->buckets[ll_hash_bucket(table, hash)];
+
+    for (; e != NULL; e = e->nxt) {
+        if (e->hash == hash && table->comparator(e->val, ref) == 0) {
+            *prev = e->prev;
+            return e->item;
+        }
+    }
+
+    return NULL;
+}
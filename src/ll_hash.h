@@ -0,0 +1,74 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_hash.h declares the hash index that `ll_set_index()` attaches to a list. It is
+ * internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_HASH_H
+#define LL_HASH_H
+
+#include <stddef.h>
+
+#include "ll.h"
+
+/* type definitions */
+
+// hash table from values to the items (nodes) holding them, and their predecessors
+typedef struct ll_hash ll_hash_t;
+
+/* function prototypes */
+
+// returns a new empty table hashing values with `hash` and matching them with
+// `comparator`, `NULL` if out of memory
+ll_hash_t *ll_hash_new(hash_fun_t hash, comp_fun_t comparator);
+
+// releases the table (not the values nor the items)
+void ll_hash_delete(ll_hash_t *table);
+
+// returns the comparator the table was created with
+comp_fun_t ll_hash_comparator(const ll_hash_t *table);
+
+// returns the hash function the table was created with
+hash_fun_t ll_hash_fun(const ll_hash_t *table);
+
+// records that `item` holds `val` and follows `prev`. returns 0 if successful, -1 if out
+// of memory
+int ll_hash_insert(ll_hash_t *table, void *val, void *item, void *prev);
+
+// forgets `item`, which holds `val`
+void ll_hash_remove(ll_hash_t *table, void *val, void *item);
+
+// records that `item`, which holds `val`, now follows `prev`
+void ll_hash_set_prev(ll_hash_t *table, void *val, void *item, void *prev);
+
+// returns an item whose value matches `ref` (setting `*prev` to its predecessor), `NULL`
+// if there is none
+void *ll_hash_find(const ll_hash_t *table, const void *ref, void **prev);
+
+// LL_HASH_H
+#endif
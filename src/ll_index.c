@@ -0,0 +1,275 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_index.c implements the positional index declared in `ll_index.h` as an
+ * implicit treap: a binary tree ordered by position, where every node knows the size of
+ * its subtree, balanced by random priorities. Looking up, inserting or removing at a
+ * position takes O(log n) expected time; a run of `k` items is added or removed in
+ * O(k + log n) by splitting and merging the tree.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "ll_index.h"
+#include "ll_pool.h"
+
+/* macros */
+
+// number of tree nodes allocated at once by the pool of an index
+#define LL_INDEX_SLAB 256
+
+// the link of a chained item
+#define ITEM_NXT(item, link_off) (*(void **)((char *)(item) + (link_off)))
+
+/* type definitions */
+
+typedef struct ll_index_node ll_index_node_t;
+
+// ll_index_node models a node of the treap
+struct ll_index_node {
+    // the subtrees: items before and after this one
+    ll_index_node_t *l;
+    ll_index_node_t *r;
+
+    // the indexed item
+    void *item;
+
+    // heap priority, every node has a lower priority than its parent
+    unsigned int prio;
+
+    // number of nodes in this subtree
+    int size;
+};
+
+// ll_index models the whole index
+struct ll_index {
+    // the root of the treap
+    ll_index_node_t *root;
+
+    // where the tree nodes come from
+    ll_pool_t *pool;
+
+    // state of the priority generator
+    unsigned int seed;
+};
+
+/* static functions */
+
+static int idx_size(const ll_index_node_t *t) {
+    return t == NULL ? 0 : t->size;
+}
+
+static void idx_update(ll_index_node_t *t) {
+    t->size = 1 + idx_size(t->l) + idx_size(t->r);
+}
+
+// xorshift32, plenty for balancing
+static unsigned int idx_rand(ll_index_t *index) {
+    unsigned int x = index->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    index->seed = x;
+    return x;
+}
+
+/**
+ * @function idx_split
+ *
+ * Splits `t` into its first `k` items (`*a`) and the rest (`*b`).
+ */
+static void idx_split(ll_index_node_t *t, int k, ll_index_node_t **a, ll_index_node_t **b) {
+    if (t == NULL) {
+        *a = *b = NULL;
+    } else if (idx_size(t->l) < k) {
+        idx_split(t->r, k - idx_size(t->l) - 1, &t->r, b);
+        idx_update(t);
+        *a = t;
+    } else {
+        idx_split(t->l, k, a, &t->l);
+        idx_update(t);
+        *b = t;
+    }
+}
+
+/**
+ * @function idx_merge
+ *
+ * Concatenates `a` and `b`, returning the new root.
+ */
+static ll_index_node_t *idx_merge(ll_index_node_t *a, ll_index_node_t *b) {
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+    if (a->prio > b->prio) {
+        a->r = idx_merge(a->r, b);
+        idx_update(a);
+        return a;
+    }
+    b->l = idx_merge(a, b->l);
+    idx_update(b);
+    return b;
+}
+
+/**
+ * @function idx_free
+ *
+ * Gives every node of `t` back to the pool.
+ */
+static void idx_free(ll_index_t *index, ll_index_node_t *t) {
+    if (t == NULL)
+        return;
+    idx_free(index, t->l);
+    idx_free(index, t->r);
+    ll_pool_put(index->pool, t);
+}
+
+/* interface */
+
+/**
+ * @function ll_index_new
+ *
+ * Allocates an empty index and the pool its tree nodes come from.
+ *
+ * @returns a pointer to a new index, `NULL` if out of memory
+ */
+ll_index_t *ll_index_new(void) {
+    ll_index_t *index = (ll_index_t *)malloc(sizeof(ll_index_t));
+    if (index == NULL)
+        return NULL;
+
+    index->pool = ll_pool_new(sizeof(ll_index_node_t), _Alignof(ll_index_node_t),
+                              offsetof(ll_index_node_t, l), LL_INDEX_SLAB, NULL, NULL,
+                              -1);
+    if (index->pool == NULL) {
+        free(index);
+        return NULL;
+    }
+    index->root = NULL;
+    index->seed = 2463534242u;
+
+    return index;
+}
+
+/**
+ * @function ll_index_delete
+ *
+ * Releases the index and all of its tree nodes at once, through its pool.
+ *
+ * @param index - the index
+ */
+void ll_index_delete(ll_index_t *index) {
+    ll_pool_delete(index->pool);
+    free(index);
+}
+
+/**
+ * @function ll_index_get
+ *
+ * Walks down from the root, using the subtree sizes to steer towards `pos`.
+ *
+ * @param index - the index
+ * @param pos - the position
+ *
+ * @returns the item at `pos`, `NULL` if `pos` is out of range
+ */
+void *ll_index_get(const ll_index_t *index, int pos) {
+    const ll_index_node_t *t = index->root;
+
+    while (t != NULL) {
+        int left = idx_size(t->l);
+        if (pos < left) {
+            t = t->l;
+        } else if (pos == left) {
+            return t->item;
+        } else {
+            pos -= left + 1;
+            t = t->r;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @function ll_index_insert
+ *
+ * Builds a treap of the new items, then splits the index at `pos` and merges the three
+ * parts back together.
+ *
+ * @param index - the index
+ * @param pos - the position of the first new item
+ * @param first - the first new item
+ * @param link_off - offset of the pointer to the next item in an item
+ * @param n - the number of new items
+ *
+ * @returns 0 if successful, -1 if out of memory
+ */
+int ll_index_insert(ll_index_t *index, int pos, void *first, size_t link_off, size_t n) {
+    ll_index_node_t *run = NULL;
+    ll_index_node_t *before, *after;
+    ll_index_node_t *t = (ll_index_node_t *)ll_pool_get_chain(index->pool, n);
+    size_t i;
+
+    if (t == NULL)
+        return -1;
+
+    for (i = 0; i < n; i++) {
+        ll_index_node_t *nxt = t->l; // the pool chained them through `l`
+        t->l = t->r = NULL;
+        t->item = first;
+        t->prio = idx_rand(index);
+        t->size = 1;
+        run = idx_merge(run, t);
+        first = ITEM_NXT(first, link_off);
+        t = nxt;
+    }
+
+    idx_split(index->root, pos, &before, &after);
+    index->root = idx_merge(idx_merge(before, run), after);
+
+    return 0;
+}
+
+/**
+ * @function ll_index_remove
+ *
+ * Splits the run of items out of the index and frees its tree nodes.
+ *
+ * @param index - the index
+ * @param pos - the position of the first removed item
+ * @param n - the number of removed items
+ */
+void ll_index_remove(ll_index_t *index, int pos, size_t n) {
+    ll_index_node_t *before, *run, *after;
+
+    idx_split(index->root, pos, &before, &after);
+    idx_split(after, (int)n, &run, &after);
+    idx_free(index, run);
+    index->root = idx_merge(before, after);
+}
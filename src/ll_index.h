@@ -0,0 +1,62 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_index.h declares the positional index that lists created with `pos_index` set
+ * (see `ll_new_ex()`) keep over their nodes. It is internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_INDEX_H
+#define LL_INDEX_H
+
+#include <stddef.h>
+
+/* type definitions */
+
+// order-statistic index of a sequence of items
+typedef struct ll_index ll_index_t;
+
+/* function prototypes */
+
+// returns a new empty index, `NULL` if out of memory
+ll_index_t *ll_index_new(void);
+
+// releases the index (not the items)
+void ll_index_delete(ll_index_t *index);
+
+// returns the item at position `pos`, `NULL` if there is none
+void *ll_index_get(const ll_index_t *index, int pos);
+
+// inserts the `n` items chained from `first` through the pointer stored `link_off` bytes
+// into each of them at position `pos`. returns 0 if successful, -1 if out of memory (the
+// index is unchanged then)
+int ll_index_insert(ll_index_t *index, int pos, void *first, size_t link_off, size_t n);
+
+// removes the `n` items starting at position `pos`
+void ll_index_remove(ll_index_t *index, int pos, size_t n);
+
+// LL_INDEX_H
+#endif
@@ -0,0 +1,236 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_internal.h contains what the translation units of the library share but the
+ * user never sees: the locking macros, and the storage engines behind `ll_t`.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_INTERNAL_H
+#define LL_INTERNAL_H
+
+#include "ll.h"
+#include "ll_stats.h"
+
+/* macros */
+
+// for locking and unlocking lists along with `locktype_t`, whatever their lock backend.
+// built with `LL_STATS`, the locks of `ll_t` lists are counted and timed (see `ll_stats()`)
+#ifdef LL_STATS
+#define RWLOCK(item, locktype) \
+    ll_counters_lock(LL_COUNTERS(item), &(item)->m, (locktype) == l_write)
+#define RWUNLOCK(item) do {                                          \
+        LL_UNLOCKING(item);                                             \
+        ll_counters_unlock(LL_COUNTERS(item), &(item)->m);              \
+    } while (0)
+#define RWTRYLOCK(item, locktype) \
+    ll_counters_trylock(LL_COUNTERS(item), &(item)->m, (locktype) == l_write)
+#else
+#define RWLOCK(item, locktype) ll_lock_acquire(&(item)->m, (locktype) == l_write)
+#define RWUNLOCK(item) do {                                          \
+        LL_UNLOCKING(item);                                             \
+        ll_lock_release(&(item)->m);                                    \
+    } while (0)
+#define RWTRYLOCK(item, locktype) ll_lock_try_acquire(&(item)->m, (locktype) == l_write)
+#endif
+
+// the counters of `item` if it is an `ll_t`, `NULL` for the lists of other modules
+#define LL_COUNTERS(item) \
+    _Generic((item), ll_t *: _ll_counters_of, default: _ll_no_counters)(item)
+
+// has `item`, about to be unlocked, post its readiness descriptor if it is an `ll_t` that a
+// try function found locked
+#define LL_UNLOCKING(item) \
+    _Generic((item), ll_t *: _ll_unlocking, default: _ll_no_unlocking)(item)
+
+// adds `n` to the `stat` counter of `list` (see `ll_stat_t`), when built with `LL_STATS`
+#ifdef LL_STATS
+#define STAT_ADD(list, stat, n) ll_counters_add((list)->stats, (stat), (unsigned long)(n))
+#else
+#define STAT_ADD(list, stat, n) ((void)(n))
+#endif
+
+// reading and updating `len`, which only changes under the write lock of the list but is
+// read by `ll_length()` without any lock: new lengths are published with release stores
+#define LEN(list) atomic_load_explicit(&(list)->len, memory_order_relaxed)
+#define LEN_SET(list, n) atomic_store_explicit(&(list)->len, (n), memory_order_release)
+#define LEN_ADD(list, n) LEN_SET(list, LEN(list) + (n))
+
+// shorthand for locking a list mutex and checking list's validity
+// locktype: is the locktype_t wanted by the function that checks the list
+// list:     the list to be checked
+// retval:   is the value to be returned by the function that uses the macro,
+//           when the check fails
+#define CHECK_VALID(list, locktype, retval) {                \
+                           valid_flag_t flag;                \
+                           RWLOCK(list, locktype);           \
+                           flag = list->valid_flag;          \
+                           if(flag != VALID) {RWUNLOCK(list);\
+                                              return retval;}\
+                   } while(0);
+
+// like `CHECK_VALID()`, but never waits for the lock: when another thread holds it, the
+// macro returns `retval` with `errno` set to `EAGAIN`, and the readiness descriptor of the
+// list (see `ll_event_fd()`) is made readable once that thread unlocks it
+#define TRY_CHECK_VALID(list, locktype, retval) {            \
+                           valid_flag_t flag;                \
+                           if (!RWTRYLOCK(list, locktype) && \
+                               !_ll_try_again(list, locktype)) {\
+                               errno = EAGAIN;               \
+                               return retval;                \
+                           }                                 \
+                           flag = list->valid_flag;          \
+                           if(flag != VALID) {RWUNLOCK(list);\
+                                              errno = EINVAL;\
+                                              return retval;}\
+                   } while(0);
+
+/* type definitions */
+
+typedef enum locktype locktype_t;
+
+// locktype enumerates the two typs of rw locks. This isused in the macros above for
+// simplifying all the locking/unlocking that goes on.
+enum locktype {
+    l_read,
+    l_write
+};
+
+/* function prototypes */
+
+// wakes up the threads sleeping in `ll_pop_first_wait()` after `n` values were inserted
+// (to be called once the list is unlocked)
+void _ll_wake_waiters(ll_t *list, int n);
+
+// wakes up the threads sleeping in `ll_insert_last_wait()` after `n` values were removed
+// (the list may still be locked)
+void _ll_wake_inserters(ll_t *list, int n);
+
+// makes the readiness descriptor of the list readable, if it has one
+void _ll_post_event(ll_t *list);
+
+// tears down a value removed from the list, or has the background thread of the list do
+// it (see `ll_opts_t.async_teardown`)
+void _ll_teardown(ll_t *list, void *val);
+
+/* inline functions */
+
+// see `LL_COUNTERS()`
+static inline ll_counters_t *_ll_counters_of(const void *list) {
+    return ((const ll_t *)list)->stats;
+}
+
+static inline ll_counters_t *_ll_no_counters(const void *list) {
+    (void)list;
+    return NULL;
+}
+
+// see `LL_UNLOCKING()`: called right before the lock of `list` is released, so that the
+// list is never touched once it may be deleted. `event_contended` is 1 when a try function
+// found the lock held since, and 2 once a holder saw it about to unlock. lists without a
+// readiness descriptor only pay a plain load (it's set with the list locked)
+static inline void _ll_unlocking(const void *item) {
+    ll_t *list = (ll_t *)item;
+
+    if (atomic_load_explicit(&list->event_fd, memory_order_relaxed) >= 0 &&
+        atomic_exchange(&list->event_contended, 2) == 1)
+        _ll_post_event(list);
+}
+
+static inline void _ll_no_unlocking(const void *item) {
+    (void)item;
+}
+
+// a try function found the lock of `list` held: has the holder post the readiness
+// descriptor as it unlocks, then tries the lock once more. a holder that already got past
+// `_ll_unlocking()` (the flag was 2) won't post it, so the descriptor is then posted here:
+// the caller comes back to a lock that is about to be free.
+// returns 1 if the lock was taken, 0 otherwise
+static inline int _ll_try_again(ll_t *list, locktype_t locktype) {
+    int seen = atomic_exchange(&list->event_contended, 1);
+
+    if (RWTRYLOCK(list, locktype))
+        return 1;
+    if (seen == 2)
+        _ll_post_event(list);
+    return 0;
+}
+
+/* the unrolled storage engine (`LL_STORAGE_UNROLLED`), see `ll_unrolled.c`.
+ * the list must be locked (for writing unless stated otherwise) and valid. */
+
+// sets up an empty unrolled list, with a pool of blocks if `pool_slab_blocks` isn't 0
+// (`list->key_of` set beforehand). returns 0 if successful, -1 otherwise
+int llu_init(ll_t *list, size_t pool_slab_blocks);
+
+// tears down all the values and frees all the blocks
+void llu_clear(ll_t *list);
+
+// inserts the `n` values of `vals` at position `pos` (-1 to append), either all of them
+// or none. returns 0 if successful, -1 if `pos` is out of range or out of memory
+int llu_insert(ll_t *list, int pos, void **vals, size_t n);
+
+// unlinks the value at position `pos`, storing it in `val`.
+// returns 0 if successful, -1 if `pos` is out of range
+int llu_remove(ll_t *list, int pos, void **val);
+
+// stores the value at position `pos` in `val` (read lock is enough).
+// returns 0 if successful, -1 if `pos` is out of range
+int llu_get(ll_t *list, int pos, void **val);
+
+// looks for the first value matching `comparator`/`ref_value` (see `ll_find()`), or `cond`
+// (see `ll_remove_search()`) when `comparator` is `NULL`, storing it in `val`, and unlinks
+// it if `remove` is set (read lock is enough otherwise).
+// returns the position of the value, -1 if none matched
+int llu_find(ll_t *list, comp_fun_t comparator, const void *ref_value, int cond(void *),
+             int remove, void **val);
+
+// looks for the first value of a keyed list whose key is `key`, storing it in `val` (read
+// lock is enough). returns the position of the value, -1 if none has that key
+int llu_find_key(ll_t *list, int64_t key, void **val);
+
+// unlinks up to `max` values from the front, storing them into `out`.
+// returns the number of values unlinked
+int llu_pop_many(ll_t *list, void **out, size_t max);
+
+// calls `f` on every value
+void llu_map(ll_t *list, gen_fun_t f);
+
+// calls `f` (unless `NULL`) on every value of the `n` blocks starting at `block` (read
+// lock is enough when `f` doesn't alter them). returns the block that follows
+ll_block_t *llu_map_blocks(ll_block_t *block, size_t n, gen_fun_t f);
+
+// moves the cursor of an `ll_iter_t` forward to the first value at or after index `*idx`
+// of `*block` (`*prev` preceding it), storing it in `val` (read lock is enough).
+// returns 1 if there is one, 0 at the end
+int llu_iter_next(ll_block_t **prev, ll_block_t **block, int *idx, void **val);
+
+// unlinks the value under the cursor, which is left on the value that followed it.
+// returns the value unlinked
+void *llu_iter_remove(ll_t *list, ll_block_t *prev, ll_block_t **block, int *idx);
+
+// LL_INTERNAL_H
+#endif
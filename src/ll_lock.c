@@ -0,0 +1,171 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_lock.c implements the slow paths of the locks declared in `ll_lock.h`. The
+ * ticket lock spins on the ticket being served, yielding the cpu now and then in case the
+ * holder got preempted. The futex mutex is the classic three state one: a locker that
+ * finds it taken spins a little, then marks it contended and sleeps in the kernel until
+ * an unlocker sees the mark and wakes one sleeper up.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "ll_lock.h"
+
+/* macros */
+
+// busy-waiting rounds before giving the cpu away (ticket) or going to sleep (futex)
+#define LL_LOCK_SPINS 128
+
+// tells the cpu we are busy-waiting
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+/* static functions */
+
+/**
+ * @function ll_futex
+ *
+ * Sleeps while the futex word is `val` (`wake == 0`), or wakes one sleeper up. Without
+ * futexes, sleeping is yielding the cpu.
+ */
+static void ll_futex(atomic_int *word, int wake, int val) {
+#ifdef __linux__
+    syscall(SYS_futex, (int *)word, wake ? FUTEX_WAKE_PRIVATE : FUTEX_WAIT_PRIVATE,
+            wake ? 1 : val, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)val;
+    if (!wake)
+        sched_yield();
+#endif
+}
+
+/* interface */
+
+/**
+ * @function ll_lock_init
+ *
+ * @param lock - the lock
+ * @param backend - which kind of lock it is
+ *
+ * @returns 0 if successful, -1 if `backend` is unknown
+ */
+int ll_lock_init(ll_lock_t *lock, ll_lock_backend_t backend) {
+    lock->backend = backend;
+    switch (backend) {
+    case LL_BACKEND_RWLOCK:
+        return pthread_rwlock_init(&lock->rw, NULL) ? -1 : 0;
+    case LL_BACKEND_TICKET:
+        atomic_init(&lock->ticket.next, 0);
+        atomic_init(&lock->ticket.serving, 0);
+        return 0;
+    case LL_BACKEND_FUTEX:
+        atomic_init(&lock->futex, 0);
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * @function ll_lock_destroy
+ *
+ * @param lock - the lock
+ */
+void ll_lock_destroy(ll_lock_t *lock) {
+    if (lock->backend == LL_BACKEND_RWLOCK)
+        pthread_rwlock_destroy(&lock->rw);
+}
+
+/**
+ * @function ll_lock_ticket_wait
+ *
+ * Waits for `ticket` to be served.
+ *
+ * @param lock - the lock
+ * @param ticket - the ticket of the caller
+ */
+void ll_lock_ticket_wait(ll_lock_t *lock, unsigned int ticket) {
+    int spins = 0;
+
+    while (atomic_load_explicit(&lock->ticket.serving, memory_order_acquire) != ticket) {
+        if (++spins < LL_LOCK_SPINS) {
+            CPU_RELAX();
+        } else {
+            spins = 0;
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @function ll_lock_futex_wait
+ *
+ * Takes a futex mutex found locked: spins on it for a while, then marks it contended
+ * (2) and sleeps until it is released. Once acquired that way it stays marked, so that
+ * its release wakes up whoever else is sleeping.
+ *
+ * @param lock - the lock
+ */
+void ll_lock_futex_wait(ll_lock_t *lock) {
+    int spins;
+    int c;
+
+    for (spins = 0; spins < LL_LOCK_SPINS; spins++) {
+        c = 0;
+        if (atomic_load_explicit(&lock->futex, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_weak_explicit(&lock->futex, &c, 1, memory_order_acquire,
+                                                  memory_order_relaxed))
+            return;
+        CPU_RELAX();
+    }
+    while (atomic_exchange_explicit(&lock->futex, 2, memory_order_acquire) != 0)
+        ll_futex(&lock->futex, 0, 2);
+}
+
+/**
+ * @function ll_lock_futex_wake
+ *
+ * Finishes releasing a futex mutex that was contended, waking a sleeper up.
+ *
+ * @param lock - the lock
+ */
+void ll_lock_futex_wake(ll_lock_t *lock) {
+    atomic_store_explicit(&lock->futex, 0, memory_order_release);
+    ll_futex(&lock->futex, 1, 0);
+}
@@ -0,0 +1,216 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_numa.c implements the NUMA helpers of `ll_numa.h` with plain system calls
+ * (`getcpu`, `mbind`) and the topology the kernel exposes in sysfs. Elsewhere than on
+ * Linux the machine is a single node.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "ll_numa.h"
+
+/* macros */
+
+// calls of `ll_numa_node()` between two questions to the kernel, per thread
+#define LL_NUMA_REFRESH 256
+
+// most nodes `ll_numa_bind()` knows of (the kernel default for large machines)
+#define LL_NUMA_MAX_NODES 1024
+
+// the `mbind()` policy preferring a node, from `<numaif.h>` (which comes with libnuma)
+#define LL_MPOL_PREFERRED 1
+
+// bits of a word of a node mask
+#define LL_MASK_BITS (8 * sizeof(unsigned long))
+
+/* globals */
+
+// the online nodes in increasing order, and their number (read once)
+static int ll_node_ids[LL_NUMA_MAX_NODES];
+static int ll_nnodes;
+static pthread_once_t ll_nodes_once = PTHREAD_ONCE_INIT;
+
+// node of the calling thread, -1 until first asked, and calls of `ll_numa_node()` since
+static _Thread_local int ll_node_id = -1;
+static _Thread_local unsigned ll_node_calls;
+
+/* static functions */
+
+/**
+ * @function ll_numa_read_nodes
+ *
+ * Reads the online nodes from sysfs. Possible nodes would also count those that can be
+ * hot-added but have no memory or cpus yet, which lists can't be put on. Node 0 alone
+ * stands for a machine that doesn't say.
+ */
+static void ll_numa_read_nodes(void) {
+    char buf[4096];
+
+    FILE *f = fopen("/sys/devices/system/node/online", "r");
+    if (f != NULL) {
+        if (fgets(buf, sizeof(buf), f) != NULL)
+            ll_nnodes = ll_numa_parse(buf, ll_node_ids, LL_NUMA_MAX_NODES);
+        fclose(f);
+    }
+    if (ll_nnodes == 0) {
+        ll_node_ids[0] = 0;
+        ll_nnodes = 1;
+    }
+}
+
+/* functions */
+
+/**
+ * @function ll_numa_parse
+ *
+ * Parses a node list of sysfs, ranges separated by commas (such as "0,2-3"), ids past
+ * `max` or out of order aside.
+ *
+ * @param list - the node list
+ * @param ids - where the ids go, in increasing order
+ * @param max - the room in `ids`, and the first id left out
+ *
+ * @returns the number of ids stored
+ */
+int ll_numa_parse(const char *list, int *ids, int max) {
+    const char *p = list;
+    char *end;
+    long id;
+    int n = 0;
+
+    while (*p >= '0' && *p <= '9') {
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (id = first; id <= last && id < max; id++)
+            if (n == 0 || id > ids[n - 1])
+                ids[n++] = (int)id;
+        if (*end != ',')
+            break;
+        p = end + 1;
+    }
+
+    return n;
+}
+
+/**
+ * @function ll_numa_nodes
+ *
+ * @returns the number of online nodes, at least 1
+ */
+int ll_numa_nodes(void) {
+    pthread_once(&ll_nodes_once, ll_numa_read_nodes);
+
+    return ll_nnodes;
+}
+
+/**
+ * @function ll_numa_node_at
+ *
+ * @param i - the position of the node, from 0 to `ll_numa_nodes() - 1`
+ *
+ * @returns the id of the `i`th online node, -1 if out of range
+ */
+int ll_numa_node_at(int i) {
+    if (i < 0 || i >= ll_numa_nodes())
+        return -1;
+
+    return ll_node_ids[i];
+}
+
+/**
+ * @function ll_numa_index
+ *
+ * @param node - the id of a node
+ *
+ * @returns the position of `node` among the online nodes, -1 if it isn't one
+ */
+int ll_numa_index(int node) {
+    int i, n = ll_numa_nodes();
+
+    for (i = 0; i < n && ll_node_ids[i] <= node; i++)
+        if (ll_node_ids[i] == node)
+            return i;
+
+    return -1;
+}
+
+/**
+ * @function ll_numa_node
+ *
+ * @returns the node of the calling thread, as the kernel last told it
+ */
+int ll_numa_node(void) {
+    if (ll_node_id < 0 || ++ll_node_calls % LL_NUMA_REFRESH == 0) {
+        unsigned cpu = 0;
+        unsigned node = 0;
+#if defined(__linux__) && defined(SYS_getcpu)
+        if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+            node = 0;
+#endif
+        (void)cpu;
+        ll_node_id = node < LL_NUMA_MAX_NODES ? (int)node : 0;
+    }
+
+    return ll_node_id;
+}
+
+/**
+ * @function ll_numa_bind
+ *
+ * Sets a preferred policy for node `node` on the range, which only decides where its pages
+ * go as they are faulted in.
+ *
+ * @param mem - the start of the range, page aligned
+ * @param len - the length of the range
+ * @param node - the node
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int ll_numa_bind(void *mem, size_t len, int node) {
+    if (node < 0 || node >= LL_NUMA_MAX_NODES)
+        return -1;
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[LL_NUMA_MAX_NODES / LL_MASK_BITS] = {0};
+    mask[node / LL_MASK_BITS] = 1UL << (node % LL_MASK_BITS);
+
+    // the kernel reads `maxnode - 1` bits of the mask
+    return syscall(SYS_mbind, mem, len, LL_MPOL_PREFERRED, mask,
+                   (unsigned long)LL_NUMA_MAX_NODES + 1, 0) == 0 ? 0 : -1;
+#else
+    (void)mem, (void)len;
+    return -1;
+#endif
+}
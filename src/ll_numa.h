@@ -0,0 +1,65 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_numa.h declares what the library knows of the NUMA topology: how many nodes
+ * there are, which one a thread runs on, and placing memory on one. It talks to the
+ * kernel directly rather than through libnuma, and is internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_NUMA_H
+#define LL_NUMA_H
+
+#include <stddef.h>
+
+/* function prototypes */
+
+// returns the number of online NUMA nodes of the machine (1 when it isn't NUMA, or the
+// kernel doesn't say), read once. their ids needn't follow each other ("0,2")
+int ll_numa_nodes(void);
+
+// returns the id of the `i`th online node, in increasing order, -1 if `i` is out of range
+int ll_numa_node_at(int i);
+
+// returns the position of node `node` among the online ones, -1 if it isn't online
+int ll_numa_index(int node);
+
+// parses a sysfs node list such as "0,2-3" into its node ids (in increasing order, below
+// `max`, at most `max` of them).
+// returns the number of ids
+int ll_numa_parse(const char *list, int *ids, int max);
+
+// returns the NUMA node of the cpu the calling thread runs on (0 if unknown). it is asked
+// to the kernel once every few calls only: threads seldom move between nodes
+int ll_numa_node(void);
+
+// has the pages of the `len` bytes at `mem` (page aligned, not touched yet) allocated on
+// `node` when they are first touched, falling back to other nodes when it is full.
+// returns 0 if successful, -1 otherwise (the pages then go wherever they would have)
+int ll_numa_bind(void *mem, size_t len, int node);
+
+// LL_NUMA_H
+#endif
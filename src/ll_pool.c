@@ -0,0 +1,377 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_pool.c implements the slab allocator declared in `ll_pool.h`. Elements are
+ * carved out of slabs and recycled through a free list, so once a pool has warmed up
+ * allocating and freeing a node is a couple of pointer writes under the pool mutex: no
+ * `malloc`, `free`, nor lock initialization.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include "ll_numa.h"
+#include "ll_pool.h"
+
+/* macros */
+
+// the free list link stored inside a free element
+#define LINK(pool, elem) (*(void **)((char *)(elem) + (pool)->link_off))
+
+/* type definitions */
+
+struct ll_slab;
+
+// ll_slab is a chunk of elements, they are chained to be released with the pool
+struct ll_slab {
+    // the next slab
+    struct ll_slab *nxt;
+};
+
+// ll_pool models a slab allocator
+struct ll_pool {
+    // size of an element, rounded up to `align`
+    size_t stride;
+
+    // alignment of the elements
+    size_t align;
+
+    // offset of the free list link in an element
+    size_t link_off;
+
+    // number of elements in a slab
+    size_t per_slab;
+
+    // initializer and finalizer of the elements
+    ll_pool_fun_t init;
+    ll_pool_fun_t fini;
+
+    // the NUMA node the slabs are placed on, -1 for wherever `malloc()` puts them. placed
+    // slabs are mapped on their own, `slab_len` bytes each
+    int node;
+    size_t slab_len;
+
+    // all the slabs of the pool
+    struct ll_slab *slabs;
+
+    // first free element
+    void *free_hd;
+
+    // bookkeeping, reported by `ll_pool_get_stats()`
+    size_t nslabs;
+    size_t nfree;
+    unsigned long gets;
+    unsigned long puts;
+
+    // number of owners, the last one to delete the pool releases it
+    size_t refs;
+
+    // protects everything above
+    pthread_mutex_t m;
+};
+
+/**
+ * @function ll_pool_slab_offset
+ *
+ * Elements start after the slab header, on a multiple of the elements alignment.
+ *
+ * @param pool - the pool
+ *
+ * @returns the offset of the first element of a slab
+ */
+static size_t ll_pool_slab_offset(ll_pool_t *pool) {
+    return (sizeof(struct ll_slab) + pool->align - 1) / pool->align * pool->align;
+}
+
+/**
+ * @function ll_pool_grow
+ *
+ * Allocates a new slab, initializes its elements and pushes them on the free list. The
+ * pool must be locked.
+ *
+ * @param pool - the pool
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+static int ll_pool_grow(ll_pool_t *pool) {
+    void *mem;
+    size_t off = ll_pool_slab_offset(pool);
+    size_t i;
+
+    if (pool->node >= 0) {
+        // fresh pages, untouched until the elements are initialized below: the first
+        // touch faults them in on the node
+        mem = mmap(NULL, pool->slab_len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            return -1;
+        ll_numa_bind(mem, pool->slab_len, pool->node);
+    } else if (posix_memalign(&mem, pool->align, off + pool->per_slab * pool->stride)) {
+        return -1;
+    }
+
+    struct ll_slab *slab = (struct ll_slab *)mem;
+    slab->nxt = pool->slabs;
+    pool->slabs = slab;
+    pool->nslabs++;
+
+    // pushed backwards so elements come out in address order
+    for (i = pool->per_slab; i > 0; i--) {
+        void *elem = (char *)mem + off + (i - 1) * pool->stride;
+        if (pool->init != NULL)
+            pool->init(elem);
+        LINK(pool, elem) = pool->free_hd;
+        pool->free_hd = elem;
+    }
+    pool->nfree += pool->per_slab;
+
+    return 0;
+}
+
+/**
+ * @function ll_pool_new
+ *
+ * Allocates a pool and its first slab.
+ *
+ * @param elem_size - size of an element
+ * @param align - alignment of an element (a power of two)
+ * @param link_off - where the free list link is stored in free elements
+ * @param per_slab - number of elements per slab
+ * @param init - called on each element when its slab is allocated, may be `NULL`
+ * @param fini - called on each element when the pool is deleted, may be `NULL`
+ * @param node - the NUMA node to place the slabs on, -1 for none in particular
+ *
+ * @returns a pointer to the new pool, `NULL` on failure
+ */
+ll_pool_t *ll_pool_new(size_t elem_size, size_t align, size_t link_off, size_t per_slab,
+                       ll_pool_fun_t init, ll_pool_fun_t fini, int node) {
+    if (per_slab == 0 || link_off + sizeof(void *) > elem_size)
+        return NULL;
+    if (align < sizeof(void *))
+        align = sizeof(void *);
+
+    ll_pool_t *pool = (ll_pool_t *)malloc(sizeof(ll_pool_t));
+    if (pool == NULL)
+        return NULL;
+
+    pool->stride = (elem_size + align - 1) / align * align;
+    pool->align = align;
+    pool->link_off = link_off;
+    pool->per_slab = per_slab;
+    pool->init = init;
+    pool->fini = fini;
+    pool->node = node;
+    if (node >= 0) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t len = ll_pool_slab_offset(pool) + per_slab * pool->stride;
+        pool->slab_len = (len + page - 1) / page * page;
+    }
+    pool->slabs = NULL;
+    pool->free_hd = NULL;
+    pool->nslabs = 0;
+    pool->nfree = 0;
+    pool->gets = 0;
+    pool->puts = 0;
+    pool->refs = 1;
+    pthread_mutex_init(&pool->m, NULL);
+
+    if (ll_pool_grow(pool)) {
+        pthread_mutex_destroy(&pool->m);
+        free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+/**
+ * @function ll_pool_delete
+ *
+ * Drops an owner of the pool. The last one finalizes every element and frees all the
+ * slabs, then the pool itself: elements still in use are released as well, so nobody may
+ * hold one anymore.
+ *
+ * @param pool - the pool
+ */
+void ll_pool_delete(ll_pool_t *pool) {
+    size_t off = ll_pool_slab_offset(pool);
+    size_t refs;
+    size_t i;
+
+    pthread_mutex_lock(&pool->m);
+    refs = --pool->refs;
+    pthread_mutex_unlock(&pool->m);
+    if (refs > 0)
+        return;
+
+    while (pool->slabs != NULL) {
+        struct ll_slab *slab = pool->slabs;
+        pool->slabs = slab->nxt;
+        if (pool->fini != NULL) {
+            for (i = 0; i < pool->per_slab; i++)
+                pool->fini((char *)slab + off + i * pool->stride);
+        }
+        if (pool->node >= 0)
+            munmap(slab, pool->slab_len);
+        else
+            free(slab);
+    }
+    pthread_mutex_destroy(&pool->m);
+    free(pool);
+}
+
+/**
+ * @function ll_pool_ref
+ *
+ * Adds an owner to the pool, for lists whose nodes move between each other.
+ *
+ * @param pool - the pool
+ *
+ * @returns `pool`
+ */
+ll_pool_t *ll_pool_ref(ll_pool_t *pool) {
+    pthread_mutex_lock(&pool->m);
+    pool->refs++;
+    pthread_mutex_unlock(&pool->m);
+
+    return pool;
+}
+
+/**
+ * @function ll_pool_get
+ *
+ * Pops an element off the free list, allocating a new slab when it is empty.
+ *
+ * @param pool - the pool
+ *
+ * @returns a pointer to the element, `NULL` if the pool can't grow
+ */
+void *ll_pool_get(ll_pool_t *pool) {
+    void *elem = NULL;
+
+    pthread_mutex_lock(&pool->m);
+    if (pool->free_hd != NULL || ll_pool_grow(pool) == 0) {
+        elem = pool->free_hd;
+        pool->free_hd = LINK(pool, elem);
+        pool->nfree--;
+        pool->gets++;
+    }
+    pthread_mutex_unlock(&pool->m);
+
+    return elem;
+}
+
+/**
+ * @function ll_pool_put
+ *
+ * Pushes an element back on the free list.
+ *
+ * @param pool - the pool
+ * @param elem - an element that was returned by `ll_pool_get()`
+ */
+void ll_pool_put(ll_pool_t *pool, void *elem) {
+    pthread_mutex_lock(&pool->m);
+    LINK(pool, elem) = pool->free_hd;
+    pool->free_hd = elem;
+    pool->nfree++;
+    pool->puts++;
+    pthread_mutex_unlock(&pool->m);
+}
+
+/**
+ * @function ll_pool_get_chain
+ *
+ * Takes `n` elements off the free list at once, under a single lock of the pool. Their
+ * links chain them together, which lets callers use them as a pre-linked list.
+ *
+ * @param pool - the pool
+ * @param n - the number of elements, at least 1
+ *
+ * @returns the first element of the chain, `NULL` if the pool can't grow enough
+ */
+void *ll_pool_get_chain(ll_pool_t *pool, size_t n) {
+    void *first = NULL;
+    size_t i;
+
+    pthread_mutex_lock(&pool->m);
+    while (pool->nfree < n) {
+        if (ll_pool_grow(pool))
+            goto out;
+    }
+    first = pool->free_hd;
+    void *last = first;
+    for (i = 1; i < n; i++)
+        last = LINK(pool, last);
+    pool->free_hd = LINK(pool, last);
+    LINK(pool, last) = NULL;
+    pool->nfree -= n;
+    pool->gets += n;
+out:
+    pthread_mutex_unlock(&pool->m);
+
+    return first;
+}
+
+/**
+ * @function ll_pool_put_chain
+ *
+ * Pushes a chain of elements back on the free list in constant time.
+ *
+ * @param pool - the pool
+ * @param first - the first element of the chain
+ * @param last - the last element of the chain
+ * @param n - the number of elements in the chain
+ */
+void ll_pool_put_chain(ll_pool_t *pool, void *first, void *last, size_t n) {
+    pthread_mutex_lock(&pool->m);
+    LINK(pool, last) = pool->free_hd;
+    pool->free_hd = first;
+    pool->nfree += n;
+    pool->puts += n;
+    pthread_mutex_unlock(&pool->m);
+}
+
+/**
+ * @function ll_pool_get_stats
+ *
+ * Takes a consistent snapshot of the pool counters.
+ *
+ * @param pool - the pool
+ * @param stats - filled with the counters
+ */
+void ll_pool_get_stats(ll_pool_t *pool, ll_pool_stats_t *stats) {
+    pthread_mutex_lock(&pool->m);
+    stats->slabs = pool->nslabs;
+    stats->capacity = pool->nslabs * pool->per_slab;
+    stats->free = pool->nfree;
+    stats->in_use = stats->capacity - pool->nfree;
+    stats->gets = pool->gets;
+    stats->puts = pool->puts;
+    pthread_mutex_unlock(&pool->m);
+}
@@ -0,0 +1,83 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_pool.h declares the slab allocator that lists created with a node pool (see
+ * `ll_new_ex()`) draw their nodes from. It is internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_POOL_H
+#define LL_POOL_H
+
+#include <stddef.h>
+
+#include "ll.h"
+
+/* type definitions */
+
+// slab allocator of fixed size elements
+typedef struct ll_pool ll_pool_t;
+
+// called on every element when its slab is allocated (`init`) or released (`fini`)
+typedef void (*ll_pool_fun_t)(void *);
+
+/* function prototypes */
+
+// returns a new pool of `elem_size` bytes elements aligned on `align`, allocated
+// `per_slab` at a time. the free list is threaded through the pointer stored `link_off`
+// bytes into each free element, which is the only part of it the pool ever writes.
+// `init` and `fini` may be `NULL`. slabs are placed on NUMA node `node` unless it is -1
+// (each is then mapped on its own, see `ll_numa_bind()`).
+// returns `NULL` if the first slab can't be allocated
+ll_pool_t *ll_pool_new(size_t elem_size, size_t align, size_t link_off, size_t per_slab,
+                       ll_pool_fun_t init, ll_pool_fun_t fini, int node);
+
+// calls `fini` on every element and releases all the slabs, once every owner of the pool
+// (see `ll_pool_ref()`) called it
+void ll_pool_delete(ll_pool_t *pool);
+
+// shares the pool with one more owner, which calls `ll_pool_delete()` when done with it.
+// returns `pool`
+ll_pool_t *ll_pool_ref(ll_pool_t *pool);
+
+// returns a free element, growing the pool by a slab if needed. `NULL` if out of memory
+void *ll_pool_get(ll_pool_t *pool);
+
+// gives an element back to the free list (it stays initialized)
+void ll_pool_put(ll_pool_t *pool, void *elem);
+
+// returns `n` free elements chained through their links (the last link being `NULL`),
+// growing the pool as needed. `NULL` if out of memory (nothing is taken then)
+void *ll_pool_get_chain(ll_pool_t *pool, size_t n);
+
+// gives back `n` elements chained through their links, from `first` to `last`
+void ll_pool_put_chain(ll_pool_t *pool, void *first, void *last, size_t n);
+
+// fills `stats` with the current state of the pool
+void ll_pool_get_stats(ll_pool_t *pool, ll_pool_stats_t *stats);
+
+// LL_POOL_H
+#endif
@@ -0,0 +1,276 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_stats.c implements the instrumentation counters of the lists (see
+ * `ll_stats.h`). Every counter is striped: threads add to the stripe they were given the
+ * first time they counted something, each stripe having its own cache line, so that
+ * counting doesn't make the threads of a list fight over the same line. Reading the
+ * counters sums the stripes up.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "ll_numa.h"
+#include "ll_stats.h"
+
+/* macros */
+
+// number of stripes of each counter, threads beyond that share them
+#define LL_STATS_STRIPES 16
+
+// size of a cache line
+#define LL_CACHE_LINE 64
+
+/* type definitions */
+
+// ll_stripe is the share of the counters of a few threads
+struct ll_stripe {
+    _Alignas(LL_CACHE_LINE) atomic_ulong c[LL_STAT_COUNT];
+};
+
+// ll_counters models the counters of a list
+struct ll_counters {
+    struct ll_stripe stripes[LL_STATS_STRIPES];
+
+    // the NUMA node of the list, locks taken from other ones count as remote
+    int node;
+
+    // when the lock was last taken exclusively, 0 if it isn't held so. only the holder of
+    // the lock touches it
+    unsigned long held_since;
+};
+
+/* globals */
+
+// stripe of the calling thread, -1 until it first counts something
+static _Thread_local int ll_stripe_id = -1;
+
+// the next stripe handed out
+static atomic_uint ll_next_stripe;
+
+/* functions */
+
+/**
+ * @function ll_now_ns
+ *
+ * @returns the time on `CLOCK_MONOTONIC`, in nanoseconds
+ */
+static unsigned long ll_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+}
+
+/**
+ * @function ll_stripe
+ *
+ * Hands out the stripes round robin, so that the threads of a process spread evenly.
+ *
+ * @returns the stripe of the calling thread
+ */
+static int ll_stripe(void) {
+    if (ll_stripe_id < 0)
+        ll_stripe_id = (int)(atomic_fetch_add_explicit(&ll_next_stripe, 1,
+                                                       memory_order_relaxed) %
+                             LL_STATS_STRIPES);
+
+    return ll_stripe_id;
+}
+
+/**
+ * @function ll_counters_new
+ *
+ * Allocates counters, all zero.
+ *
+ * @param node - the NUMA node of the list
+ *
+ * @returns the counters, `NULL` on failure
+ */
+ll_counters_t *ll_counters_new(int node) {
+    ll_counters_t *counters;
+    int i, j;
+
+    if (posix_memalign((void **)&counters, LL_CACHE_LINE, sizeof(ll_counters_t)))
+        return NULL;
+    for (i = 0; i < LL_STATS_STRIPES; i++) {
+        for (j = 0; j < LL_STAT_COUNT; j++)
+            atomic_init(&counters->stripes[i].c[j], 0);
+    }
+    counters->node = node;
+    counters->held_since = 0;
+
+    return counters;
+}
+
+/**
+ * @function ll_counters_delete
+ *
+ * @param counters - the counters
+ */
+void ll_counters_delete(ll_counters_t *counters) {
+    free(counters);
+}
+
+/**
+ * @function ll_counters_add
+ *
+ * Adds to the stripe of the calling thread, with a relaxed atomic: other threads seldom
+ * touch it.
+ *
+ * @param counters - the counters, `NULL` to count nothing
+ * @param stat - the counter
+ * @param n - the amount
+ */
+void ll_counters_add(ll_counters_t *counters, ll_stat_t stat, unsigned long n) {
+    if (counters == NULL)
+        return;
+    atomic_fetch_add_explicit(&counters->stripes[ll_stripe()].c[stat], n,
+                              memory_order_relaxed);
+}
+
+/**
+ * @function ll_counters_read
+ *
+ * Sums the stripes up. Threads keep counting meanwhile, so the counters of the snapshot
+ * may be a few operations apart.
+ *
+ * @param counters - the counters
+ * @param stats - filled with the sums
+ */
+void ll_counters_read(ll_counters_t *counters, ll_stats_t *stats) {
+    unsigned long sums[LL_STAT_COUNT] = {0};
+    int i, j;
+
+    for (i = 0; i < LL_STATS_STRIPES; i++) {
+        for (j = 0; j < LL_STAT_COUNT; j++)
+            sums[j] += atomic_load_explicit(&counters->stripes[i].c[j],
+                                            memory_order_relaxed);
+    }
+    stats->inserts = sums[LL_STAT_INSERTS];
+    stats->removes = sums[LL_STAT_REMOVES];
+    stats->lookups = sums[LL_STAT_LOOKUPS];
+    stats->maps = sums[LL_STAT_MAPS];
+    stats->read_locks = sums[LL_STAT_READ_LOCKS];
+    stats->write_locks = sums[LL_STAT_WRITE_LOCKS];
+    stats->lock_wait_ns = sums[LL_STAT_LOCK_WAIT_NS];
+    stats->lock_hold_ns = sums[LL_STAT_LOCK_HOLD_NS];
+    stats->walks = sums[LL_STAT_WALKS];
+    stats->walk_steps = sums[LL_STAT_WALK_STEPS];
+    stats->allocs = sums[LL_STAT_ALLOCS];
+    stats->frees = sums[LL_STAT_FREES];
+    stats->remote_locks = sums[LL_STAT_REMOTE_LOCKS];
+}
+
+/**
+ * @function ll_counters_reset
+ *
+ * Zeroes every stripe. What threads count meanwhile may or may not survive.
+ *
+ * @param counters - the counters
+ */
+void ll_counters_reset(ll_counters_t *counters) {
+    int i, j;
+
+    for (i = 0; i < LL_STATS_STRIPES; i++) {
+        for (j = 0; j < LL_STAT_COUNT; j++)
+            atomic_store_explicit(&counters->stripes[i].c[j], 0, memory_order_relaxed);
+    }
+}
+
+/**
+ * @function ll_counters_lock
+ *
+ * Takes the lock, timing the wait. Exclusive holds (write ones, and all of them with the
+ * backends that don't share the lock) start being timed too: shared holds overlap, and
+ * aren't. Acquisitions from another NUMA node than the list's are counted apart.
+ *
+ * @param counters - the counters, `NULL` to count nothing
+ * @param lock - the lock
+ * @param write - whether to take the lock for writing
+ */
+void ll_counters_lock(ll_counters_t *counters, ll_lock_t *lock, int write) {
+    if (counters == NULL) {
+        ll_lock_acquire(lock, write);
+        return;
+    }
+
+    unsigned long t0 = ll_now_ns();
+    ll_lock_acquire(lock, write);
+    unsigned long t1 = ll_now_ns();
+    ll_counters_add(counters, write ? LL_STAT_WRITE_LOCKS : LL_STAT_READ_LOCKS, 1);
+    ll_counters_add(counters, LL_STAT_LOCK_WAIT_NS, t1 - t0);
+    if (ll_numa_node() != counters->node)
+        ll_counters_add(counters, LL_STAT_REMOTE_LOCKS, 1);
+    if (write || lock->backend != LL_BACKEND_RWLOCK)
+        counters->held_since = t1;
+}
+
+/**
+ * @function ll_counters_trylock
+ *
+ * Takes the lock if that doesn't mean waiting for it, counting the acquisition like
+ * `ll_counters_lock()` does (with no time spent waiting).
+ *
+ * @param counters - the counters, `NULL` to count nothing
+ * @param lock - the lock
+ * @param write - whether to take the lock for writing
+ *
+ * @returns 1 if the lock was taken, 0 if another thread holds it
+ */
+int ll_counters_trylock(ll_counters_t *counters, ll_lock_t *lock, int write) {
+    if (!ll_lock_try_acquire(lock, write))
+        return 0;
+    if (counters == NULL)
+        return 1;
+
+    ll_counters_add(counters, write ? LL_STAT_WRITE_LOCKS : LL_STAT_READ_LOCKS, 1);
+    if (ll_numa_node() != counters->node)
+        ll_counters_add(counters, LL_STAT_REMOTE_LOCKS, 1);
+    if (write || lock->backend != LL_BACKEND_RWLOCK)
+        counters->held_since = ll_now_ns();
+
+    return 1;
+}
+
+/**
+ * @function ll_counters_unlock
+ *
+ * Releases the lock, adding up how long it was held if that was exclusively.
+ *
+ * @param counters - the counters, `NULL` to count nothing
+ * @param lock - the lock
+ */
+void ll_counters_unlock(ll_counters_t *counters, ll_lock_t *lock) {
+    if (counters != NULL && counters->held_since != 0) {
+        ll_counters_add(counters, LL_STAT_LOCK_HOLD_NS, ll_now_ns() - counters->held_since);
+        counters->held_since = 0;
+    }
+    ll_lock_release(lock);
+}
@@ -0,0 +1,90 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_stats.h declares the instrumentation counters of lists built with `LL_STATS`
+ * (see `ll_stats()`): operation counts, lock wait and hold times, walk lengths and
+ * allocations. It is internal to the library.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LL_STATS_H
+#define LL_STATS_H
+
+#include "ll.h"
+#include "ll_lock.h"
+
+/* type definitions */
+
+// the counters, in the order of the fields of `ll_stats_t`
+typedef enum {
+    LL_STAT_INSERTS,
+    LL_STAT_REMOVES,
+    LL_STAT_LOOKUPS,
+    LL_STAT_MAPS,
+    LL_STAT_READ_LOCKS,
+    LL_STAT_WRITE_LOCKS,
+    LL_STAT_LOCK_WAIT_NS,
+    LL_STAT_LOCK_HOLD_NS,
+    LL_STAT_WALKS,
+    LL_STAT_WALK_STEPS,
+    LL_STAT_ALLOCS,
+    LL_STAT_FREES,
+    LL_STAT_REMOTE_LOCKS,
+    LL_STAT_COUNT
+} ll_stat_t;
+
+// the counters of a list
+typedef struct ll_counters ll_counters_t;
+
+/* function prototypes */
+
+// returns zeroed counters of a list on NUMA node `node`, `NULL` if out of memory
+ll_counters_t *ll_counters_new(int node);
+
+// releases counters
+void ll_counters_delete(ll_counters_t *counters);
+
+// adds `n` to a counter of `counters` (unless `NULL`)
+void ll_counters_add(ll_counters_t *counters, ll_stat_t stat, unsigned long n);
+
+// sums the counters up into `stats`
+void ll_counters_read(ll_counters_t *counters, ll_stats_t *stats);
+
+// zeroes the counters
+void ll_counters_reset(ll_counters_t *counters);
+
+// `ll_lock_acquire()` and `ll_lock_release()`, counting the acquisition, the time spent
+// waiting for it and, when it is exclusive, the time the lock is held (`counters` may be
+// `NULL`)
+void ll_counters_lock(ll_counters_t *counters, ll_lock_t *lock, int write);
+void ll_counters_unlock(ll_counters_t *counters, ll_lock_t *lock);
+
+// `ll_lock_try_acquire()`, counting a successful acquisition like `ll_counters_lock()`
+// (with no time spent waiting). returns 1 if the lock was taken, 0 if it is held
+int ll_counters_trylock(ll_counters_t *counters, ll_lock_t *lock, int write);
+
+// LL_STATS_H
+#endif
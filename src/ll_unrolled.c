@@ -0,0 +1,716 @@
+/**
+ * Thread-safe linked-list data-structure for C.
+ *
+ * @file ll_unrolled.c implements the unrolled storage engine of `ll_t`
+ * (`LL_STORAGE_UNROLLED`): values are stored `LL_BLOCK_VALS` at a time in cache line
+ * aligned blocks, so walking a list is mostly a linear scan of memory and costs a pointer
+ * hop every `LL_BLOCK_VALS` values rather than every value. Blocks are split when an
+ * insertion hits a full one, and merged with their successor when removals leave them
+ * less than half full.
+ *
+ * The functions here expect the list to be locked and valid, `ll.c` takes care of that.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "ll_internal.h"
+#include "ll_pool.h"
+
+/* macros */
+
+// blocks are aligned on cache lines
+#define LL_BLOCK_ALIGN 64
+
+// keys of a block of a keyed list (see `ll_opts_t.key_of`): the slots past `LL_BLOCK_VALS`
+// are padding, so that a block is scanned in whole vectors
+#define LL_BLOCK_KEYS 16
+
+// size of the blocks of `list`, keys included
+#define BLOCK_SIZE(list)                                                                   \
+    (sizeof(ll_block_t) + ((list)->key_of != NULL ? LL_BLOCK_KEYS * sizeof(int64_t) : 0))
+
+/* type definitions */
+
+// ll_block models a block of values. with 14 values it is exactly two cache lines
+struct ll_block {
+    // pointer to the next block
+    ll_block_t *nxt;
+
+    // number of values in use, at the front of `vals`
+    int count;
+
+    // the values
+    void *vals[LL_BLOCK_VALS];
+
+    // the keys of the values, in keyed lists only (two more cache lines, 32 byte aligned)
+    int64_t keys[];
+};
+
+/**
+ * @function llu_new_block
+ *
+ * Makes a new empty block, taken from the pool of the list if it has one.
+ *
+ * @param list - the linked list the block is meant for
+ *
+ * @returns a pointer to the new block, `NULL` if out of memory
+ */
+static ll_block_t *llu_new_block(ll_t *list) {
+    ll_block_t *block;
+
+    if (list->pool != NULL)
+        block = (ll_block_t *)ll_pool_get(list->pool);
+    else
+        block = (ll_block_t *)aligned_alloc(LL_BLOCK_ALIGN, BLOCK_SIZE(list));
+    if (block == NULL)
+        return NULL;
+    block->nxt = NULL;
+    block->count = 0;
+    STAT_ADD(list, LL_STAT_ALLOCS, 1);
+
+    return block;
+}
+
+/**
+ * @function llu_free_block
+ *
+ * Releases a block made by `llu_new_block()`.
+ *
+ * @param list - the linked list the block belonged to
+ * @param block - the block
+ */
+static void llu_free_block(ll_t *list, ll_block_t *block) {
+    STAT_ADD(list, LL_STAT_FREES, 1);
+    if (list->pool != NULL)
+        ll_pool_put(list->pool, block);
+    else
+        free(block);
+}
+
+/**
+ * @function llu_move
+ *
+ * Moves `n` values (with their keys, in keyed lists) from index `si` of `src` to index
+ * `di` of `dst`, which may overlap.
+ *
+ * @param list - the linked list
+ * @param dst - the block moved to
+ * @param di - the index moved to
+ * @param src - the block moved from
+ * @param si - the index moved from
+ * @param n - the number of values
+ */
+static void llu_move(ll_t *list, ll_block_t *dst, int di, ll_block_t *src, int si, int n) {
+    memmove(&dst->vals[di], &src->vals[si], n * sizeof(void *));
+    if (list->key_of != NULL)
+        memmove(&dst->keys[di], &src->keys[si], n * sizeof(int64_t));
+}
+
+/**
+ * @function llu_link_after
+ *
+ * Links `block` after `prev` (or at the front of the list when `prev` is `NULL`),
+ * keeping `bhd` and `btl` consistent.
+ *
+ * @param list - the linked list
+ * @param prev - the block after which `block` is linked, `NULL` for the head
+ * @param block - the block to link
+ */
+static void llu_link_after(ll_t *list, ll_block_t *prev, ll_block_t *block) {
+    if (prev == NULL) {
+        block->nxt = list->bhd;
+        list->bhd = block;
+    } else {
+        block->nxt = prev->nxt;
+        prev->nxt = block;
+    }
+    if (block->nxt == NULL)
+        list->btl = block;
+}
+
+/**
+ * @function llu_unlink_after
+ *
+ * Unlinks and frees `block`, which directly follows `prev` (or is the head when `prev` is
+ * `NULL`).
+ *
+ * @param list - the linked list
+ * @param prev - the block preceding `block`, `NULL` if `block` is the head
+ * @param block - the block to unlink
+ */
+static void llu_unlink_after(ll_t *list, ll_block_t *prev, ll_block_t *block) {
+    if (prev == NULL)
+        list->bhd = block->nxt;
+    else
+        prev->nxt = block->nxt;
+    if (list->btl == block)
+        list->btl = prev;
+    llu_free_block(list, block);
+}
+
+/**
+ * @function llu_locate
+ *
+ * Finds the block holding position `pos`. Position `list->len` is located right after the
+ * last value of the last block, so that it can be appended to.
+ *
+ * @param list - the linked list
+ * @param pos - the position, from 0 to `list->len`
+ * @param prev - set to the block preceding the returned one (`NULL` for the head)
+ * @param idx - set to the index of `pos` in the returned block
+ *
+ * @returns the block, `NULL` if the list has none
+ */
+static ll_block_t *llu_locate(ll_t *list, int pos, ll_block_t **prev, int *idx) {
+    ll_block_t *block = list->bhd;
+
+    *prev = NULL;
+    if (pos == LEN(list) && list->btl != NULL) { // no need to walk there
+        // the predecessor of the tail is left unknown: blocks are never empty, so `*idx`
+        // isn't 0 and `llu_insert_at()` won't need it
+        block = list->btl;
+        *idx = block->count;
+        return block;
+    }
+
+    while (block != NULL && pos >= block->count) {
+        pos -= block->count;
+        *prev = block;
+        block = block->nxt;
+    }
+    *idx = pos;
+
+    return block;
+}
+
+/**
+ * @function llu_insert_at
+ *
+ * Inserts a value at index `*idx` of `*block`, making room as needed: a new block is
+ * linked before or after a full block when inserting at one of its ends, a full block is
+ * split in two otherwise. On return, `*block` and `*idx` tell where the value ended up.
+ *
+ * @param list - the linked list
+ * @param prev - the block preceding `*block` (only needed when inserting at the front of a
+ * full block)
+ * @param block - the block to insert into, `NULL` if the list is empty
+ * @param idx - the index to insert at, from 0 to `(*block)->count`
+ * @param val - the value
+ *
+ * @returns 0 if successful, -1 if out of memory (nothing changed then)
+ */
+static int llu_insert_at(ll_t *list, ll_block_t *prev, ll_block_t **block, int *idx,
+                         void *val) {
+    ll_block_t *b = *block;
+    int i = *idx;
+
+    if (b == NULL) { // empty list
+        b = llu_new_block(list);
+        if (b == NULL)
+            return -1;
+        llu_link_after(list, NULL, b);
+        i = 0;
+    } else if (b->count == LL_BLOCK_VALS) {
+        ll_block_t *nb = llu_new_block(list);
+        if (nb == NULL)
+            return -1;
+        if (i == LL_BLOCK_VALS) {    // after a full block
+            llu_link_after(list, b, nb);
+            b = nb;
+            i = 0;
+        } else if (i == 0) {         // before a full block
+            llu_link_after(list, prev, nb);
+            b = nb;
+        } else {                     // in the middle of a full block
+            int half = LL_BLOCK_VALS / 2;
+            llu_move(list, nb, 0, b, half, LL_BLOCK_VALS - half);
+            nb->count = LL_BLOCK_VALS - half;
+            b->count = half;
+            llu_link_after(list, b, nb);
+            if (i > half) {
+                b = nb;
+                i -= half;
+            }
+        }
+    }
+
+    llu_move(list, b, i + 1, b, i, b->count - i);
+    b->vals[i] = val;
+    if (list->key_of != NULL)
+        b->keys[i] = list->key_of(val);
+    b->count++;
+    LEN_ADD(list, 1);
+    STAT_ADD(list, LL_STAT_INSERTS, 1);
+    *block = b;
+    *idx = i;
+
+    return 0;
+}
+
+/**
+ * @function llu_remove_at
+ *
+ * Removes the value at index `idx` of `block`. An emptied block is freed, a block left
+ * less than half full is merged with its successor if they fit in one.
+ *
+ * @param list - the linked list
+ * @param prev - the block preceding `block`, `NULL` if `block` is the head
+ * @param block - the block
+ * @param idx - the index of the value in `block`
+ *
+ * @returns the removed value
+ */
+static void *llu_remove_at(ll_t *list, ll_block_t *prev, ll_block_t *block, int idx) {
+    void *val = block->vals[idx];
+
+    block->count--;
+    llu_move(list, block, idx, block, idx + 1, block->count - idx);
+    LEN_ADD(list, -1);
+    STAT_ADD(list, LL_STAT_REMOVES, 1);
+    _ll_wake_inserters(list, 1);
+
+    if (block->count == 0) {
+        llu_unlink_after(list, prev, block);
+    } else if (block->count < LL_BLOCK_VALS / 2 && block->nxt != NULL &&
+               block->count + block->nxt->count <= LL_BLOCK_VALS) {
+        ll_block_t *next = block->nxt;
+        llu_move(list, block, block->count, next, 0, next->count);
+        block->count += next->count;
+        llu_unlink_after(list, block, next);
+    }
+
+    return val;
+}
+
+/**
+ * @function llu_init
+ *
+ * Sets up an empty unrolled list. `list->key_of` must be set already, the size of the
+ * blocks depends on it.
+ *
+ * @param list - the linked list
+ * @param pool_slab_blocks - when not 0, blocks come from a pool allocating that many at once
+ *
+ * @returns 0 if successful, -1 if the pool can't be allocated
+ */
+int llu_init(ll_t *list, size_t pool_slab_blocks) {
+    list->bhd = NULL;
+    list->btl = NULL;
+    atomic_init(&list->len, 0);
+    list->pool = NULL;
+    if (pool_slab_blocks > 0) {
+        list->pool = ll_pool_new(BLOCK_SIZE(list), LL_BLOCK_ALIGN,
+                                 offsetof(ll_block_t, nxt), pool_slab_blocks, NULL, NULL,
+                                 list->numa_node);
+        if (list->pool == NULL)
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @function llu_clear
+ *
+ * Tears down every value and frees every block.
+ *
+ * @param list - the linked list
+ */
+void llu_clear(ll_t *list) {
+    ll_block_t *block = list->bhd;
+    int i;
+
+    while (block != NULL) {
+        ll_block_t *next = block->nxt;
+        for (i = 0; i < block->count; i++)
+            _ll_teardown(list, block->vals[i]);
+        llu_free_block(list, block);
+        block = next;
+    }
+    list->bhd = NULL;
+    list->btl = NULL;
+    LEN_SET(list, 0);
+}
+
+/**
+ * @function llu_insert
+ *
+ * Inserts values one after the other, starting at `pos`. Should memory run out midway,
+ * the values already inserted are removed.
+ *
+ * @param list - the linked list
+ * @param pos - the position of the first value, -1 to append
+ * @param vals - the values
+ * @param n - the number of values
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int llu_insert(ll_t *list, int pos, void **vals, size_t n) {
+    ll_block_t *prev;
+    ll_block_t *block;
+    int idx;
+    size_t i;
+
+    if (pos == -1)
+        pos = LEN(list);
+    if (pos < 0 || pos > LEN(list))
+        return -1;
+
+    block = llu_locate(list, pos, &prev, &idx);
+    for (i = 0; i < n; i++) {
+        if (llu_insert_at(list, prev, &block, &idx, vals[i])) {
+            while (i-- > 0) {
+                block = llu_locate(list, pos, &prev, &idx);
+                llu_remove_at(list, prev, block, idx);
+            }
+            return -1;
+        }
+        idx++; // the next value goes right after, in the same block (moot prev then)
+    }
+
+    return 0;
+}
+
+/**
+ * @function llu_remove
+ *
+ * @param list - the linked list
+ * @param pos - the position of the value to remove
+ * @param val - set to the removed value
+ *
+ * @returns 0 if successful, -1 if `pos` is out of range
+ */
+int llu_remove(ll_t *list, int pos, void **val) {
+    ll_block_t *prev;
+    ll_block_t *block;
+    int idx;
+
+    if (pos < 0 || pos >= LEN(list))
+        return -1;
+    block = llu_locate(list, pos, &prev, &idx);
+    *val = llu_remove_at(list, prev, block, idx);
+
+    return 0;
+}
+
+/**
+ * @function llu_get
+ *
+ * @param list - the linked list
+ * @param pos - the position of the value
+ * @param val - set to the value
+ *
+ * @returns 0 if successful, -1 if `pos` is out of range
+ */
+int llu_get(ll_t *list, int pos, void **val) {
+    ll_block_t *prev;
+    ll_block_t *block;
+    int idx;
+
+    if (pos < 0 || pos >= LEN(list))
+        return -1;
+    block = llu_locate(list, pos, &prev, &idx);
+    *val = block->vals[idx];
+
+    return 0;
+}
+
+/**
+ * @function llu_find
+ *
+ * Scans the blocks for the first value that matches.
+ *
+ * @param list - the linked list
+ * @param comparator - see `ll_find()`, `NULL` to use `cond` instead
+ * @param ref_value - reference value passed to the comparator
+ * @param cond - see `ll_remove_search()`
+ * @param remove - whether the value found is to be removed
+ * @param val - set to the value found
+ *
+ * @returns the position of the value found, -1 if none
+ */
+int llu_find(ll_t *list, comp_fun_t comparator, const void *ref_value, int cond(void *),
+             int remove, void **val) {
+    ll_block_t *prev = NULL;
+    ll_block_t *block;
+    int pos = 0;
+    int i;
+
+    for (block = list->bhd; block != NULL; prev = block, block = block->nxt) {
+        for (i = 0; i < block->count; i++) {
+            int match = comparator != NULL ? comparator(block->vals[i], ref_value) == 0
+                                           : cond(block->vals[i]);
+            if (match) {
+                *val = remove ? llu_remove_at(list, prev, block, i) : block->vals[i];
+                return pos + i;
+            }
+        }
+        pos += block->count;
+    }
+
+    return -1;
+}
+
+/**
+ * @function llu_match_keys
+ *
+ * Compares the `LL_BLOCK_KEYS` keys of a block with `key`, one at a time. The vector
+ * versions below do the same 2 (SSE2, NEON) or 4 (AVX2) keys per instruction.
+ *
+ * @param keys - the keys of the block
+ * @param key - the key looked for
+ *
+ * @returns a mask whose bit `i` is set when `keys[i]` is `key`
+ */
+static unsigned llu_match_keys(const int64_t *keys, int64_t key) {
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < LL_BLOCK_KEYS; i++)
+        mask |= (unsigned)(keys[i] == key) << i;
+
+    return mask;
+}
+
+#if defined(__SSE2__)
+static unsigned llu_match_keys_sse2(const int64_t *keys, int64_t key) {
+    __m128i k = _mm_set1_epi64x(key);
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < LL_BLOCK_KEYS; i += 2) {
+        // SSE2 only compares 32 bit lanes: a key matches when both its halves do
+        __m128i eq = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)&keys[i]), k);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        mask |= (unsigned)_mm_movemask_pd(_mm_castsi128_pd(eq)) << i;
+    }
+
+    return mask;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// built whatever the flags, picked at run time by `llu_find_key()` on CPUs that have it
+__attribute__((target("avx2")))
+static unsigned llu_match_keys_avx2(const int64_t *keys, int64_t key) {
+    __m256i k = _mm256_set1_epi64x(key);
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < LL_BLOCK_KEYS; i += 4) {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_load_si256((const __m256i *)&keys[i]), k);
+        mask |= (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(eq)) << i;
+    }
+
+    return mask;
+}
+#define LL_HAVE_AVX2
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+static unsigned llu_match_keys_neon(const int64_t *keys, int64_t key) {
+    int64x2_t k = vdupq_n_s64(key);
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < LL_BLOCK_KEYS; i += 2) {
+        uint64x2_t eq = vceqq_s64(vld1q_s64(&keys[i]), k);
+        mask |= (unsigned)(vgetq_lane_u64(eq, 0) & 1) << i;
+        mask |= (unsigned)(vgetq_lane_u64(eq, 1) & 1) << (i + 1);
+    }
+
+    return mask;
+}
+#endif
+
+/**
+ * @function llu_find_key
+ *
+ * Scans the keys of the blocks for the first value whose key is `key`, with the widest
+ * vector instructions available.
+ *
+ * @param list - the linked list, keyed
+ * @param key - the key looked for
+ * @param val - set to the value found
+ *
+ * @returns the position of the value found, -1 if none
+ */
+int llu_find_key(ll_t *list, int64_t key, void **val) {
+    unsigned (*match)(const int64_t *, int64_t) = llu_match_keys;
+    ll_block_t *block;
+    int pos = 0;
+
+#if defined(__SSE2__)
+    match = llu_match_keys_sse2;
+#ifdef LL_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        match = llu_match_keys_avx2;
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    match = llu_match_keys_neon;
+#endif
+
+    for (block = list->bhd; block != NULL; block = block->nxt) {
+        // the keys past `count` are stale (or were never set), they don't count
+        unsigned mask = match(block->keys, key) & ((1u << block->count) - 1);
+        if (mask != 0) {
+            int i = __builtin_ctz(mask);
+            *val = block->vals[i];
+            return pos + i;
+        }
+        pos += block->count;
+    }
+
+    return -1;
+}
+
+/**
+ * @function llu_pop_many
+ *
+ * @param list - the linked list
+ * @param out - filled with the values unlinked from the front of the list
+ * @param max - the maximum number of values to unlink
+ *
+ * @returns the number of values unlinked
+ */
+int llu_pop_many(ll_t *list, void **out, size_t max) {
+    size_t n = 0;
+
+    while (n < max && list->bhd != NULL) {
+        ll_block_t *block = list->bhd;
+        size_t take = (size_t)block->count;
+        if (take > max - n)
+            take = max - n;
+        memcpy(&out[n], block->vals, take * sizeof(void *));
+        n += take;
+        LEN_ADD(list, -(int)take);
+        STAT_ADD(list, LL_STAT_REMOVES, take);
+        block->count -= (int)take;
+        if (block->count == 0)
+            llu_unlink_after(list, NULL, block);
+        else
+            llu_move(list, block, 0, block, (int)take, block->count);
+    }
+    if (n > 0)
+        _ll_wake_inserters(list, (int)n);
+
+    return (int)n;
+}
+
+/**
+ * @function llu_map
+ *
+ * @param list - the linked list
+ * @param f - called on every value, in order
+ */
+void llu_map(ll_t *list, gen_fun_t f) {
+    ll_block_t *block;
+    int i;
+
+    for (block = list->bhd; block != NULL; block = block->nxt) {
+        for (i = 0; i < block->count; i++)
+            f(block->vals[i]);
+    }
+}
+
+/**
+ * @function llu_map_blocks
+ *
+ * @param block - the first block
+ * @param n - the number of blocks
+ * @param f - called on every value of those blocks, in order. `NULL` to only skip them
+ *
+ * @returns the block following them, `NULL` at the end of the list
+ */
+ll_block_t *llu_map_blocks(ll_block_t *block, size_t n, gen_fun_t f) {
+    int i;
+
+    for (; block != NULL && n > 0; n--, block = block->nxt) {
+        if (f == NULL)
+            continue;
+        for (i = 0; i < block->count; i++)
+            f(block->vals[i]);
+    }
+
+    return block;
+}
+
+/**
+ * @function llu_iter_next
+ *
+ * Settles a cursor on a value: skips to the following blocks while `*idx` is past the
+ * values of `*block`.
+ *
+ * @param prev - the block preceding `*block`, updated as the cursor moves
+ * @param block - the block of the cursor, `NULL` past the end
+ * @param idx - the index of the cursor in `*block`
+ * @param val - set to the value under the cursor
+ *
+ * @returns 1 if the cursor is on a value, 0 if it is past the end
+ */
+int llu_iter_next(ll_block_t **prev, ll_block_t **block, int *idx, void **val) {
+    while (*block != NULL && *idx >= (*block)->count) {
+        *prev = *block;
+        *block = (*block)->nxt;
+        *idx = 0;
+    }
+    if (*block == NULL)
+        return 0;
+    *val = (*block)->vals[*idx];
+
+    return 1;
+}
+
+/**
+ * @function llu_iter_remove
+ *
+ * Unlinks the value under a cursor, leaving the cursor on the value that followed it (or
+ * past the values of `*block`, see `llu_iter_next()`).
+ *
+ * @param list - the linked list
+ * @param prev - the block preceding `*block`
+ * @param block - the block of the cursor
+ * @param idx - the index of the cursor in `*block`
+ *
+ * @returns the value unlinked
+ */
+void *llu_iter_remove(ll_t *list, ll_block_t *prev, ll_block_t **block, int *idx) {
+    int freed = (*block)->count == 1;
+    void *val = llu_remove_at(list, prev, *block, *idx);
+
+    if (freed) {
+        *block = prev == NULL ? list->bhd : prev->nxt;
+        *idx = 0;
+    }
+
+    return val;
+}
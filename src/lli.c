@@ -0,0 +1,608 @@
+/**
+ * Intrusive linked-list for C.
+ *
+ * See `../README.md` and `main()` in this file for usage.
+ *
+ * @file lli.c implements the list outlined in `lli.h`. It is circular and doubly linked
+ * through a sentinel link in `lli_t`, so the ends need no special case, positions are
+ * walked to from the closest end and a struct is unlinked in constant time. Locking and
+ * validity follow `ll_t` in `LL_LOCK_LIST` mode: the list lock covers everything (links
+ * are the caller's, they can't embed a lock of ours), and `len` is read without locking.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "lli.h"
+#include "ll_internal.h"
+
+/* type definitions */
+
+// lli models the intrusive list
+struct lli {
+    // running length, read without locking by `lli_length()`
+    atomic_int len;
+
+    // the sentinel: `head.nxt` is the first link and `head.prv` the last, both pointing
+    // back to `head` when the list is empty
+    lli_link_t head;
+
+    // lock for thread safety
+    ll_lock_t m;
+
+    // called with the links of the structs removed
+    gen_fun_t link_teardown;
+
+    // a flag that says if the list is valid
+    valid_flag_t valid_flag;
+};
+
+/* static functions */
+
+/**
+ * @function lli_link_before
+ *
+ * Links `link` right before `at`. The list must be write locked.
+ *
+ * @param list - the list
+ * @param at - the link that ends up following `link` (`&list->head` to append)
+ * @param link - the link to insert
+ */
+static void lli_link_before(lli_t *list, lli_link_t *at, lli_link_t *link) {
+    link->nxt = at;
+    link->prv = at->prv;
+    at->prv->nxt = link;
+    at->prv = link;
+    LEN_ADD(list, 1);
+}
+
+/**
+ * @function lli_unlink_locked
+ *
+ * Unlinks `link`, leaving it with `NULL` pointers so that it can be inserted again. The
+ * list must be write locked.
+ *
+ * @param list - the list
+ * @param link - a link of the list
+ */
+static void lli_unlink_locked(lli_t *list, lli_link_t *link) {
+    link->prv->nxt = link->nxt;
+    link->nxt->prv = link->prv;
+    link->nxt = NULL;
+    link->prv = NULL;
+    LEN_ADD(list, -1);
+}
+
+/**
+ * @function lli_at
+ *
+ * Walks to position `n` from the closest end. The list must be locked.
+ *
+ * @param list - the list
+ * @param n - the position, from 0 to the length of the list
+ *
+ * @returns the link at position `n`, `&list->head` for `n` equal to the length, `NULL`
+ * when out of range
+ */
+static lli_link_t *lli_at(lli_t *list, int n) {
+    lli_link_t *link = &list->head;
+    int len = LEN(list);
+
+    if (n < 0 || n > len)
+        return NULL;
+    if (n <= len / 2) {
+        for (link = link->nxt; n > 0; n--)
+            link = link->nxt;
+    } else {
+        for (; n < len; n++)
+            link = link->prv;
+    }
+
+    return link;
+}
+
+/**
+ * @function lli_search
+ *
+ * The list must be locked.
+ *
+ * @param list - the list
+ * @param comparator - see `ll_find()`
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns the first link that `comparator` matches to `ref_value`, `NULL` if none
+ */
+static lli_link_t *lli_search(lli_t *list, comp_fun_t comparator, const void *ref_value) {
+    lli_link_t *link;
+
+    for (link = list->head.nxt; link != &list->head; link = link->nxt) {
+        if (comparator(link, ref_value) == 0)
+            return link;
+    }
+
+    return NULL;
+}
+
+/* interface */
+
+/**
+ * @function lli_new
+ *
+ * Allocates an empty intrusive list.
+ *
+ * @param link_teardown - called with the links of the structs removed from the list
+ * @param lock_backend - the kind of lock of the list, see `ll_opts_t`
+ *
+ * @returns a pointer to the new list, `NULL` on failure
+ */
+lli_t *lli_new(gen_fun_t link_teardown, ll_lock_backend_t lock_backend) {
+    if (lock_backend != LL_BACKEND_RWLOCK && lock_backend != LL_BACKEND_TICKET &&
+        lock_backend != LL_BACKEND_FUTEX)
+        return NULL;
+
+    lli_t *list = (lli_t *)malloc(sizeof(lli_t));
+    if (list == NULL)
+        return NULL;
+
+    atomic_init(&list->len, 0);
+    list->head.nxt = &list->head;
+    list->head.prv = &list->head;
+    ll_lock_init(&list->m, lock_backend);
+    list->link_teardown = link_teardown;
+    list->valid_flag = VALID;
+
+    return list;
+}
+
+/**
+ * @function lli_clear
+ *
+ * Unlinks and tears down all the structs, then invalidates the list.
+ *
+ * @param list - the list
+ */
+void lli_clear(lli_t *list) {
+    CHECK_VALID(list, l_write, );
+    while (list->head.nxt != &list->head) {
+        lli_link_t *link = list->head.nxt;
+        lli_unlink_locked(list, link);
+        list->link_teardown(link);
+    }
+    list->valid_flag = INVALID;
+    LEN_SET(list, -1); // what `lli_length()` reports for invalid lists
+    RWUNLOCK(list);
+    ll_lock_destroy(&list->m);
+}
+
+/**
+ * @function lli_delete
+ *
+ * Calls `lli_clear()` if need be, then frees the list itself.
+ *
+ * @param list - the list
+ */
+void lli_delete(lli_t *list) {
+    if (list->valid_flag != INVALID)
+        lli_clear(list);
+
+    free(list);
+}
+
+/**
+ * @function lli_length
+ *
+ * Lock-free, like `ll_length()`.
+ *
+ * @param list - the list
+ *
+ * @returns the number of structs in the list, -1 if it is invalid
+ */
+int lli_length(lli_t *list) {
+    return atomic_load_explicit(&list->len, memory_order_acquire);
+}
+
+/**
+ * @function lli_insert_n
+ *
+ * Links a struct at position `n`, unless its link already is in a list.
+ *
+ * @param list - the list
+ * @param link - the link of the struct
+ * @param n - the position
+ *
+ * @returns the new length of the list on success, -1 otherwise
+ */
+int lli_insert_n(lli_t *list, lli_link_t *link, int n) {
+    lli_link_t *at;
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    at = lli_at(list, n);
+    if (at == NULL || link->nxt != NULL) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    lli_link_before(list, at, link);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function lli_insert_first
+ *
+ * Wrapper for `lli_insert_n`.
+ *
+ * @param list - the list
+ * @param link - the link of the struct
+ *
+ * @returns the new length of the list on success, -1 otherwise
+ */
+int lli_insert_first(lli_t *list, lli_link_t *link) {
+    return lli_insert_n(list, link, 0);
+}
+
+/**
+ * @function lli_insert_last
+ *
+ * Links a struct at the end of the list, before the sentinel.
+ *
+ * @param list - the list
+ * @param link - the link of the struct
+ *
+ * @returns the new length of the list on success, -1 otherwise
+ */
+int lli_insert_last(lli_t *list, lli_link_t *link) {
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    if (link->nxt != NULL) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    lli_link_before(list, &list->head, link);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function lli_unlink
+ *
+ * Unlinks a struct through its own pointers, without searching for it.
+ *
+ * @param list - the list `link` is in
+ * @param link - the link of the struct
+ *
+ * @returns the new length of the list on success, -1 otherwise (`link` not in a list)
+ */
+int lli_unlink(lli_t *list, lli_link_t *link) {
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    if (link->nxt == NULL) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    lli_unlink_locked(list, link);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function lli_remove_n
+ *
+ * Unlinks the struct at position `n` and tears it down.
+ *
+ * @param list - the list
+ * @param n - the position
+ *
+ * @returns the new length of the list on success, -1 otherwise
+ */
+int lli_remove_n(lli_t *list, int n) {
+    lli_link_t *link;
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    link = lli_at(list, n);
+    if (link == NULL || link == &list->head) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    lli_unlink_locked(list, link);
+    list->link_teardown(link);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function lli_remove_find
+ *
+ * Unlinks the first struct matching `ref_value` and tears it down.
+ *
+ * @param list - the list
+ * @param comparator - see `ll_find()`
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns the new length of the list on success, -1 otherwise
+ */
+int lli_remove_find(lli_t *list, comp_fun_t comparator, const void *ref_value) {
+    lli_link_t *link;
+    int new_len;
+
+    CHECK_VALID(list, l_write, -1);
+    link = lli_search(list, comparator, ref_value);
+    if (link == NULL) {
+        RWUNLOCK(list);
+        return -1;
+    }
+    lli_unlink_locked(list, link);
+    list->link_teardown(link);
+    new_len = LEN(list);
+    RWUNLOCK(list);
+
+    return new_len;
+}
+
+/**
+ * @function lli_get_n
+ *
+ * @param list - the list
+ * @param n - the position
+ *
+ * @returns the link of the struct at position `n`, `NULL` if there is none
+ */
+lli_link_t *lli_get_n(lli_t *list, int n) {
+    lli_link_t *link;
+
+    CHECK_VALID(list, l_read, NULL);
+    link = lli_at(list, n);
+    if (link == &list->head)
+        link = NULL;
+    RWUNLOCK(list);
+
+    return link;
+}
+
+/**
+ * @function lli_pop_first
+ *
+ * Unlinks the first struct and hands it back to the caller.
+ *
+ * @param list - the list
+ *
+ * @returns the link of the struct, `NULL` if the list is empty or invalid
+ */
+lli_link_t *lli_pop_first(lli_t *list) {
+    lli_link_t *link = NULL;
+
+    CHECK_VALID(list, l_write, NULL);
+    if (list->head.nxt != &list->head) {
+        link = list->head.nxt;
+        lli_unlink_locked(list, link);
+    }
+    RWUNLOCK(list);
+
+    return link;
+}
+
+/**
+ * @function lli_find
+ *
+ * @param list - the list
+ * @param comparator - see `ll_find()`, called with links
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns the link of the first struct matching `ref_value`, `NULL` if none
+ */
+lli_link_t *lli_find(lli_t *list, comp_fun_t comparator, const void *ref_value) {
+    lli_link_t *link;
+
+    CHECK_VALID(list, l_read, NULL);
+    link = lli_search(list, comparator, ref_value);
+    RWUNLOCK(list);
+
+    return link;
+}
+
+/**
+ * @function lli_map
+ *
+ * Calls `f` on every link. `f` may alter the structs, so the list is write locked, like
+ * `ll_t` lists in `LL_LOCK_LIST` mode.
+ *
+ * @param list - the list
+ * @param f - the function to call on the links
+ */
+void lli_map(lli_t *list, gen_fun_t f) {
+    lli_link_t *link;
+
+    CHECK_VALID(list, l_write, );
+    for (link = list->head.nxt; link != &list->head; link = link->nxt)
+        f(link);
+    RWUNLOCK(list);
+}
+
+#ifdef LL
+/* this following code is just for testing this library */
+
+#include <pthread.h>
+
+#define TEST_THREADS 4
+#define TEST_ITEMS 20000
+
+static int test_count = 1;
+static int fail_count = 0;
+
+static void expect_int(int expected, int got) {
+    if (expected != got) {
+        fprintf(stderr, "FAIL Test %d: Expected %d, but got %d.\n", test_count, expected, got);
+        fail_count++;
+    } else
+        fprintf(stderr, "PASS Test %d!\n", test_count);
+    test_count++;
+}
+
+// what the tests put in the lists
+typedef struct {
+    int key;
+    lli_link_t link;
+    int torn;
+} item_t;
+
+#define ITEM(l) lli_entry(l, item_t, link)
+
+void item_teardown(void *link) {
+    ITEM(link)->torn++;
+}
+
+int item_equals(const void *link, const void *ref) {
+    return ITEM(link)->key - *(const int *)ref;
+}
+
+void item_increment(void *link) {
+    ITEM(link)->key++;
+}
+
+static lli_t *shared;
+static item_t shared_items[TEST_THREADS][TEST_ITEMS];
+
+// pushes its items and pops as many, whatever they are
+void *churner(void *arg) {
+    item_t *items = (item_t *)arg;
+    int i, popped = 0;
+
+    for (i = 0; i < TEST_ITEMS; i++) {
+        lli_insert_last(shared, &items[i].link);
+        popped += lli_pop_first(shared) != NULL;
+    }
+
+    return (void *)(long)popped;
+}
+
+static item_t contended;
+
+// links the one contended item, which only one thread may win
+void *racer(void *arg) {
+    int i, linked = 0;
+
+    for (i = 0; i < TEST_ITEMS; i++)
+        linked += (arg ? lli_insert_last(shared, &contended.link)
+                       : lli_insert_first(shared, &contended.link)) != -1;
+
+    return (void *)(long)linked;
+}
+
+int main() {
+    item_t items[8] = {{0}};
+    int i, key, in_order = 0, torn = 0;
+
+    lli_t *list = lli_new(item_teardown, LL_BACKEND_RWLOCK);
+    for (i = 0; i < 8; i++)
+        items[i].key = i;
+    expect_int(1, lli_insert_last(list, &items[4].link));      // (4)
+    expect_int(2, lli_insert_first(list, &items[0].link));     // (0 4)
+    expect_int(3, lli_insert_n(list, &items[2].link, 1));      // (0 2 4)
+    expect_int(4, lli_insert_n(list, &items[3].link, 2));      // (0 2 3 4)
+    expect_int(5, lli_insert_n(list, &items[1].link, 1));      // (0 1 2 3 4)
+    expect_int(6, lli_insert_n(list, &items[5].link, 5));      // (0 1 2 3 4 5), at the end
+    expect_int(-1, lli_insert_n(list, &items[6].link, 8));     // out of range
+    expect_int(-1, lli_insert_last(list, &items[5].link));     // already linked
+    for (i = 0; i < 6; i++)
+        in_order += ITEM(lli_get_n(list, i))->key == i;       // from both ends
+    expect_int(6, in_order);
+    expect_int(1, lli_get_n(list, 6) == NULL);
+
+    key = 3;
+    expect_int(1, lli_find(list, item_equals, &key) == &items[3].link);
+    expect_int(5, lli_unlink(list, &items[2].link));           // (0 1 3 4 5)
+    expect_int(-1, lli_unlink(list, &items[2].link));          // not linked anymore
+    expect_int(0, items[2].torn);
+    expect_int(4, lli_remove_find(list, item_equals, &key));   // (0 1 4 5)
+    expect_int(1, items[3].torn);
+    expect_int(3, lli_remove_n(list, 3));                      // (0 1 4)
+    expect_int(1, items[5].torn);
+    expect_int(-1, lli_remove_n(list, 3));
+    expect_int(1, lli_pop_first(list) == &items[0].link);      // (1 4)
+    expect_int(3, lli_insert_last(list, &items[0].link));      // (1 4 0), popped links are free
+    lli_map(list, item_increment);                             // (2 5 1)
+    expect_int(5, ITEM(lli_get_n(list, 1))->key);
+    expect_int(3, lli_length(list));
+    lli_clear(list);
+    for (i = 0; i < 8; i++)
+        torn += items[i].torn;
+    expect_int(5, torn);                                       // 3 removed, 2 cleared
+    expect_int(-1, lli_length(list));
+    expect_int(-1, lli_insert_last(list, &items[6].link));     // invalid list
+    expect_int(1, lli_pop_first(list) == NULL);
+    lli_delete(list);
+    expect_int(1, lli_new(item_teardown, 3) == NULL);          // unknown backend
+
+    // threads pushing and popping at once: every push is followed by a pop
+    pthread_t threads[TEST_THREADS];
+    int popped = 0;
+    void *ret;
+
+    shared = lli_new(item_teardown, LL_BACKEND_FUTEX);
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_create(&threads[i], NULL, churner, shared_items[i]);
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i], &ret);
+        popped += (int)(long)ret;
+    }
+    expect_int(TEST_THREADS * TEST_ITEMS, popped);
+    expect_int(0, lli_length(shared));
+
+    // threads linking the same item at once: it ends up linked exactly once
+    int linked = 0;
+
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_create(&threads[i], NULL, racer, (void *)(long)(i % 2));
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i], &ret);
+        linked += (int)(long)ret;
+    }
+    expect_int(1, linked);
+    expect_int(1, lli_length(shared));
+    expect_int(1, lli_pop_first(shared) == &contended.link);
+    lli_delete(shared);
+
+    if (fail_count) {
+        fprintf(stderr, "FAILED %d tests of %d.\n", fail_count, test_count);
+        return fail_count;
+    }
+
+    fprintf(stderr, "PASSED all %d tests!\n", test_count);
+}
+#endif
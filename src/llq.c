@@ -0,0 +1,584 @@
+/**
+ * Lock-free FIFO queue for C.
+ *
+ * See `../README.md` and `main()` in this file for usage.
+ *
+ * @file llq.c implements the queue outlined in `llq.h`: a Michael & Scott queue (a singly
+ * linked list that always starts with a dummy node) whose head and tail are only ever
+ * moved with compare-and-swap. A popped node can still be read by threads that loaded it
+ * before it was unlinked, so it is not freed right away but retired, and freed once no
+ * thread advertises it in its hazard pointers anymore.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "llq.h"
+
+/* macros */
+
+// number of hazard pointers a thread needs: pop protects the head and its successor
+#define LLQ_HP_PER_THREAD 2
+
+// retired nodes a thread accumulates before trying to free them, on top of twice the
+// number of hazard pointers (which guarantees each scan frees at least half of them)
+#define LLQ_RETIRE_SLACK 32
+
+// keeps the head and the tail of a queue on their own cache lines
+#define LLQ_CACHE_LINE 64
+
+/* type definitions */
+
+typedef struct llq_node llq_node_t;
+
+typedef struct llq_hp_rec llq_hp_rec_t;
+
+// llq_node models a queue node
+struct llq_node {
+    // pointer to the next node
+    _Atomic(llq_node_t *) nxt;
+
+    // pointer to the value at the node
+    void *val;
+
+    // chains the node in the retired list of a thread once popped
+    llq_node_t *retired_nxt;
+};
+
+// llq models a lock-free queue
+struct llq {
+    // the dummy node, the first value is in its successor
+    _Alignas(LLQ_CACHE_LINE) _Atomic(llq_node_t *) hd;
+
+    // the last node (or lagging one node behind it)
+    _Alignas(LLQ_CACHE_LINE) _Atomic(llq_node_t *) tl;
+
+    // running length
+    _Alignas(LLQ_CACHE_LINE) atomic_int len;
+
+    // a function that is called on the values left when the queue is deleted
+    gen_fun_t val_teardown;
+};
+
+// llq_hp_rec holds the hazard pointers of one thread. records are never freed: when
+// a thread exits its record is released and later adopted by another thread, along with
+// the nodes it had retired.
+struct llq_hp_rec {
+    // nodes this thread may dereference, which nobody must free
+    _Atomic(llq_node_t *) hp[LLQ_HP_PER_THREAD];
+
+    // 1 while a thread owns the record
+    atomic_int active;
+
+    // next record, set once before the record is published
+    llq_hp_rec_t *nxt;
+
+    // nodes removed by the owner that are waiting to be freed (only the owner uses these)
+    llq_node_t *retired;
+    int nretired;
+};
+
+/* hazard pointers domain, shared by all the queues */
+
+static _Atomic(llq_hp_rec_t *) llq_hp_head = NULL;
+static atomic_int llq_hp_count = 0;
+
+static _Thread_local llq_hp_rec_t *llq_hp_mine = NULL;
+
+static pthread_key_t llq_hp_key;
+static pthread_once_t llq_hp_once = PTHREAD_ONCE_INIT;
+
+static void llq_hp_scan(llq_hp_rec_t *rec);
+
+/**
+ * @function llq_hp_release
+ *
+ * Thread exit destructor: frees what can be freed and gives the record back.
+ *
+ * @param arg - the record of the exiting thread
+ */
+static void llq_hp_release(void *arg) {
+    llq_hp_rec_t *rec = (llq_hp_rec_t *)arg;
+    int i;
+
+    for (i = 0; i < LLQ_HP_PER_THREAD; i++)
+        atomic_store(&rec->hp[i], NULL);
+    llq_hp_scan(rec);
+    atomic_store(&rec->active, 0);
+}
+
+static void llq_hp_key_init(void) {
+    pthread_key_create(&llq_hp_key, llq_hp_release);
+}
+
+/**
+ * @function llq_hp_rec
+ *
+ * Returns the record of the calling thread, adopting a released one or allocating a new
+ * one the first time the thread uses a queue.
+ *
+ * @returns the hazard pointers record of the thread, `NULL` if out of memory
+ */
+static llq_hp_rec_t *llq_hp_rec(void) {
+    llq_hp_rec_t *rec = llq_hp_mine;
+    int i;
+
+    if (rec != NULL)
+        return rec;
+
+    pthread_once(&llq_hp_once, llq_hp_key_init);
+    for (rec = atomic_load(&llq_hp_head); rec != NULL; rec = rec->nxt) {
+        int inactive = 0;
+        if (atomic_load(&rec->active) == 0 &&
+            atomic_compare_exchange_strong(&rec->active, &inactive, 1))
+            break;
+    }
+
+    if (rec == NULL) {
+        rec = (llq_hp_rec_t *)malloc(sizeof(llq_hp_rec_t));
+        if (rec == NULL)
+            return NULL;
+        for (i = 0; i < LLQ_HP_PER_THREAD; i++)
+            atomic_init(&rec->hp[i], NULL);
+        atomic_init(&rec->active, 1);
+        rec->retired = NULL;
+        rec->nretired = 0;
+
+        llq_hp_rec_t *head = atomic_load(&llq_hp_head);
+        do {
+            rec->nxt = head;
+        } while (!atomic_compare_exchange_weak(&llq_hp_head, &head, rec));
+        atomic_fetch_add(&llq_hp_count, LLQ_HP_PER_THREAD);
+    }
+
+    llq_hp_mine = rec;
+    pthread_setspecific(llq_hp_key, rec);
+
+    return rec;
+}
+
+static int llq_ptr_cmp(const void *a, const void *b) {
+    const llq_node_t *x = *(llq_node_t *const *)a;
+    const llq_node_t *y = *(llq_node_t *const *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @function llq_hp_scan
+ *
+ * Frees the nodes retired by `rec` that no thread is protecting.
+ *
+ * @param rec - the record of the calling thread
+ */
+static void llq_hp_scan(llq_hp_rec_t *rec) {
+    int size = atomic_load(&llq_hp_count);
+    int n = 0;
+    llq_node_t **hazards = (llq_node_t **)malloc(size * sizeof(llq_node_t *));
+    llq_hp_rec_t *r;
+    int i;
+
+    if (hazards == NULL)
+        return; // try again on the next retirement
+
+    for (r = atomic_load(&llq_hp_head); r != NULL; r = r->nxt) {
+        for (i = 0; i < LLQ_HP_PER_THREAD; i++) {
+            llq_node_t *hp = atomic_load(&r->hp[i]);
+            if (hp == NULL)
+                continue;
+            if (n == size) { // records were added since `size` was read
+                llq_node_t **more = (llq_node_t **)realloc(hazards,
+                                                           2 * size * sizeof(llq_node_t *));
+                if (more == NULL) {
+                    free(hazards);
+                    return;
+                }
+                hazards = more;
+                size *= 2;
+            }
+            hazards[n++] = hp;
+        }
+    }
+    qsort(hazards, n, sizeof(llq_node_t *), llq_ptr_cmp);
+
+    llq_node_t *node = rec->retired;
+    rec->retired = NULL;
+    rec->nretired = 0;
+    while (node != NULL) {
+        llq_node_t *next = node->retired_nxt;
+        if (bsearch(&node, hazards, n, sizeof(llq_node_t *), llq_ptr_cmp) != NULL) {
+            node->retired_nxt = rec->retired;
+            rec->retired = node;
+            rec->nretired++;
+        } else {
+            free(node);
+        }
+        node = next;
+    }
+    free(hazards);
+}
+
+/**
+ * @function llq_hp_retire
+ *
+ * Defers freeing a node that was unlinked from a queue.
+ *
+ * @param rec - the record of the calling thread
+ * @param node - the unlinked node
+ */
+static void llq_hp_retire(llq_hp_rec_t *rec, llq_node_t *node) {
+    node->retired_nxt = rec->retired;
+    rec->retired = node;
+    rec->nretired++;
+    if (rec->nretired >= 2 * atomic_load(&llq_hp_count) + LLQ_RETIRE_SLACK)
+        llq_hp_scan(rec);
+}
+
+/**
+ * @function llq_new_node
+ *
+ * Makes a new node with the given value.
+ *
+ * @param val - a pointer to the value
+ *
+ * @returns a pointer to the new node, `NULL` if out of memory
+ */
+static llq_node_t *llq_new_node(void *val) {
+    llq_node_t *node = (llq_node_t *)malloc(sizeof(llq_node_t));
+    if (node == NULL)
+        return NULL;
+    atomic_init(&node->nxt, NULL);
+    node->val = val;
+    node->retired_nxt = NULL;
+
+    return node;
+}
+
+/**
+ * @function llq_new
+ *
+ * Allocates a new queue and its dummy node.
+ *
+ * @param val_teardown - called on the values still queued when the queue is deleted
+ *
+ * @returns a pointer to a new queue, `NULL` if out of memory
+ */
+llq_t *llq_new(gen_fun_t val_teardown) {
+    llq_t *q;
+    llq_node_t *dummy = llq_new_node(NULL);
+
+    if (dummy == NULL)
+        return NULL;
+    if (posix_memalign((void **)&q, LLQ_CACHE_LINE, sizeof(llq_t))) {
+        free(dummy);
+        return NULL;
+    }
+    atomic_init(&q->hd, dummy);
+    atomic_init(&q->tl, dummy);
+    atomic_init(&q->len, 0);
+    q->val_teardown = val_teardown;
+
+    return q;
+}
+
+/**
+ * @function llq_delete
+ *
+ * Tears down the values left in the queue and deallocates it. Nodes popped earlier by
+ * other threads are freed by them. The ones the calling thread retired, and those left in
+ * the records of exited threads, are freed here unless still protected: the main thread
+ * never runs the destructor of its record.
+ *
+ * @param q - the queue
+ */
+void llq_delete(llq_t *q) {
+    llq_node_t *node = atomic_load(&q->hd);
+    llq_hp_rec_t *rec;
+
+    if (llq_hp_mine != NULL)
+        llq_hp_scan(llq_hp_mine);
+    for (rec = atomic_load(&llq_hp_head); rec != NULL; rec = rec->nxt) {
+        int inactive = 0;
+        if (atomic_load(&rec->active) == 0 &&
+            atomic_compare_exchange_strong(&rec->active, &inactive, 1)) {
+            if (rec->nretired > 0)
+                llq_hp_scan(rec);
+            atomic_store(&rec->active, 0);
+        }
+    }
+
+    // the dummy node holds no value
+    llq_node_t *next = atomic_load(&node->nxt);
+    free(node);
+    while (next != NULL) {
+        node = next;
+        next = atomic_load(&node->nxt);
+        q->val_teardown(node->val);
+        free(node);
+    }
+    free(q);
+}
+
+/**
+ * @function llq_length
+ *
+ * @param q - the queue
+ *
+ * @returns the number of values in the queue, which may already be stale when it returns
+ */
+int llq_length(llq_t *q) {
+    int len = atomic_load_explicit(&q->len, memory_order_relaxed);
+
+    // a pop can be accounted for before the insertion it raced with
+    return len < 0 ? 0 : len;
+}
+
+/**
+ * @function llq_insert_last
+ *
+ * Links a new node after the last one, then swings the tail to it (any thread seeing the
+ * tail lagging behind helps moving it forward).
+ *
+ * @param q - the queue
+ * @param val - a pointer to the value
+ *
+ * @returns the length of the queue right after the insertion, -1 if out of memory
+ */
+int llq_insert_last(llq_t *q, void *val) {
+    llq_hp_rec_t *rec = llq_hp_rec();
+    llq_node_t *node = llq_new_node(val);
+    llq_node_t *tail;
+
+    if (rec == NULL || node == NULL) {
+        free(node);
+        return -1;
+    }
+
+    for (;;) {
+        tail = atomic_load(&q->tl);
+        atomic_store(&rec->hp[0], tail);
+        if (tail != atomic_load(&q->tl))
+            continue;
+
+        llq_node_t *next = atomic_load(&tail->nxt);
+        if (tail != atomic_load(&q->tl))
+            continue;
+        if (next != NULL) { // tail is lagging
+            atomic_compare_exchange_weak(&q->tl, &tail, next);
+            continue;
+        }
+
+        llq_node_t *expected = NULL;
+        if (atomic_compare_exchange_weak(&tail->nxt, &expected, node))
+            break;
+    }
+    atomic_compare_exchange_strong(&q->tl, &tail, node);
+    atomic_store_explicit(&rec->hp[0], NULL, memory_order_release);
+
+    return atomic_fetch_add(&q->len, 1) + 1;
+}
+
+/**
+ * @function llq_pop_first
+ *
+ * Moves the head to its successor, which becomes the new dummy node, and hands out the
+ * value it held. The old dummy node is retired.
+ * NOTE : the caller takes the owner ship of the pointer
+ *        (and thus, needs to call the teardown function on it)
+ *
+ * @param q - the queue
+ *
+ * @returns pointer to data or NULL
+ */
+void *llq_pop_first(llq_t *q) {
+    llq_hp_rec_t *rec = llq_hp_rec();
+    llq_node_t *head;
+    void *val;
+
+    if (rec == NULL)
+        return NULL;
+
+    for (;;) {
+        head = atomic_load(&q->hd);
+        atomic_store(&rec->hp[0], head);
+        if (head != atomic_load(&q->hd))
+            continue;
+
+        llq_node_t *tail = atomic_load(&q->tl);
+        llq_node_t *next = atomic_load(&head->nxt);
+        // `next` can't be retired before the head moves past it
+        atomic_store(&rec->hp[1], next);
+        if (head != atomic_load(&q->hd))
+            continue;
+
+        if (next == NULL) { // empty
+            atomic_store_explicit(&rec->hp[0], NULL, memory_order_release);
+            atomic_store_explicit(&rec->hp[1], NULL, memory_order_release);
+            return NULL;
+        }
+        if (head == tail) { // tail is lagging, don't let it point to a retired node
+            atomic_compare_exchange_weak(&q->tl, &tail, next);
+            continue;
+        }
+
+        val = next->val;
+        if (atomic_compare_exchange_weak(&q->hd, &head, next))
+            break;
+    }
+    atomic_fetch_sub(&q->len, 1);
+    atomic_store_explicit(&rec->hp[0], NULL, memory_order_release);
+    atomic_store_explicit(&rec->hp[1], NULL, memory_order_release);
+    llq_hp_retire(rec, head);
+
+    return val;
+}
+
+
+#ifdef LL
+/* this following code is just for testing this library */
+
+#define TEST_THREADS 4
+#define TEST_ITEMS 100000
+
+static int test_count = 1;
+static int fail_count = 0;
+
+static void expect_int(int expected, int got) {
+    if (expected != got) {
+        fprintf(stderr, "FAIL Test %d: Expected %d, but got %d.\n", test_count, expected, got);
+        fail_count++;
+    } else
+        fprintf(stderr, "PASS Test %d!\n", test_count);
+    test_count++;
+}
+
+static atomic_int torn_down = 0;
+
+void count_teardown(void *n) {
+    (void)n;
+    atomic_fetch_add(&torn_down, 1);
+}
+
+static llq_t *shared;
+static atomic_long popped_sum = 0;
+static atomic_int popped_count = 0;
+static int items[TEST_THREADS][TEST_ITEMS];
+
+void *producer(void *arg) {
+    int *base = (int *)arg;
+    int i;
+
+    for (i = 0; i < TEST_ITEMS; i++)
+        llq_insert_last(shared, &base[i]);
+
+    return NULL;
+}
+
+void *consumer(void *arg) {
+    int *last_seen = (int *)arg; // per producer, values of a producer must come in order
+    int done = 0;
+
+    while (atomic_load(&popped_count) < TEST_THREADS * TEST_ITEMS) {
+        int *n = (int *)llq_pop_first(shared);
+        if (n == NULL)
+            continue;
+        int producer = *n / TEST_ITEMS;
+        if (*n <= last_seen[producer])
+            done = -1; // out of order
+        last_seen[producer] = *n;
+        atomic_fetch_add(&popped_sum, *n);
+        atomic_fetch_add(&popped_count, 1);
+    }
+    last_seen[TEST_THREADS] = done;
+
+    return NULL;
+}
+
+int main() {
+    int v[3] = {0, 1, 2};
+    llq_hp_rec_t *rec;
+    int i, j;
+
+    llq_t *q = llq_new(count_teardown);
+    expect_int(1, llq_insert_last(q, &v[0]));
+    expect_int(2, llq_insert_last(q, &v[1]));
+    expect_int(3, llq_insert_last(q, &v[2]));
+    expect_int(0, *(int *)llq_pop_first(q));
+    expect_int(1, *(int *)llq_pop_first(q));
+    expect_int(1, llq_length(q));
+    expect_int(2, *(int *)llq_pop_first(q));
+    expect_int(1, llq_pop_first(q) == NULL);
+    llq_insert_last(q, &v[0]);
+    llq_insert_last(q, &v[1]);
+    expect_int(1, llq_hp_mine->nretired > 0);  // the nodes popped so far...
+    llq_delete(q);
+    expect_int(2, atomic_load(&torn_down));   // values left in the queue are torn down
+    expect_int(0, llq_hp_mine->nretired);     // ...are freed with the queue
+
+    // producers and consumers hammering the same queue: every value comes out once, and
+    // the values of a given producer come out in order
+    pthread_t prod[TEST_THREADS];
+    pthread_t cons[TEST_THREADS];
+    int last_seen[TEST_THREADS][TEST_THREADS + 1];
+    long expected_sum = 0;
+
+    shared = llq_new(count_teardown);
+    for (i = 0; i < TEST_THREADS; i++) {
+        for (j = 0; j < TEST_ITEMS; j++) {
+            items[i][j] = i * TEST_ITEMS + j;
+            expected_sum += items[i][j];
+        }
+        for (j = 0; j < TEST_THREADS; j++)
+            last_seen[i][j] = -1;
+    }
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_create(&cons[i], NULL, consumer, last_seen[i]);
+        pthread_create(&prod[i], NULL, producer, items[i]);
+    }
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_join(prod[i], NULL);
+        pthread_join(cons[i], NULL);
+    }
+    expect_int(TEST_THREADS * TEST_ITEMS, atomic_load(&popped_count));
+    expect_int(1, atomic_load(&popped_sum) == expected_sum);
+    for (i = 0; i < TEST_THREADS; i++)
+        expect_int(0, last_seen[i][TEST_THREADS]);
+    expect_int(0, llq_length(shared));
+    llq_delete(shared);
+    for (rec = atomic_load(&llq_hp_head); rec != NULL; rec = rec->nxt)
+        expect_int(0, rec->nretired);         // exited threads left nothing behind
+
+    if (fail_count) {
+        fprintf(stderr, "FAILED %d tests of %d.\n", fail_count, test_count);
+        return fail_count;
+    }
+
+    fprintf(stderr, "PASSED all %d tests!\n", test_count);
+}
+#endif
@@ -0,0 +1,463 @@
+/**
+ * Sharded collection for C.
+ *
+ * See `../README.md` and `main()` in this file for usage.
+ *
+ * @file lls.c implements the collection outlined in `lls.h`. Each shard is a full `ll_t`
+ * with its own lock. Threads are handed a slot number the first time they insert, and
+ * stick to the shard of that slot, so that as long as there are no more inserting threads
+ * than shards, no two of them fight over a lock (nor over the cache line it sits in).
+ * Operations that need the whole collection (`lls_length()`, `lls_map()`, ...) visit the
+ * shards one after the other.
+ *
+ * @author r-medina
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015 r-medina
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "ll_numa.h"
+#include "lls.h"
+
+/* type definitions */
+
+// lls models the collection
+struct lls {
+    // the lists
+    ll_t **shards;
+    int nshards;
+
+    // picks the shard of a value, `NULL` to use the slot of the inserting thread
+    hash_fun_t hash;
+
+    // the NUMA nodes the shards are spread over, shard `i` being on the `i % nnodes`th
+    // online node (see `ll_numa_node_at()`)
+    int nnodes;
+};
+
+/* globals */
+
+// slot of the calling thread, -1 until it first needs one
+static _Thread_local int lls_slot = -1;
+
+// next slot to hand out
+static atomic_int lls_next_slot = 0;
+
+/* static functions */
+
+/**
+ * @function lls_local_shards
+ *
+ * @param s - the collection
+ * @param node - the position of a NUMA node among the online ones (see `ll_numa_index()`)
+ *
+ * @returns the number of shards on `node`
+ */
+static int lls_local_shards(lls_t *s, int node) {
+    if (node < 0 || node >= s->nnodes || node >= s->nshards)
+        return 0;
+
+    return (s->nshards - node + s->nnodes - 1) / s->nnodes;
+}
+
+/**
+ * @function lls_home
+ *
+ * Threads are spread over the shards of the NUMA node they run on, and over all of them
+ * when that node has none.
+ *
+ * @param s - the collection
+ *
+ * @returns the shard of the calling thread
+ */
+static int lls_home(lls_t *s) {
+    if (lls_slot < 0)
+        lls_slot = atomic_fetch_add(&lls_next_slot, 1) & 0x7fffffff;
+
+    int node = s->nnodes > 1 ? ll_numa_index(ll_numa_node()) : 0;
+    int local = lls_local_shards(s, node);
+    if (local == 0)
+        return lls_slot % s->nshards;
+
+    return node + s->nnodes * (lls_slot % local);
+}
+
+/**
+ * @function lls_shard_of
+ *
+ * @param s - the collection
+ * @param val - a value
+ *
+ * @returns the only shard `val` can be in (the hash is required), -1 without a hash
+ */
+static int lls_shard_of(lls_t *s, const void *val) {
+    if (s->hash == NULL)
+        return -1;
+
+    return (int)(s->hash(val) % (size_t)s->nshards);
+}
+
+/* interface */
+
+/**
+ * @function lls_new
+ *
+ * Allocates a collection and all of its shards. On NUMA machines, the shards are placed
+ * on the nodes in turn (unless `opts` places them all on one).
+ *
+ * @param opts - the options of every shard, see `ll_new_ex()`
+ * @param nshards - the number of shards, `<= 0` for one per online cpu
+ * @param hash - chooses the shard of the values, `NULL` to use the inserting thread's
+ *
+ * @returns a pointer to the new collection, `NULL` on failure
+ */
+lls_t *lls_new(const ll_opts_t *opts, int nshards, hash_fun_t hash) {
+    int i;
+
+    if (nshards <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nshards = cpus > 0 ? (int)cpus : 1;
+    }
+
+    lls_t *s = (lls_t *)malloc(sizeof(lls_t));
+    if (s == NULL)
+        return NULL;
+    s->shards = (ll_t **)calloc((size_t)nshards, sizeof(ll_t *));
+    if (s->shards == NULL) {
+        free(s);
+        return NULL;
+    }
+    s->nshards = nshards;
+    s->hash = hash;
+    s->nnodes = opts->numa_bind ? 1 : ll_numa_nodes();
+    ll_opts_t shard_opts = *opts;
+    for (i = 0; i < nshards; i++) {
+        if (s->nnodes > 1) {
+            shard_opts.numa_bind = 1;
+            shard_opts.numa_node = ll_numa_node_at(i % s->nnodes);
+        }
+        s->shards[i] = ll_new_ex(&shard_opts);
+        if (s->shards[i] == NULL) {
+            lls_delete(s);
+            return NULL;
+        }
+    }
+
+    return s;
+}
+
+/**
+ * @function lls_delete
+ *
+ * Deletes every shard, then the collection itself.
+ *
+ * @param s - the collection
+ */
+void lls_delete(lls_t *s) {
+    int i;
+
+    for (i = 0; i < s->nshards; i++) {
+        if (s->shards[i] != NULL)
+            ll_delete(s->shards[i]);
+    }
+    free(s->shards);
+    free(s);
+}
+
+/**
+ * @function lls_shards
+ *
+ * @param s - the collection
+ *
+ * @returns the number of shards
+ */
+int lls_shards(lls_t *s) {
+    return s->nshards;
+}
+
+/**
+ * @function lls_length
+ *
+ * Adds up the lengths of the shards, which other threads may change in the meantime.
+ *
+ * @param s - the collection
+ *
+ * @returns the number of values, -1 if a shard is invalid
+ */
+int lls_length(lls_t *s) {
+    int len = 0;
+    int i;
+
+    for (i = 0; i < s->nshards; i++) {
+        int n = ll_length(s->shards[i]);
+        if (n < 0)
+            return -1;
+        len += n;
+    }
+
+    return len;
+}
+
+/**
+ * @function lls_insert
+ *
+ * Appends the value to its shard, which is on the NUMA node of the calling thread unless
+ * the collection has a hash.
+ *
+ * @param s - the collection
+ * @param val - a pointer to the value
+ *
+ * @returns 0 if successful, -1 otherwise
+ */
+int lls_insert(lls_t *s, void *val) {
+    int shard = s->hash != NULL ? lls_shard_of(s, val) : lls_home(s);
+
+    return ll_insert_last(s->shards[shard], val) < 0 ? -1 : 0;
+}
+
+/**
+ * @function lls_pop
+ *
+ * Pops the first value of the shard of the calling thread, or of the following shards
+ * when it is empty: those on the same NUMA node first, then the others.
+ *
+ * @param s - the collection
+ *
+ * @returns pointer to data or NULL
+ */
+void *lls_pop(lls_t *s) {
+    int home = lls_home(s);
+    int node = home % s->nnodes;
+    int local = lls_local_shards(s, node);
+    void *val;
+    int i;
+
+    for (i = 0; i < local; i++) {
+        val = ll_pop_first(s->shards[node + s->nnodes * ((home / s->nnodes + i) % local)]);
+        if (val != NULL)
+            return val;
+    }
+    for (i = 1; i < s->nshards; i++) {
+        int shard = (home + i) % s->nshards;
+        if (shard % s->nnodes != node && (val = ll_pop_first(s->shards[shard])) != NULL)
+            return val;
+    }
+
+    return NULL;
+}
+
+/**
+ * @function lls_map
+ *
+ * Calls `ll_map()` on every shard.
+ *
+ * @param s - the collection
+ * @param f - the function to call on the values
+ */
+void lls_map(lls_t *s, gen_fun_t f) {
+    int i;
+
+    for (i = 0; i < s->nshards; i++)
+        ll_map(s->shards[i], f);
+}
+
+/**
+ * @function lls_find
+ *
+ * Looks for the value in its shard when there is a hash, in every shard otherwise.
+ *
+ * @param s - the collection
+ * @param comparator - see `ll_find()`
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns a pointer to the value found, `NULL` if none
+ */
+void *lls_find(lls_t *s, comp_fun_t comparator, const void *ref_value) {
+    int shard = lls_shard_of(s, ref_value);
+    int i;
+
+    if (shard >= 0)
+        return ll_find(s->shards[shard], comparator, ref_value);
+    for (i = 0; i < s->nshards; i++) {
+        void *val = ll_find(s->shards[i], comparator, ref_value);
+        if (val != NULL)
+            return val;
+    }
+
+    return NULL;
+}
+
+/**
+ * @function lls_remove_find
+ *
+ * Removes the value from its shard when there is a hash, from the first shard holding it
+ * otherwise.
+ *
+ * @param s - the collection
+ * @param comparator - see `ll_find()`
+ * @param ref_value - reference value passed to the comparator
+ *
+ * @returns 0 if a value was removed, -1 otherwise
+ */
+int lls_remove_find(lls_t *s, comp_fun_t comparator, const void *ref_value) {
+    int shard = lls_shard_of(s, ref_value);
+    int i;
+
+    if (shard >= 0)
+        return ll_remove_find(s->shards[shard], comparator, ref_value) < 0 ? -1 : 0;
+    for (i = 0; i < s->nshards; i++) {
+        if (ll_remove_find(s->shards[i], comparator, ref_value) >= 0)
+            return 0;
+    }
+
+    return -1;
+}
+
+#ifdef LL
+/* this following code is just for testing this library */
+
+#define TEST_THREADS 4
+#define TEST_ITEMS 100000
+
+static int test_count = 1;
+static int fail_count = 0;
+
+static void expect_int(int expected, int got) {
+    if (expected != got) {
+        fprintf(stderr, "FAIL Test %d: Expected %d, but got %d.\n", test_count, expected, got);
+        fail_count++;
+    } else
+        fprintf(stderr, "PASS Test %d!\n", test_count);
+    test_count++;
+}
+
+static atomic_int torn_down = 0;
+static atomic_int compared = 0;
+static atomic_long mapped_sum = 0;
+
+void count_teardown(void *n) {
+    (void)n;
+    atomic_fetch_add(&torn_down, 1);
+}
+
+int num_equals(const void *n, const void *ref) {
+    atomic_fetch_add(&compared, 1);
+    return *(const int *)n - *(const int *)ref;
+}
+
+size_t num_hash(const void *n) {
+    return (size_t)*(const int *)n;
+}
+
+void num_sum(void *n) {
+    atomic_fetch_add(&mapped_sum, *(int *)n);
+}
+
+static lls_t *shared;
+static int items[TEST_THREADS][TEST_ITEMS];
+
+void *inserter(void *arg) {
+    int *base = (int *)arg;
+    int i;
+
+    for (i = 0; i < TEST_ITEMS; i++)
+        lls_insert(shared, &base[i]);
+
+    return NULL;
+}
+
+int main() {
+    int v[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int i, j;
+    ll_opts_t opts = {0};
+    opts.val_teardown = count_teardown;
+
+    lls_t *s = lls_new(&opts, 3, num_hash);
+    expect_int(3, lls_shards(s));
+    for (i = 0; i < 8; i++)
+        expect_int(0, lls_insert(s, &v[i]));
+    expect_int(8, lls_length(s));
+    atomic_store(&compared, 0);
+    expect_int(5, *(int *)lls_find(s, num_equals, &v[5]));
+    expect_int(1, atomic_load(&compared) <= 3); // only the shard of 5 was searched
+    expect_int(0, lls_remove_find(s, num_equals, &v[5]));
+    expect_int(1, lls_find(s, num_equals, &v[5]) == NULL);
+    expect_int(-1, lls_remove_find(s, num_equals, &v[5]));
+    expect_int(1, atomic_load(&torn_down));
+    lls_map(s, num_sum);
+    expect_int(28 - 5, (int)atomic_load(&mapped_sum));
+    lls_delete(s);
+    expect_int(8, atomic_load(&torn_down));   // values left in the shards are torn down
+
+    // shards all placed on one NUMA node, which has to exist
+    opts.numa_bind = 1;
+    opts.numa_node = -1;
+    expect_int(1, lls_new(&opts, 2, NULL) == NULL);
+    opts.numa_node = ll_numa_node_at(0);
+    s = lls_new(&opts, 2, NULL);
+    expect_int(0, lls_insert(s, &v[3]));
+    expect_int(3, *(int *)lls_pop(s));
+    lls_delete(s);
+    opts.numa_bind = 0;
+
+    // threads inserting at once, each into its own shard: nothing is lost, and everything
+    // comes back out
+    pthread_t threads[TEST_THREADS];
+    long expected_sum = 0;
+    int popped = 0;
+
+    shared = lls_new(&opts, TEST_THREADS, NULL);
+    for (i = 0; i < TEST_THREADS; i++) {
+        for (j = 0; j < TEST_ITEMS; j++) {
+            items[i][j] = i * TEST_ITEMS + j;
+            expected_sum += items[i][j];
+        }
+    }
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_create(&threads[i], NULL, inserter, items[i]);
+    for (i = 0; i < TEST_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    expect_int(TEST_THREADS * TEST_ITEMS, lls_length(shared));
+    atomic_store(&mapped_sum, 0);
+    lls_map(shared, num_sum);
+    expect_int(1, atomic_load(&mapped_sum) == expected_sum);
+    expect_int(TEST_ITEMS - 1, *(int *)lls_find(shared, num_equals, &items[0][TEST_ITEMS - 1]));
+    while (lls_pop(shared) != NULL)
+        popped++;
+    expect_int(TEST_THREADS * TEST_ITEMS, popped);
+    expect_int(0, lls_length(shared));
+    lls_delete(shared);
+
+    if (fail_count) {
+        fprintf(stderr, "FAILED %d tests of %d.\n", fail_count, test_count);
+        return fail_count;
+    }
+
+    fprintf(stderr, "PASSED all %d tests!\n", test_count);
+}
+#endif